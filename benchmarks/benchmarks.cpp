@@ -12,6 +12,8 @@
 #include "tiny_dnn/tiny_dnn.h"
 
 #include "bm_global_avepool.h"
+#include "bm_layers.h"
+#include "bm_optimizers.h"
 using namespace tiny_dnn::benchmarks;
 
 BENCHMARK_MAIN();
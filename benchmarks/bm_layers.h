@@ -0,0 +1,266 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "bm_util.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+namespace benchmarks {
+
+using core::backend_t;
+
+const profile_phase fwd = profile_phase::forward;
+const profile_phase bwd = profile_phase::backward;
+
+// register bm for the engines built in, next to backend_t::internal
+#ifdef CNN_USE_AVX
+#define TINY_DNN_BM_AVX(bm, name, phase, shapes) \
+  BENCHMARK_CAPTURE(bm, name##_avx, phase, backend_t::avx)->Apply(shapes)
+#else
+#define TINY_DNN_BM_AVX(bm, name, phase, shapes)
+#endif
+
+#ifdef CNN_USE_NNPACK
+#define TINY_DNN_BM_NNPACK(bm, name, phase, shapes) \
+  BENCHMARK_CAPTURE(bm, name##_nnpack, phase, backend_t::nnpack)->Apply(shapes)
+#else
+#define TINY_DNN_BM_NNPACK(bm, name, phase, shapes)
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+// convolution: {width and height, in channels, window, out channels, batch}
+
+void conv_shapes(benchmark::internal::Benchmark *b) {
+  for (int batch : {1, 16}) {
+    b->Args({32, 3, 5, 32, batch});     // first layer of a small net
+    b->Args({28, 32, 3, 64, batch});    // middle of a vgg-like net
+    b->Args({14, 128, 3, 128, batch});  // deep, few pixels
+  }
+}
+
+void bm_conv(benchmark::State &state, profile_phase phase, backend_t engine) {
+  convolutional_layer l(state.range(0), state.range(0), state.range(2),
+                        state.range(1), state.range(3), padding::same, true,
+                        1, 1, engine);
+  run(state, l, phase, state.range(4));
+}
+
+BENCHMARK_CAPTURE(bm_conv, forward_internal, fwd, backend_t::internal)
+  ->Apply(conv_shapes);
+BENCHMARK_CAPTURE(bm_conv, forward_gemm, fwd, backend_t::gemm)
+  ->Apply(conv_shapes);
+TINY_DNN_BM_AVX(bm_conv, forward, fwd, conv_shapes);
+TINY_DNN_BM_NNPACK(bm_conv, forward, fwd, conv_shapes);
+BENCHMARK_CAPTURE(bm_conv, backward_internal, bwd, backend_t::internal)
+  ->Apply(conv_shapes);
+BENCHMARK_CAPTURE(bm_conv, backward_gemm, bwd, backend_t::gemm)
+  ->Apply(conv_shapes);
+TINY_DNN_BM_AVX(bm_conv, backward, bwd, conv_shapes);
+// no nnpack backward: nnpack only implements the forward pass
+
+/////////////////////////////////////////////////////////////////////////
+// deconvolution: {width and height, in channels, window, out channels, batch}
+
+void deconv_shapes(benchmark::internal::Benchmark *b) {
+  for (int batch : {1, 16}) {
+    b->Args({7, 128, 3, 64, batch});
+    b->Args({14, 64, 3, 32, batch});
+  }
+}
+
+void bm_deconv(benchmark::State &state, profile_phase phase, backend_t engine) {
+  deconvolutional_layer l(state.range(0), state.range(0), state.range(2),
+                          state.range(1), state.range(3), padding::valid,
+                          true, 1, 1, engine);
+  run(state, l, phase, state.range(4));
+}
+
+BENCHMARK_CAPTURE(bm_deconv, forward_internal, fwd, backend_t::internal)
+  ->Apply(deconv_shapes);
+TINY_DNN_BM_AVX(bm_deconv, forward, fwd, deconv_shapes);
+// no backward: the backends of deconvolutional_layer can't run it yet
+
+/////////////////////////////////////////////////////////////////////////
+// fully connected: {in, out, batch}
+
+void fc_shapes(benchmark::internal::Benchmark *b) {
+  for (int batch : {1, 32}) {
+    b->Args({784, 512, batch});    // mnist mlp
+    b->Args({4096, 1000, batch});  // classifier of an imagenet net
+    b->Args({512, 10, batch});     // output layer
+  }
+}
+
+void bm_fc(benchmark::State &state, profile_phase phase, backend_t engine) {
+  fully_connected_layer l(state.range(0), state.range(1), true, engine);
+  run(state, l, phase, state.range(2));
+}
+
+BENCHMARK_CAPTURE(bm_fc, forward_internal, fwd, backend_t::internal)
+  ->Apply(fc_shapes);
+BENCHMARK_CAPTURE(bm_fc, forward_gemm, fwd, backend_t::gemm)
+  ->Apply(fc_shapes);
+TINY_DNN_BM_AVX(bm_fc, forward, fwd, fc_shapes);
+TINY_DNN_BM_NNPACK(bm_fc, forward, fwd, fc_shapes);
+BENCHMARK_CAPTURE(bm_fc, backward_internal, bwd, backend_t::internal)
+  ->Apply(fc_shapes);
+BENCHMARK_CAPTURE(bm_fc, backward_gemm, bwd, backend_t::gemm)
+  ->Apply(fc_shapes);
+TINY_DNN_BM_AVX(bm_fc, backward, bwd, fc_shapes);
+// no nnpack backward: nnpack only implements the forward pass
+
+/////////////////////////////////////////////////////////////////////////
+// pooling: {width and height, channels, pool size, batch}
+
+void pool_shapes(benchmark::internal::Benchmark *b) {
+  for (int batch : {1, 16}) {
+    b->Args({28, 32, 2, batch});
+    b->Args({56, 64, 2, batch});
+  }
+}
+
+void bm_max_pool(benchmark::State &state,
+                 profile_phase phase,
+                 backend_t engine) {
+  max_pooling_layer l(state.range(0), state.range(0), state.range(1),
+                      state.range(2), engine);
+  run(state, l, phase, state.range(3));
+}
+
+void bm_ave_pool(benchmark::State &state, profile_phase phase) {
+  average_pooling_layer l(state.range(0), state.range(0), state.range(1),
+                          state.range(2));
+  run(state, l, phase, state.range(3));
+}
+
+BENCHMARK_CAPTURE(bm_max_pool, forward_internal, fwd, backend_t::internal)
+  ->Apply(pool_shapes);
+TINY_DNN_BM_AVX(bm_max_pool, forward, fwd, pool_shapes);
+BENCHMARK_CAPTURE(bm_max_pool, backward_internal, bwd, backend_t::internal)
+  ->Apply(pool_shapes);
+TINY_DNN_BM_AVX(bm_max_pool, backward, bwd, pool_shapes);
+BENCHMARK_CAPTURE(bm_ave_pool, forward, fwd)->Apply(pool_shapes);
+BENCHMARK_CAPTURE(bm_ave_pool, backward, bwd)->Apply(pool_shapes);
+
+/////////////////////////////////////////////////////////////////////////
+// normalization: {width and height, channels, batch}
+
+void norm_shapes(benchmark::internal::Benchmark *b) {
+  for (int batch : {1, 16}) {
+    b->Args({28, 32, batch});
+    b->Args({7, 256, batch});
+  }
+}
+
+void bm_batch_norm(benchmark::State &state, profile_phase phase) {
+  batch_normalization_layer l(state.range(0) * state.range(0),
+                              state.range(1));
+  l.set_context(net_phase::train);  // batch statistics are computed
+  run(state, l, phase, state.range(2));
+}
+
+void bm_lrn(benchmark::State &state, profile_phase phase) {
+  lrn_layer l(shape3d(state.range(0), state.range(0), state.range(1)), 5);
+  run(state, l, phase, state.range(2));
+}
+
+BENCHMARK_CAPTURE(bm_batch_norm, forward, fwd)->Apply(norm_shapes);
+BENCHMARK_CAPTURE(bm_batch_norm, backward, bwd)->Apply(norm_shapes);
+BENCHMARK_CAPTURE(bm_lrn, forward, fwd)->Apply(norm_shapes);
+// no backward: lrn_layer::back_propagation is not implemented
+
+/////////////////////////////////////////////////////////////////////////
+// activations: {size, batch}
+
+void activation_shapes(benchmark::internal::Benchmark *b) {
+  for (int batch : {1, 16}) {
+    b->Args({4096, batch});
+    b->Args({28 * 28 * 64, batch});
+  }
+}
+
+// softmax normalizes over the whole vector (its backward is quadratic), so
+// it runs on classifier outputs only
+void softmax_shapes(benchmark::internal::Benchmark *b) {
+  for (int batch : {1, 16}) {
+    b->Args({10, batch});
+    b->Args({1000, batch});
+  }
+}
+
+template <typename Activation>
+std::shared_ptr<layer> make_activation(serial_size_t size) {
+  return std::make_shared<Activation>(size);
+}
+
+void bm_activation(benchmark::State &state,
+                   profile_phase phase,
+                   std::shared_ptr<layer> (*make)(serial_size_t)) {
+  std::shared_ptr<layer> l = make(state.range(0));
+  run(state, *l, phase, state.range(1));
+}
+
+BENCHMARK_CAPTURE(bm_activation, relu_forward, fwd,
+                  make_activation<relu_layer>)
+  ->Apply(activation_shapes);
+BENCHMARK_CAPTURE(bm_activation, leaky_relu_forward, fwd,
+                  make_activation<leaky_relu_layer>)
+  ->Apply(activation_shapes);
+BENCHMARK_CAPTURE(bm_activation, elu_forward, fwd, make_activation<elu_layer>)
+  ->Apply(activation_shapes);
+BENCHMARK_CAPTURE(bm_activation, tanh_forward, fwd,
+                  make_activation<tanh_layer>)
+  ->Apply(activation_shapes);
+BENCHMARK_CAPTURE(bm_activation, sigmoid_forward, fwd,
+                  make_activation<sigmoid_layer>)
+  ->Apply(activation_shapes);
+BENCHMARK_CAPTURE(bm_activation, softmax_forward, fwd,
+                  make_activation<softmax_layer>)
+  ->Apply(softmax_shapes);
+BENCHMARK_CAPTURE(bm_activation, relu_backward, bwd,
+                  make_activation<relu_layer>)
+  ->Apply(activation_shapes);
+BENCHMARK_CAPTURE(bm_activation, tanh_backward, bwd,
+                  make_activation<tanh_layer>)
+  ->Apply(activation_shapes);
+BENCHMARK_CAPTURE(bm_activation, softmax_backward, bwd,
+                  make_activation<softmax_layer>)
+  ->Apply(softmax_shapes);
+
+/////////////////////////////////////////////////////////////////////////
+// quantized layers, same shapes as their float counterparts (conv without
+// padding, fc only when built with gemmlowp). forward only: the quantized
+// backends can't run backward yet
+
+void bm_quantized_conv(benchmark::State &state) {
+  quantized_convolutional_layer l(state.range(0), state.range(0),
+                                  state.range(2), state.range(1),
+                                  state.range(3), padding::valid);
+  run(state, l, fwd, state.range(4));
+}
+
+BENCHMARK(bm_quantized_conv)->Apply(conv_shapes);
+
+#ifdef CNN_USE_GEMMLOWP
+void bm_quantized_fc(benchmark::State &state) {
+  quantized_fully_connected_layer l(state.range(0), state.range(1));
+  run(state, l, fwd, state.range(2));
+}
+
+BENCHMARK(bm_quantized_fc)->Apply(fc_shapes);
+#endif
+
+#undef TINY_DNN_BM_AVX
+#undef TINY_DNN_BM_NNPACK
+
+}  // namespace benchmarks
+}  // namespace tiny_dnn
@@ -0,0 +1,67 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "bm_util.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+namespace benchmarks {
+
+// optimizer::update() of one weight vector: {size}
+
+void optimizer_shapes(benchmark::internal::Benchmark *b) {
+  b->Arg(10 * 1000);    // bias or small fc
+  b->Arg(400 * 1000);   // conv filters of a small net
+  b->Arg(4000 * 1000);  // classifier of an imagenet net
+}
+
+template <typename Optimizer>
+std::shared_ptr<optimizer> make_optimizer() {
+  return std::make_shared<Optimizer>();
+}
+
+/**
+ * @param flops  floating point operations for each weight
+ * @param floats floats read or written for each weight
+ **/
+void bm_optimizer(benchmark::State &state,
+                  std::shared_ptr<optimizer> (*make)(),
+                  int flops,
+                  int floats) {
+  const size_t size = state.range(0);
+  vec_t W(size), dW(size);
+  uniform_rand(W.begin(), W.end(), -1.0, 1.0);
+  uniform_rand(dW.begin(), dW.end(), -1.0, 1.0);
+
+  std::shared_ptr<optimizer> opt = make();
+  opt->update(dW, W, true);  // allocates the state of the optimizer
+
+  while (state.KeepRunning()) {
+    opt->update(dW, W, true);
+  }
+  set_rates(state, uint64_t(flops) * size,
+            uint64_t(floats) * size * sizeof(float_t));
+}
+
+BENCHMARK_CAPTURE(bm_optimizer, sgd, make_optimizer<gradient_descent>, 4, 3)
+  ->Apply(optimizer_shapes);
+BENCHMARK_CAPTURE(bm_optimizer, momentum, make_optimizer<momentum>, 6, 5)
+  ->Apply(optimizer_shapes);
+BENCHMARK_CAPTURE(bm_optimizer, adagrad, make_optimizer<adagrad>, 6, 5)
+  ->Apply(optimizer_shapes);
+BENCHMARK_CAPTURE(bm_optimizer, rmsprop, make_optimizer<RMSprop>, 9, 5)
+  ->Apply(optimizer_shapes);
+BENCHMARK_CAPTURE(bm_optimizer, adam, make_optimizer<adam>, 14, 7)
+  ->Apply(optimizer_shapes);
+
+}  // namespace benchmarks
+}  // namespace tiny_dnn
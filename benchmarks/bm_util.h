@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+namespace benchmarks {
+
+// report the work of one iteration as FLOP/s and bytes/s
+inline void set_rates(benchmark::State &state, uint64_t flops, uint64_t bytes) {
+  state.counters["FLOPS"] = benchmark::Counter(
+    double(flops) * double(state.iterations()), benchmark::Counter::kIsRate);
+  state.SetBytesProcessed(int64_t(bytes) * int64_t(state.iterations()));
+}
+
+inline void set_rates(benchmark::State &state,
+                      layer &l,
+                      profile_phase phase,
+                      size_t batch) {
+  const profiler::cost c = profiler::estimate(l, phase, batch);
+  set_rates(state, c.flops, c.bytes);
+}
+
+// batch random samples for each data input of l
+inline std::vector<tensor_t> random_inputs(layer &l, size_t batch) {
+  std::vector<tensor_t> in;
+  for (const auto &shape : l.in_data_shape()) {
+    in.emplace_back(batch, vec_t(shape.size()));
+    for (auto &v : in.back()) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  }
+  return in;
+}
+
+inline std::vector<tensor_t> random_out_grads(layer &l, size_t batch) {
+  std::vector<tensor_t> grads;
+  for (const auto &shape : l.out_data_shape()) {
+    grads.emplace_back(batch, vec_t(shape.size()));
+    for (auto &v : grads.back()) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  }
+  return grads;
+}
+
+// time layer::forward() of l on batch samples
+inline void run_forward(benchmark::State &state, layer &l, size_t batch) {
+  const std::vector<tensor_t> in = random_inputs(l, batch);
+  std::vector<const tensor_t *> out;
+  l.forward(in, out);  // allocates the outputs and the weights
+
+  while (state.KeepRunning()) {
+    l.forward();
+  }
+  set_rates(state, l, profile_phase::forward, batch);
+}
+
+// time layer::backward() of l on batch samples
+inline void run_backward(benchmark::State &state, layer &l, size_t batch) {
+  const std::vector<tensor_t> in = random_inputs(l, batch);
+  std::vector<const tensor_t *> out;
+  l.forward(in, out);
+  l.backward(random_out_grads(l, batch));
+
+  while (state.KeepRunning()) {
+    l.backward();
+  }
+  set_rates(state, l, profile_phase::backward, batch);
+}
+
+inline void run(benchmark::State &state,
+                layer &l,
+                profile_phase phase,
+                size_t batch) {
+  phase == profile_phase::forward ? run_forward(state, l, batch)
+                                  : run_backward(state, l, batch);
+}
+
+}  // namespace benchmarks
+}  // namespace tiny_dnn
@@ -0,0 +1,347 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2013, Taiga Nomi and the respective contributors
+# All rights reserved.
+#
+# Use of this source code is governed by a BSD-style license that can be found
+# in the LICENSE file.
+#
+"""Performance regression harness for tiny-dnn.
+
+Runs the kernel benchmarks (tiny_dnn_benchmarks) and optionally the model
+benchmarks (benchmarks_all) with repetitions, stores the samples as a JSON
+baseline, and compares a new run against a baseline. A benchmark regresses
+when its median time grew by more than the threshold and the bootstrap
+confidence interval of the ratio of medians lies entirely above 1, so noisy
+benchmarks don't fail the check.
+
+  # record a baseline
+  benchmarks/regression.py record \\
+      --kernels build/benchmarks/tiny_dnn_benchmarks \\
+      --models build/examples/benchmarks_all -o baseline.json
+  # after a change: run the same suite (the settings of the baseline are
+  # reused) and compare, exits 1 on regressions
+  benchmarks/regression.py check baseline.json \\
+      --kernels build/benchmarks/tiny_dnn_benchmarks \\
+      --models build/examples/benchmarks_all
+  # or compare two recorded runs
+  benchmarks/regression.py compare baseline.json new.json
+
+Only the Python 3 standard library is needed.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import random
+import socket
+import subprocess
+import sys
+import tempfile
+
+# version of the baseline file layout, bumped on incompatible changes
+FORMAT_VERSION = 1
+
+TIME_UNITS = {'ns': 1.0, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+
+# rows Google Benchmark appends after the repetitions of a benchmark; older
+# releases (e.g. v1.4.1) mark them only by these name suffixes
+AGGREGATE_SUFFIXES = ('_mean', '_median', '_stddev', '_cv')
+
+# how the suite is run; saved in the baseline, which check reuses unless
+# they are given on the command line
+DEFAULT_SETTINGS = {
+    'repetitions': 10,
+    'min_time': 0.1,
+    'filter': '.',
+    'model_list': 'lenet,vgg,resnet,mobilenet',
+    'batch_size': 16,
+    'iterations': 10,
+}
+
+
+def median(xs):
+    s = sorted(xs)
+    n = len(s)
+    if n == 0:
+        return float('nan')
+    if n % 2:
+        return s[n // 2]
+    return 0.5 * (s[n // 2 - 1] + s[n // 2])
+
+
+def ratio_interval(base, new, confidence, resamples=2000, seed=1):
+    """Bootstrap confidence interval of median(new) / median(base)."""
+    rng = random.Random(seed)
+    ratios = []
+    for _ in range(resamples):
+        b = median([rng.choice(base) for _ in base])
+        n = median([rng.choice(new) for _ in new])
+        ratios.append(n / b if b > 0 else float('inf'))
+    ratios.sort()
+    tail = (1.0 - confidence) / 2.0
+    lo = ratios[int(tail * (resamples - 1))]
+    hi = ratios[int((1.0 - tail) * (resamples - 1))]
+    return lo, hi
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(
+            ['git', 'rev-parse', '--short', 'HEAD'],
+            cwd=os.path.dirname(os.path.abspath(__file__)),
+            stderr=subprocess.DEVNULL).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ''
+
+
+def run_kernels(binary, repetitions, min_time, benchmark_filter):
+    """Samples of the Google Benchmark binary, in ns per iteration."""
+    with tempfile.NamedTemporaryFile(suffix='.json', delete=False) as f:
+        out = f.name
+    try:
+        subprocess.check_call([
+            binary,
+            '--benchmark_filter=' + benchmark_filter,
+            '--benchmark_repetitions=%d' % repetitions,
+            '--benchmark_min_time=%g' % min_time,
+            '--benchmark_out_format=json',
+            '--benchmark_out=' + out,
+        ], stdout=sys.stderr)
+        with open(out) as f:
+            report = json.load(f)
+    finally:
+        os.remove(out)
+
+    samples = {}
+    for b in report['benchmarks']:
+        # skip the mean/median/stddev rows of the repetitions
+        if b.get('run_type', 'iteration') != 'iteration':
+            continue
+        if 'aggregate_name' in b:
+            continue
+        if b['name'].endswith(AGGREGATE_SUFFIXES):
+            continue
+        name = b.get('run_name', b['name'])
+        t = b['real_time'] * TIME_UNITS[b.get('time_unit', 'ns')]
+        samples.setdefault(name, []).append(t)
+    return samples, report.get('context', {})
+
+
+def run_models(binary, repetitions, models, batch_size, iterations):
+    """Samples of the model benchmark driver, in ns.
+
+    Each repetition is a separate process, so one-off effects such as page
+    faults of the first allocations end up in the spread.
+    """
+    samples = {}
+    for _ in range(repetitions):
+        with tempfile.NamedTemporaryFile(suffix='.json', delete=False) as f:
+            out = f.name
+        try:
+            subprocess.check_call([
+                binary, '--models', models, '--batch_size', str(batch_size),
+                '--iterations', str(iterations), '--json', out
+            ], stdout=sys.stderr)
+            with open(out) as f:
+                report = json.load(f)
+        finally:
+            os.remove(out)
+        for m in report['models']:
+            name = 'model/' + m['name']
+            per_sample = 1e9 / m['samples_per_second']
+            for metric, ns in (('latency', m['latency_ms'] * 1e6),
+                               ('throughput_per_sample', per_sample),
+                               ('train_step', m['train_step_ms'] * 1e6)):
+                samples.setdefault(name + '/' + metric, []).append(ns)
+    return samples
+
+
+def record(args, defaults):
+    settings = {}
+    for key, value in defaults.items():
+        given = getattr(args, key)
+        settings[key] = value if given is None else given
+
+    samples = {}
+    context = {}
+    if args.kernels:
+        kernel_samples, context = run_kernels(
+            args.kernels, settings['repetitions'], settings['min_time'],
+            settings['filter'])
+        samples.update(kernel_samples)
+    if args.models:
+        samples.update(
+            run_models(args.models, settings['repetitions'],
+                       settings['model_list'], settings['batch_size'],
+                       settings['iterations']))
+    if not samples:
+        sys.exit('nothing to run: pass --kernels and/or --models')
+
+    return {
+        'format': FORMAT_VERSION,
+        'revision': git_revision(),
+        'date': datetime.datetime.now().isoformat(timespec='seconds'),
+        'host': socket.gethostname(),
+        'machine': platform.machine(),
+        'num_cpus': context.get('num_cpus', os.cpu_count()),
+        'mhz_per_cpu': context.get('mhz_per_cpu'),
+        'library_build_type': context.get('library_build_type'),
+        'settings': settings,
+        'unit': 'ns',
+        'benchmarks': samples,
+    }
+
+
+def load(path):
+    with open(path) as f:
+        results = json.load(f)
+    if results.get('format') != FORMAT_VERSION:
+        sys.exit('%s: unsupported baseline format %r (expected %d)' %
+                 (path, results.get('format'), FORMAT_VERSION))
+    return results
+
+
+def save(results, path):
+    with open(path, 'w') as f:
+        json.dump(results, f, indent=1, sort_keys=True)
+        f.write('\n')
+
+
+def format_time(ns):
+    for unit, scale in (('s', 1e9), ('ms', 1e6), ('us', 1e3)):
+        if ns >= scale:
+            return '%.3f %s' % (ns / scale, unit)
+    return '%.1f ns' % ns
+
+
+def compare(base, new, threshold, confidence, show_all):
+    """Print the per-benchmark diff, return the number of regressions."""
+    for key in ('host', 'machine', 'num_cpus', 'library_build_type'):
+        if base.get(key) != new.get(key):
+            print('warning: %s differs: baseline %r, new %r' %
+                  (key, base.get(key), new.get(key)))
+
+    rows = []
+    b_all, n_all = base['benchmarks'], new['benchmarks']
+    for name in sorted(set(b_all) | set(n_all)):
+        if name not in n_all:
+            rows.append((name, 'missing', median(b_all[name]), None, None,
+                         None))
+            continue
+        if name not in b_all:
+            rows.append((name, 'new', None, median(n_all[name]), None, None))
+            continue
+        b, n = b_all[name], n_all[name]
+        mb, mn = median(b), median(n)
+        ratio = mn / mb if mb > 0 else float('inf')
+        lo, hi = ratio_interval(b, n, confidence)
+        if ratio > 1.0 + threshold and lo > 1.0:
+            verdict = 'REGRESSED'
+        elif ratio < 1.0 - threshold and hi < 1.0:
+            verdict = 'improved'
+        elif (ratio > 1.0 + threshold or ratio < 1.0 - threshold):
+            verdict = 'noisy'
+        else:
+            verdict = 'same'
+        rows.append((name, verdict, mb, mn, ratio, (lo, hi)))
+
+    width = max([len(r[0]) for r in rows] + [9])
+    print('%-*s %12s %12s %9s %19s' %
+          (width, 'benchmark', 'baseline', 'new', 'change',
+           '%d%% interval' % round(confidence * 100)))
+    counts = {}
+    for name, verdict, mb, mn, ratio, ci in rows:
+        counts[verdict] = counts.get(verdict, 0) + 1
+        if verdict == 'same' and not show_all:
+            continue
+        if ratio is None:
+            print('%-*s %12s %12s %9s %19s  %s' %
+                  (width, name, format_time(mb) if mb else '-',
+                   format_time(mn) if mn else '-', '-', '-', verdict))
+            continue
+        print('%-*s %12s %12s %+8.1f%% [%+7.1f%%,%+7.1f%%]  %s' %
+              (width, name, format_time(mb), format_time(mn),
+               (ratio - 1) * 100, (ci[0] - 1) * 100, (ci[1] - 1) * 100,
+               verdict))
+    print('\n' + ', '.join('%d %s' % (counts[k], k) for k in sorted(counts)) +
+          ' (threshold %.1f%%)' % (threshold * 100))
+    return counts.get('REGRESSED', 0)
+
+
+def add_run_arguments(p):
+    p.add_argument('--kernels', help='path to tiny_dnn_benchmarks')
+    p.add_argument('--models', help='path to benchmarks_all')
+    d = DEFAULT_SETTINGS
+    p.add_argument('--repetitions', type=int,
+                   help='samples per benchmark (default: %d)' %
+                   d['repetitions'])
+    p.add_argument('--min_time', type=float,
+                   help='seconds per kernel sample (default: %g)' %
+                   d['min_time'])
+    p.add_argument('--filter',
+                   help='regex of the kernel benchmarks to run (default: %s)'
+                   % d['filter'])
+    p.add_argument('--model_list',
+                   help='models to run (default: %s)' % d['model_list'])
+    p.add_argument('--batch_size', type=int,
+                   help='default: %d' % d['batch_size'])
+    p.add_argument('--iterations', type=int,
+                   help='timed passes per model sample (default: %d)' %
+                   d['iterations'])
+
+
+def add_compare_arguments(p):
+    p.add_argument('--threshold', type=float, default=0.05,
+                   help='relative slowdown tolerated (default: %(default)s)')
+    p.add_argument('--confidence', type=float, default=0.95,
+                   help='level of the confidence intervals')
+    p.add_argument('--all', action='store_true',
+                   help='also list the benchmarks which did not change')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    sub = parser.add_subparsers(dest='command')
+    sub.required = True
+
+    p = sub.add_parser('record', help='run the suite and save the samples')
+    add_run_arguments(p)
+    p.add_argument('-o', '--output', required=True)
+
+    p = sub.add_parser('compare', help='compare two saved runs')
+    p.add_argument('baseline')
+    p.add_argument('new')
+    add_compare_arguments(p)
+
+    p = sub.add_parser('check', help='run the suite and compare it against '
+                       'a baseline')
+    p.add_argument('baseline')
+    add_run_arguments(p)
+    add_compare_arguments(p)
+    p.add_argument('-o', '--output', help='also save the new samples')
+
+    args = parser.parse_args()
+    if args.command == 'record':
+        save(record(args, DEFAULT_SETTINGS), args.output)
+        return 0
+
+    baseline = load(args.baseline)
+    if args.command == 'compare':
+        new = load(args.new)
+    else:
+        defaults = dict(DEFAULT_SETTINGS)
+        defaults.update(baseline.get('settings', {}))
+        new = record(args, defaults)
+        if args.output:
+            save(new, args.output)
+    regressions = compare(baseline, new, args.threshold, args.confidence,
+                          args.all)
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -6,35 +6,229 @@
     in the LICENSE file.
 */
 
+// end-to-end benchmarks of the reference models on synthetic data:
+// inference latency (batch 1), inference throughput (batch N), training
+// step time (batch N) and peak memory of each model.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "tiny_dnn/tiny_dnn.h"
 
 using namespace tiny_dnn;
-using namespace std;
 
-int main(int argc, char **argv) {
-  CNN_UNREFERENCED_PARAMETER(argc);
-  CNN_UNREFERENCED_PARAMETER(argv);
-  models::alexnet nn;
+typedef std::chrono::steady_clock bm_clock;
+
+struct model_result {
+  std::string name;
+  size_t parameters;
+  double latency_ms;          // median of predict() of one sample
+  double samples_per_second;  // predict() of batch_size samples
+  double train_step_ms;       // median of one minibatch of fit()
+  uint64_t inference_peak_bytes;
+  uint64_t training_peak_bytes;
+};
+
+static double seconds_since(bm_clock::time_point start) {
+  return std::chrono::duration<double>(bm_clock::now() - start).count();
+}
+
+static double median(std::vector<double> v) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[v.size() / 2];
+}
+
+template <typename Net>
+static model_result run_model(const std::string &name,
+                              Net &nn,
+                              size_t batch_size,
+                              int iterations) {
+  model_result r;
+  r.name = name;
 
-  // change all layers at once
-  nn.weight_init(weight_init::constant(2.0));
-  nn.bias_init(weight_init::constant(2.0));
   nn.init_weight();
+  r.parameters = 0;
+  for (size_t i = 0; i < nn.layer_size(); i++) {
+    for (const vec_t *w : static_cast<const layer *>(nn[i])->weights()) {
+      r.parameters += w->size();
+    }
+  }
+
+  vec_t sample(nn.in_data_size());
+  uniform_rand(sample.begin(), sample.end(), 0, 1);
 
-  vec_t in(224 * 224 * 3);
+  // latency
+  std::vector<double> times;
+  nn.predict(sample);  // warm up
+  for (int i = 0; i < iterations; i++) {
+    const auto start = bm_clock::now();
+    nn.predict(sample);
+    times.push_back(seconds_since(start));
+  }
+  r.latency_ms = median(times) * 1e3;
 
-  // generate random variables
-  uniform_rand(in.begin(), in.end(), 0, 1);
+  // throughput
+  std::vector<tensor_t> batch(batch_size, tensor_t(1, sample));
+  aligned_heap_usage::instance().reset_peak();
+  nn.predict(batch);
+  times.clear();
+  for (int i = 0; i < iterations; i++) {
+    const auto start = bm_clock::now();
+    nn.predict(batch);
+    times.push_back(seconds_since(start));
+  }
+  r.samples_per_second   = batch_size / median(times);
+  r.inference_peak_bytes = aligned_heap_usage::instance().peak_bytes();
 
-  timer t;  // start the timer
+  // training: one epoch of iterations + 1 minibatches, the first one warms
+  // up
+  std::vector<vec_t> x((iterations + 1) * batch_size, sample);
+  std::vector<vec_t> y(x.size(), vec_t(nn.out_data_size(), float_t(0)));
+  for (size_t i = 0; i < y.size(); i++) y[i][i % y[i].size()] = 1;
+
+  momentum opt;
+  times.clear();
+  auto last = bm_clock::now();
+  aligned_heap_usage::instance().reset_peak();
+  nn.template fit<mse>(opt, x, y, batch_size, 1,
+                       [&]() {
+                         times.push_back(seconds_since(last));
+                         last = bm_clock::now();
+                       },
+                       []() {});
+  r.training_peak_bytes = aligned_heap_usage::instance().peak_bytes();
+  times.erase(times.begin());
+  r.train_step_ms = median(times) * 1e3;
+  return r;
+}
+
+static bool run_model(const std::string &name,
+                      size_t batch_size,
+                      int iterations,
+                      std::vector<model_result> *results) {
+  if (name == "lenet") {
+    models::lenet nn;
+    results->push_back(run_model(name, nn, batch_size, iterations));
+  } else if (name == "vgg") {
+    models::vgg nn;
+    results->push_back(run_model(name, nn, batch_size, iterations));
+  } else if (name == "resnet") {
+    models::resnet nn;
+    results->push_back(run_model(name, nn, batch_size, iterations));
+  } else if (name == "mobilenet") {
+    models::mobilenet nn;
+    results->push_back(run_model(name, nn, batch_size, iterations));
+  } else if (name == "alexnet") {
+    models::alexnet nn;
+    results->push_back(run_model(name, nn, batch_size, iterations));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static void print(std::ostream &os, const std::vector<model_result> &results) {
+  os << std::left << std::setw(12) << "model" << std::right << std::setw(12)
+     << "params" << std::setw(14) << "latency ms" << std::setw(14)
+     << "samples/s" << std::setw(14) << "train ms" << std::setw(14)
+     << "infer MB" << std::setw(14) << "train MB"
+     << "\n";
+  for (const auto &r : results) {
+    os << std::left << std::setw(12) << r.name << std::right << std::setw(12)
+       << r.parameters << std::fixed << std::setprecision(3) << std::setw(14)
+       << r.latency_ms << std::setprecision(1) << std::setw(14)
+       << r.samples_per_second << std::setprecision(3) << std::setw(14)
+       << r.train_step_ms << std::setprecision(1) << std::setw(14)
+       << r.inference_peak_bytes / 1e6 << std::setw(14)
+       << r.training_peak_bytes / 1e6 << "\n";
+  }
+}
+
+static std::string to_json(const std::vector<model_result> &results,
+                           size_t batch_size) {
+  std::ostringstream os;
+  os << "{\"batch_size\":" << batch_size << ",\"models\":[";
+  for (size_t i = 0; i < results.size(); i++) {
+    const model_result &r = results[i];
+    os << (i ? "," : "") << "\n{\"name\":\"" << r.name
+       << "\",\"parameters\":" << r.parameters
+       << ",\"latency_ms\":" << r.latency_ms
+       << ",\"samples_per_second\":" << r.samples_per_second
+       << ",\"train_step_ms\":" << r.train_step_ms
+       << ",\"inference_peak_bytes\":" << r.inference_peak_bytes
+       << ",\"training_peak_bytes\":" << r.training_peak_bytes << "}";
+  }
+  os << "]}\n";
+  return os.str();
+}
+
+static void usage(const char *argv0) {
+  std::cout << "Usage: " << argv0 << " --models lenet,vgg,resnet,mobilenet"
+            << " --batch_size 16"
+            << " --iterations 10"
+            << " --json results.json" << std::endl
+            << "models: lenet, vgg, resnet, mobilenet, alexnet" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  std::string models = "lenet,vgg,resnet,mobilenet";
+  int batch_size     = 16;
+  int iterations     = 10;
+  std::string json_path;
 
-  // predict
-  auto res = nn.predict(in);
+  if (argc == 2) {
+    std::string argname(argv[1]);
+    if (argname == "--help" || argname == "-h") {
+      usage(argv[0]);
+      return 0;
+    }
+  }
+  for (int count = 1; count + 1 < argc; count += 2) {
+    std::string argname(argv[count]);
+    if (argname == "--models") {
+      models = argv[count + 1];
+    } else if (argname == "--batch_size") {
+      batch_size = atoi(argv[count + 1]);
+    } else if (argname == "--iterations") {
+      iterations = atoi(argv[count + 1]);
+    } else if (argname == "--json") {
+      json_path = argv[count + 1];
+    } else {
+      std::cerr << "Invalid parameter specified - \"" << argname << "\""
+                << std::endl;
+      usage(argv[0]);
+      return -1;
+    }
+  }
+  if (batch_size <= 0 || iterations <= 0) {
+    std::cerr << "The batch size and the number of iterations must be "
+                 "greater than 0."
+              << std::endl;
+    return -1;
+  }
 
-  double elapsed_s = t.elapsed();
-  t.stop();
+  std::vector<model_result> results;
+  std::stringstream names(models);
+  std::string name;
+  while (std::getline(names, name, ',')) {
+    std::cout << "running " << name << "..." << std::endl;
+    if (!run_model(name, batch_size, iterations, &results)) {
+      std::cerr << "Unknown model - \"" << name << "\"" << std::endl;
+      usage(argv[0]);
+      return -1;
+    }
+  }
 
-  cout << "Elapsed time(s): " << elapsed_s << endl;
+  print(std::cout, results);
+  if (!json_path.empty()) {
+    std::ofstream(json_path) << to_json(results, batch_size);
+  }
+  return 0;
 }
@@ -0,0 +1,349 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+
+// how parallel_for and the layers scale over threads with the threading
+// backend this is built with (thread pool, TBB, OpenMP, GCD or single
+// thread): dispatch overhead of empty tasks, a synthetic loop over grain
+// sizes, and the speedup and parallel efficiency of layers and models.
+// build it once per backend to compare them.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tiny_dnn/tiny_dnn.h"
+
+#if defined(CNN_USE_OMP)
+#include <omp.h>
+#elif defined(CNN_USE_TBB)
+#include <tbb/task_arena.h>
+#endif
+
+using namespace tiny_dnn;
+
+typedef std::chrono::steady_clock bm_clock;
+
+static const char *backend_name() {
+#if defined(CNN_SINGLE_THREAD)
+  return "single";
+#elif defined(CNN_USE_TBB)
+  return "tbb";
+#elif defined(CNN_USE_OMP)
+  return "omp";
+#elif defined(CNN_USE_GCD)
+  return "gcd";
+#else
+  return "thread_pool";
+#endif
+}
+
+// whether the number of threads can be chosen with this backend
+static bool threads_adjustable() {
+#if defined(CNN_SINGLE_THREAD) || defined(CNN_USE_GCD)
+  return false;
+#else
+  return true;
+#endif
+}
+
+// run f with parallel_for using num_threads threads
+static void with_threads(size_t num_threads, const std::function<void()> &f) {
+#if defined(CNN_SINGLE_THREAD) || defined(CNN_USE_GCD)
+  CNN_UNREFERENCED_PARAMETER(num_threads);
+  f();
+#elif defined(CNN_USE_TBB)
+  tbb::task_arena arena(static_cast<int>(num_threads));
+  arena.execute(f);
+#elif defined(CNN_USE_OMP)
+  omp_set_num_threads(static_cast<int>(num_threads));
+  f();
+#else
+  set_num_threads(num_threads);
+  f();
+  set_num_threads(0);
+#endif
+}
+
+// seconds per call of f: calls are repeated until they took min_seconds
+static double time_per_call(const std::function<void()> &f,
+                            double min_seconds) {
+  f();  // warm up
+  size_t calls = 1;
+  for (;;) {
+    const auto start = bm_clock::now();
+    for (size_t i = 0; i < calls; i++) f();
+    const double s = std::chrono::duration<double>(bm_clock::now() - start)
+                       .count();
+    if (s >= min_seconds || calls >= (size_t(1) << 30)) return s / calls;
+    calls *= s > 0 ? std::min<size_t>(10, size_t(min_seconds / s) + 1) : 10;
+  }
+}
+
+struct measurement {
+  std::string workload;
+  size_t grain;  // 0 if the workload picks its own
+  size_t threads;
+  double seconds;     // per call
+  double baseline;    // per call, serially or with one thread
+  double speedup;     // baseline / seconds
+  double efficiency;  // speedup / threads
+};
+
+class scaling_benchmark {
+ public:
+  scaling_benchmark(const std::vector<size_t> &threads, double min_seconds)
+    : threads_(threads), min_seconds_(min_seconds) {}
+
+  /**
+   * time f for every thread count against baseline, which runs the same
+   * work serially; without baseline the time with one thread is used
+   **/
+  void run(const std::string &workload,
+           size_t grain,
+           const std::function<void()> &f,
+           const std::function<void()> &baseline = nullptr) {
+    std::cout << "  " << workload << std::flush;
+    double base = 0;
+    if (baseline) base = time_per_call(baseline, min_seconds_);
+    for (size_t t : threads_) {
+      double s = 0;
+      with_threads(t, [&]() { s = time_per_call(f, min_seconds_); });
+      if (!baseline && base == 0) base = s;
+      measurement m;
+      m.workload   = workload;
+      m.grain      = grain;
+      m.threads    = t;
+      m.seconds    = s;
+      m.baseline   = base;
+      m.speedup    = s > 0 ? base / s : 0;
+      m.efficiency = m.speedup / t;
+      results_.push_back(m);
+      std::cout << "." << std::flush;
+    }
+    std::cout << std::endl;
+  }
+
+  void print(std::ostream &os) const {
+    os << std::left << std::setw(30) << "workload" << std::right
+       << std::setw(7) << "grain" << std::setw(9) << "threads" << std::setw(14)
+       << "us/call" << std::setw(10) << "speedup" << std::setw(12)
+       << "efficiency"
+       << "\n";
+    for (const auto &m : results_) {
+      os << std::left << std::setw(30) << m.workload << std::right
+         << std::setw(7) << (m.grain ? std::to_string(m.grain) : "-")
+         << std::setw(9) << m.threads << std::fixed << std::setprecision(3)
+         << std::setw(14) << m.seconds * 1e6 << std::setprecision(2)
+         << std::setw(10) << m.speedup << std::setw(12) << m.efficiency
+         << "\n";
+    }
+  }
+
+  std::string to_json() const {
+    std::ostringstream os;
+    os << "{\"backend\":\"" << backend_name() << "\",\"results\":[";
+    for (size_t i = 0; i < results_.size(); i++) {
+      const measurement &m = results_[i];
+      os << (i ? "," : "") << "\n{\"workload\":\"" << m.workload
+         << "\",\"grain\":" << m.grain << ",\"threads\":" << m.threads
+         << ",\"seconds\":" << m.seconds << ",\"baseline\":" << m.baseline
+         << ",\"speedup\":" << m.speedup
+         << ",\"efficiency\":" << m.efficiency << "}";
+    }
+    os << "]}\n";
+    return os.str();
+  }
+
+ private:
+  std::vector<size_t> threads_;
+  double min_seconds_;
+  std::vector<measurement> results_;
+};
+
+// dispatch overhead: parallel_for over tasks chunks doing nothing
+static void bench_dispatch(scaling_benchmark &bm) {
+  for (size_t tasks : {1, 16, 256}) {
+    const size_t grain = 4;
+    bm.run("dispatch/" + std::to_string(tasks) + "_tasks", grain, [=]() {
+      parallel_for(0, tasks * grain, [](const blocked_range &) {}, grain);
+    });
+  }
+}
+
+// a memory-light loop of 64k elements, 64 flops each
+static void bench_loop(scaling_benchmark &bm) {
+  const size_t n = 1 << 16;
+  std::shared_ptr<vec_t> data(new vec_t(n, float_t(0.5)));
+  auto body = [data](size_t i) {
+    float_t x = (*data)[i];
+    for (int k = 0; k < 32; k++) x = x * float_t(0.999) + float_t(0.001);
+    (*data)[i] = x;
+  };
+  const auto serial = [=]() {
+    for (size_t i = 0; i < n; i++) body(i);
+  };
+  for (size_t grain : {1, 16, 100, 1024, 16384}) {
+    bm.run("for_i/64k", grain, [=]() { for_i(true, n, body, grain); },
+           serial);
+  }
+}
+
+// forward and backward of a layer on batch samples
+static void bench_layer(scaling_benchmark &bm,
+                        const std::string &name,
+                        std::shared_ptr<layer> l,
+                        size_t batch) {
+  std::vector<tensor_t> in;
+  for (const auto &shape : l->in_data_shape()) {
+    in.emplace_back(batch, vec_t(shape.size()));
+    for (auto &v : in.back()) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  }
+  std::vector<tensor_t> grads;
+  for (const auto &shape : l->out_data_shape()) {
+    grads.emplace_back(batch, vec_t(shape.size(), float_t(0.1)));
+  }
+  std::vector<const tensor_t *> out;
+  l->forward(in, out);
+  l->backward(grads);
+
+  const std::string suffix = "/batch" + std::to_string(batch);
+  bm.run(name + "_fwd" + suffix, 0, [l]() { l->forward(); });
+  bm.run(name + "_bwd" + suffix, 0, [l]() { l->backward(); });
+}
+
+static void bench_layers(scaling_benchmark &bm) {
+  for (size_t batch : {1, 16}) {
+    bench_layer(bm, "conv28x32x64",
+                std::make_shared<convolutional_layer>(28, 28, 3, 32, 64,
+                                                      padding::same),
+                batch);
+    bench_layer(bm, "fc784x512",
+                std::make_shared<fully_connected_layer>(784, 512), batch);
+    bench_layer(bm, "maxpool56x64",
+                std::make_shared<max_pooling_layer>(56, 56, 64, 2), batch);
+    bench_layer(bm, "relu50k", std::make_shared<relu_layer>(50176), batch);
+  }
+}
+
+// predict and one training step of a model on a batch of samples
+template <typename Net>
+static void bench_model(scaling_benchmark &bm,
+                        const std::string &name,
+                        std::shared_ptr<Net> nn,
+                        size_t batch) {
+  vec_t sample(nn->in_data_size());
+  uniform_rand(sample.begin(), sample.end(), 0, 1);
+  const std::vector<tensor_t> in(batch, tensor_t(1, sample));
+  const std::vector<vec_t> x(batch, sample);
+  const std::vector<vec_t> y(batch, vec_t(nn->out_data_size(), float_t(0.1)));
+  std::shared_ptr<momentum> opt = std::make_shared<momentum>();
+
+  const std::string suffix = "/batch" + std::to_string(batch);
+  bm.run(name + "_predict" + suffix, 0, [=]() { nn->predict(in); });
+  bm.run(name + "_train" + suffix, 0,
+         [=]() { nn->template fit<mse>(*opt, x, y, batch, 1); });
+}
+
+static void bench_models(scaling_benchmark &bm) {
+  bench_model(bm, "lenet", std::make_shared<models::lenet>(), 16);
+  bench_model(bm, "resnet8", std::make_shared<models::resnet>(1), 16);
+}
+
+static std::vector<size_t> default_threads() {
+  const size_t hw = std::max<size_t>(1, num_threads());
+  std::vector<size_t> threads;
+  if (!threads_adjustable()) return {hw};
+  for (size_t t = 1; t < hw; t *= 2) threads.push_back(t);
+  threads.push_back(hw);
+  return threads;
+}
+
+static void usage(const char *argv0) {
+  std::cout << "Usage: " << argv0 << " --threads 1,2,4,8"
+            << " --suites dispatch,loop,layers,models"
+            << " --min_time 0.1"
+            << " --json results.json" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  std::vector<size_t> threads = default_threads();
+  std::string suites          = "dispatch,loop,layers,models";
+  double min_time             = 0.1;
+  std::string json_path;
+
+  if (argc == 2) {
+    std::string argname(argv[1]);
+    if (argname == "--help" || argname == "-h") {
+      usage(argv[0]);
+      return 0;
+    }
+  }
+  for (int count = 1; count + 1 < argc; count += 2) {
+    std::string argname(argv[count]);
+    if (argname == "--threads") {
+      threads.clear();
+      std::stringstream list(argv[count + 1]);
+      std::string t;
+      while (std::getline(list, t, ',')) threads.push_back(std::stoul(t));
+    } else if (argname == "--suites") {
+      suites = argv[count + 1];
+    } else if (argname == "--min_time") {
+      min_time = atof(argv[count + 1]);
+    } else if (argname == "--json") {
+      json_path = argv[count + 1];
+    } else {
+      std::cerr << "Invalid parameter specified - \"" << argname << "\""
+                << std::endl;
+      usage(argv[0]);
+      return -1;
+    }
+  }
+  if (threads.empty() ||
+      std::find(threads.begin(), threads.end(), size_t(0)) != threads.end()) {
+    std::cerr << "Thread counts must be greater than 0." << std::endl;
+    return -1;
+  }
+  if (!threads_adjustable() && (threads.size() != 1 || threads[0] != 1)) {
+    std::cout << "the " << backend_name() << " backend runs with its own "
+              << "number of threads, the thread counts are labels only"
+              << std::endl;
+  }
+
+  std::cout << "backend: " << backend_name() << std::endl;
+  scaling_benchmark bm(threads, min_time);
+  std::stringstream names(suites);
+  std::string suite;
+  while (std::getline(names, suite, ',')) {
+    std::cout << suite << std::endl;
+    if (suite == "dispatch") {
+      bench_dispatch(bm);
+    } else if (suite == "loop") {
+      bench_loop(bm);
+    } else if (suite == "layers") {
+      bench_layers(bm);
+    } else if (suite == "models") {
+      bench_models(bm);
+    } else {
+      std::cerr << "Unknown suite - \"" << suite << "\"" << std::endl;
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  bm.print(std::cout);
+  if (!json_path.empty()) std::ofstream(json_path) << bm.to_json();
+  return 0;
+}
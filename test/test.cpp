@@ -18,6 +18,7 @@ using namespace tiny_dnn::activation;
 #include "test_activation_layer.h"
 // TODO(yida): fix broken test
 //#include "test_average_unpooling_layer.h"
+#include "test_batch_executor.h"
 #include "test_batch_norm_layer.h"
 #include "test_concat_layer.h"
 #include "test_convolutional_layer.h"
@@ -33,12 +34,15 @@ using namespace tiny_dnn::activation;
 #include "test_node.h"
 #include "test_nodes.h"
 #include "test_power_layer.h"
+#include "test_profiler.h"
 #include "test_quantization.h"
 #include "test_quantized_convolutional_layer.h"
 #include "test_quantized_deconvolutional_layer.h"
 #include "test_slice_layer.h"
 #include "test_target_cost.h"
 #include "test_tensor.h"
+#include "test_thread_pool.h"
+#include "test_tracer.h"
 
 #ifndef CNN_NO_SERIALIZATION
 #include "test_serialization.h"
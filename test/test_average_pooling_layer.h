@@ -150,4 +150,19 @@ TEST(ave_pool, read_write) {
   serialization_test(l1, l2);
 }
 
+TEST(ave_pool, forward_blocked) {
+  average_pooling_layer l(8, 6, 12, 2);
+  l.init_weight();
+  for (auto w : l.weights()) uniform_rand(w->begin(), w->end(), -1.0, 1.0);
+  check_channel_blocks(l, {8, 16});
+}
+
+TEST(ave_pool, forward_blocked_partial_windows) {
+  // the last column and row of windows only have the bias
+  average_pooling_layer l(8, 6, 10, 2, 2, 1, 1, padding::same);
+  l.init_weight();
+  for (auto w : l.weights()) uniform_rand(w->begin(), w->end(), -1.0, 1.0);
+  check_channel_blocks(l, {8, 10});
+}
+
 }  // namespace tiny_dnn
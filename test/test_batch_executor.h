@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+
+TEST(batch_executor, same_results_as_predict) {
+  network<sequential> net;
+  net << fully_connected_layer(10, 20) << tanh_layer(20)
+      << fully_connected_layer(20, 3);
+  net.init_weight();
+
+  std::vector<vec_t> data(40, vec_t(10));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  const std::vector<vec_t> expected = net.test(data);
+
+  std::vector<std::future<vec_t>> out(data.size());
+  {
+    batch_executor<sequential> executor(
+      net, batching_policy(8, std::chrono::milliseconds(1)));
+
+    std::vector<std::thread> clients;
+    for (size_t t = 0; t < 4; t++) {
+      clients.emplace_back([&, t]() {
+        for (size_t i = t; i < data.size(); i += 4) {
+          out[i] = executor.submit(data[i]);
+        }
+      });
+    }
+    for (auto &c : clients) c.join();
+
+    EXPECT_THROW(executor.submit(vec_t(3)), nn_error);
+  }
+
+  for (size_t i = 0; i < data.size(); i++) {
+    const vec_t y = out[i].get();
+    ASSERT_EQ(y.size(), expected[i].size());
+    for (size_t j = 0; j < y.size(); j++) {
+      EXPECT_NEAR(y[j], expected[i][j], 1e-6);
+    }
+  }
+}
+
+TEST(batch_executor, policy_and_stats) {
+  network<sequential> net;
+  net << fully_connected_layer(4, 2);
+  net.init_weight();
+
+  // the delay is long enough that only full batches run
+  batch_executor<sequential> executor(
+    net, batching_policy(8, std::chrono::seconds(100)));
+
+  std::vector<std::future<vec_t>> out;
+  for (int i = 0; i < 16; i++) out.push_back(executor.submit(vec_t(4, 1)));
+  for (auto &f : out) f.get();
+
+  batch_executor_stats stats = executor.stats();
+  EXPECT_EQ(stats.requests, 16u);
+  EXPECT_EQ(stats.batches, 2u);
+  EXPECT_EQ(stats.queue_depth, 0u);
+  EXPECT_GE(stats.max_queue_depth, 1u);
+  EXPECT_DOUBLE_EQ(stats.mean_batch_size(), 8.0);
+  EXPECT_DOUBLE_EQ(stats.mean_batch_fill(), 1.0);
+
+  // a partial batch runs once its oldest sample has waited for max_delay
+  executor.reset_stats();
+  out.clear();
+  for (int i = 0; i < 3; i++) out.push_back(executor.submit(vec_t(4, 1)));
+  executor.set_policy(batching_policy(8, std::chrono::milliseconds(1)));
+  for (auto &f : out) f.get();
+
+  stats = executor.stats();
+  EXPECT_EQ(stats.requests, 3u);
+  EXPECT_EQ(stats.batches, 1u);
+  EXPECT_DOUBLE_EQ(stats.mean_batch_fill(), 3.0 / 8.0);
+
+  EXPECT_THROW(executor.set_policy(batching_policy(0, std::chrono::seconds(1))),
+               nn_error);
+}
+
+}  // namespace tiny_dnn
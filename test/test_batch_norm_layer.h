@@ -229,4 +229,20 @@ TEST(batchnorm, read_write) {
   serialization_test(l1, l2);
 }
 
+TEST(batchnorm, forward_blocked) {
+  batch_normalization_layer bn(6 * 5, 11, 1e-5, 0.999, net_phase::test);
+  vec_t mean(11), variance(11);
+  uniform_rand(mean.begin(), mean.end(), -1.0, 1.0);
+  uniform_rand(variance.begin(), variance.end(), 0.5, 2.0);
+  bn.set_mean(mean);
+  bn.set_variance(variance);
+  check_channel_blocks(bn, {8, 16});
+
+  // the batch statistics of the train phase are planar only
+  ASSERT_TRUE(bn.set_channel_block(8));
+  bn.set_context(net_phase::train);
+  std::vector<const tensor_t *> out;
+  EXPECT_THROW(bn.forward({tensor_t(2, vec_t(6 * 5 * 11))}, out), nn_error);
+}
+
 }  // namespace tiny_dnn
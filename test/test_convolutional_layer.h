@@ -454,6 +454,464 @@ TEST(convolutional, bprop_avx_wstride) {
 
 #endif  // CNN_USE_AVX
 
+// test for GEMM backend
+
+inline void check_gemm_backend(convolutional_layer &l) {
+  tensor_buf data(l), grad1(l);
+  tensor_buf data2(data), grad2(grad1);
+
+  l.set_backend_type(tiny_dnn::core::backend_t::internal);
+
+  l.forward_propagation(data.in_buf(), data.out_buf());
+  l.back_propagation(data.in_buf(), data.out_buf(), grad1.out_buf(),
+                     grad1.in_buf());
+
+  l.set_backend_type(tiny_dnn::core::backend_t::gemm);
+
+  l.forward_propagation(data2.in_buf(), data2.out_buf());
+  l.back_propagation(data2.in_buf(), data2.out_buf(), grad2.out_buf(),
+                     grad2.in_buf());
+
+  vec_t &out_internal = data.out_at(0)[0];
+  vec_t &out_gemm     = data2.out_at(0)[0];
+  for (size_t i = 0; i < out_gemm.size(); i++) {
+    EXPECT_NEAR(out_gemm[i], out_internal[i], 1E-4);
+  }
+
+  for (size_t ch = 0; ch < l.in_channels(); ch++) {
+    vec_t &grad_internal = grad1.in_at(ch)[0];
+    vec_t &grad_gemm     = grad2.in_at(ch)[0];
+    for (size_t i = 0; i < grad_gemm.size(); i++) {
+      EXPECT_NEAR(grad_gemm[i], grad_internal[i], 1E-4);
+    }
+  }
+}
+
+TEST(convolutional, fprop_bprop_gemm) {
+  convolutional_layer l(9, 9, 3, 2, 4);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, fprop_bprop_gemm_stride_pad) {
+  convolutional_layer l(9, 7, 5, 3, 3, 2, padding::same, true, 2, 1);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, fprop_bprop_gemm_1x1) {
+  convolutional_layer l(6, 6, 1, 4, 8);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, fprop_bprop_gemm_large) {
+  // K = 32 * 3 * 3 spans more than one block of the inner dimension
+  convolutional_layer l(12, 12, 3, 32, 7, padding::valid, true, 1, 2);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, fprop_bprop_gemm_connection_tbl) {
+  bool tbl[3 * 3] = {true, false, true, false, true, false, true, true, false};
+  convolutional_layer l(7, 7, 3, 3, 3, connection_table(tbl, 3, 3));
+  check_gemm_backend(l);
+}
+
+// tests for the Winograd and the FFT kernel, which the gemm and avx engines
+// run for 3x3 windows and for large windows with unit strides; the layers
+// below have enough channels and tiles for them to pay off
+
+inline tensor_t forward_with_engine(convolutional_layer &l,
+                                 const tensor_t &in,
+                                 backend_t engine) {
+  l.set_backend_type(engine);
+  std::vector<const tensor_t *> out;
+  l.forward({in}, out);
+  return *out[0];
+}
+
+inline void check_against_internal(convolutional_layer &l, size_t batch = 1) {
+  l.init_weight();
+  // non-zero bias
+  for (auto &b : *l.weights()[1]) b = float_t(0.25);
+
+  tensor_t in(batch, vec_t(l.in_shape()[0].size()));
+  randomize_tensor(in);
+
+  const tensor_t expected = forward_with_engine(l, in, backend_t::internal);
+  std::vector<backend_t> engines = {backend_t::gemm};
+#ifdef CNN_USE_AVX
+  engines.push_back(backend_t::avx);
+#endif
+  for (backend_t engine : engines) {
+    const tensor_t out = forward_with_engine(l, in, engine);
+    for (size_t sample = 0; sample < batch; sample++) {
+      for (size_t i = 0; i < out[sample].size(); i++) {
+        EXPECT_NEAR(expected[sample][i], out[sample][i], 1E-4);
+      }
+    }
+  }
+}
+
+TEST(convolutional, winograd_tile) {
+  auto params = [](serial_size_t window, serial_size_t stride,
+                   serial_size_t out, serial_size_t in_channels,
+                   serial_size_t out_channels) {
+    core::conv_params p;
+    p.in       = shape3d(out + window - 1, out + window - 1, in_channels);
+    p.weight   = shape3d(window, window, in_channels * out_channels);
+    p.out      = shape3d(out, out, out_channels);
+    p.w_stride = stride;
+    p.h_stride = stride;
+    return p;
+  };
+  // F(2x2, 3x3) for small outputs, F(4x4, 3x3) otherwise
+  EXPECT_EQ(2u, kernels::conv2d_winograd_tile(params(3, 1, 7, 1, 1)));
+  EXPECT_EQ(4u, kernels::conv2d_winograd_tile(params(3, 1, 8, 1, 1)));
+  EXPECT_EQ(0u, kernels::conv2d_winograd_tile(params(3, 2, 8, 1, 1)));
+  EXPECT_EQ(0u, kernels::conv2d_winograd_tile(params(5, 1, 8, 1, 1)));
+
+  // only used with enough channels and tiles
+  auto pays_off = [](const core::conv_params &p, size_t batch) {
+    return kernels::conv2d_winograd_pays_off(
+      p, batch, kernels::conv2d_winograd_tile(p));
+  };
+  EXPECT_TRUE(pays_off(params(3, 1, 32, 24, 16), 1));
+  EXPECT_FALSE(pays_off(params(3, 1, 32, 16, 16), 1));
+  EXPECT_FALSE(pays_off(params(3, 1, 32, 24, 8), 1));
+  EXPECT_FALSE(pays_off(params(3, 1, 16, 64, 64), 1));
+  EXPECT_TRUE(pays_off(params(3, 1, 16, 64, 64), 4));
+  EXPECT_FALSE(pays_off(params(3, 2, 32, 64, 64), 4));
+}
+
+TEST(convolutional, fprop_winograd_f2) {
+  convolutional_layer l(9, 9, 3, 24, 16);
+  check_against_internal(l, 4);
+}
+
+TEST(convolutional, fprop_winograd_f4_same) {
+  convolutional_layer l(16, 16, 3, 24, 16, padding::same);
+  check_against_internal(l, 4);
+}
+
+TEST(convolutional, fprop_winograd_partial_tiles) {
+  // 13x11 outputs cover the last row and column of tiles partially
+  convolutional_layer l(13, 11, 3, 24, 16, padding::same);
+  check_against_internal(l, 6);
+}
+
+TEST(convolutional, fprop_winograd_blocks) {
+  // the 64 tiles of each sample take more than one block
+  convolutional_layer l(32, 32, 3, 64, 64);
+  check_against_internal(l, 2);
+}
+
+TEST(convolutional, fprop_winograd_connection_tbl) {
+  bool tbl[24 * 16];
+  for (size_t i = 0; i < 24 * 16; i++) tbl[i] = i % 3 != 0;
+  convolutional_layer l(16, 16, 3, 24, 16, connection_table(tbl, 24, 16),
+                        padding::same);
+  check_against_internal(l, 4);
+}
+
+TEST(convolutional, winograd_filter_cache) {
+  convolutional_layer l(32, 32, 3, 24, 16, padding::same, true, 1, 1,
+                        backend_t::gemm);
+  l.weight_init(weight_init::constant(0.5));
+  l.bias_init(weight_init::constant(0.0));
+
+  vec_t in(l.in_shape()[0].size());
+  uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+
+  // sum of the 3x3 window around each output position, over the channels;
+  // the 216 terms leave rounding errors of some 1E-4
+  auto window_sum = [&](size_t i) {
+    const int x = static_cast<int>(i % 32), y = static_cast<int>(i / 32 % 32);
+    float_t sum = 0;
+    for (int c = 0; c < 24; c++) {
+      for (int wy = y - 1; wy <= y + 1; wy++) {
+        for (int wx = x - 1; wx <= x + 1; wx++) {
+          if (wx < 0 || wy < 0 || wx >= 32 || wy >= 32) continue;
+          sum += in[(c * 32 + wy) * 32 + wx];
+        }
+      }
+    }
+    return sum;
+  };
+  auto fprop = [&]() {
+    std::vector<const tensor_t *> o;
+    l.forward({{in}}, o);
+    return (*o[0])[0];
+  };
+
+  // transformed filters are reused while the weights are unchanged
+  vec_t out1 = fprop();
+  vec_t out2 = fprop();
+  for (size_t i = 0; i < out1.size(); i++) {
+    EXPECT_NEAR(window_sum(i) * float_t(0.5), out1[i], 1E-3);
+    EXPECT_FLOAT_EQ(out1[i], out2[i]);
+  }
+
+  // mutable access through weights() invalidates them
+  for (auto &w : *l.weights()[0]) w = float_t(0.25);
+  vec_t out3 = fprop();
+  for (size_t i = 0; i < out3.size(); i++) {
+    EXPECT_NEAR(window_sum(i) * float_t(0.25), out3[i], 1E-3);
+  }
+
+  // writing through a pointer taken earlier requires an explicit notice:
+  // until then the cached filters are used, which still give 0.25
+  vec_t *W = l.weights()[0];
+  fprop();
+  for (auto &w : *W) w = float_t(1.0);
+  vec_t stale = fprop();
+  for (size_t i = 0; i < stale.size(); i++) {
+    EXPECT_FLOAT_EQ(out3[i], stale[i]);
+  }
+  l.mark_weights_changed();
+  vec_t out4 = fprop();
+  for (size_t i = 0; i < out4.size(); i++) {
+    EXPECT_NEAR(window_sum(i), out4[i], 1E-3);
+  }
+}
+
+TEST(convolutional, fft_size) {
+  auto fft_size = [](serial_size_t window, serial_size_t stride,
+                     serial_size_t out, serial_size_t channels) {
+    core::conv_params p;
+    p.in        = shape3d((out - 1) * stride + window,
+                   (out - 1) * stride + window, channels);
+    p.in_padded = p.in;
+    p.weight    = shape3d(window, window, channels * channels);
+    p.out       = shape3d(out, out, channels);
+    p.w_stride  = stride;
+    p.h_stride  = stride;
+    return kernels::conv2d_fft_size(p);
+  };
+  EXPECT_NE(0u, fft_size(7, 1, 50, 32));
+  EXPECT_NE(0u, fft_size(11, 1, 22, 16));
+  EXPECT_EQ(0u, fft_size(7, 1, 50, 4));   // few channels
+  EXPECT_EQ(0u, fft_size(3, 1, 32, 64));  // small window
+  EXPECT_EQ(0u, fft_size(7, 2, 50, 32));  // strided
+}
+
+TEST(convolutional, fprop_fft_tile_sizes) {
+  core::conv_params p;
+  p.in        = shape3d(20, 20, 3);
+  p.in_padded = p.in;
+  p.weight    = shape3d(5, 5, 3 * 4);
+  p.out       = shape3d(16, 16, 4);
+  p.has_bias  = true;
+  p.w_stride  = 1;
+  p.h_stride  = 1;
+
+  vec_t W(p.weight.size()), bias(4, float_t(0.25));
+  uniform_rand(W.begin(), W.end(), -1.0, 1.0);
+  tensor_t in(2, vec_t(p.in.size()));
+  randomize_tensor(in);
+
+  tensor_t expected(2, vec_t(p.out.size()));
+  kernels::conv2d_op_internal(in, W, bias, expected, p, false);
+  // one 32x32 or 64x64 tile, or 4 or 16 partial tiles per sample
+  for (serial_size_t n : {8u, 16u, 32u, 64u}) {
+    tensor_t out(2, vec_t(p.out.size()));
+    kernels::conv2d_op_fft(in, W, bias, out, p, true, n);
+    for (size_t sample = 0; sample < 2; sample++) {
+      for (size_t i = 0; i < out[sample].size(); i++) {
+        EXPECT_NEAR(expected[sample][i], out[sample][i], 1E-4);
+      }
+    }
+  }
+}
+
+TEST(convolutional, fprop_fft_blocks) {
+  // the 16 tiles of each sample take more than one block
+  core::conv_params p;
+  p.in        = shape3d(40, 40, 64);
+  p.in_padded = p.in;
+  p.weight    = shape3d(7, 7, 64 * 4);
+  p.out       = shape3d(34, 34, 4);
+  p.has_bias  = true;
+  p.w_stride  = 1;
+  p.h_stride  = 1;
+
+  vec_t W(p.weight.size()), bias(4, float_t(0.25));
+  uniform_rand(W.begin(), W.end(), -0.1, 0.1);
+  tensor_t in(2, vec_t(p.in.size()));
+  randomize_tensor(in);
+
+  tensor_t expected(2, vec_t(p.out.size())), out = expected;
+  kernels::conv2d_op_internal(in, W, bias, expected, p, true);
+  kernels::conv2d_op_fft(in, W, bias, out, p, true, 16);
+  for (size_t sample = 0; sample < 2; sample++) {
+    for (size_t i = 0; i < out[sample].size(); i++) {
+      EXPECT_NEAR(expected[sample][i], out[sample][i], 1E-4);
+    }
+  }
+}
+
+TEST(convolutional, fprop_fft) {
+  convolutional_layer l(40, 40, 7, 24, 24);
+  check_against_internal(l);
+}
+
+TEST(convolutional, fprop_fft_same) {
+  convolutional_layer l(24, 24, 7, 24, 24, padding::same);
+  check_against_internal(l, 2);
+}
+
+TEST(convolutional, fprop_fft_rectangular) {
+  // 22x16 outputs of a 9x5 window in a single 32x32 tile
+  convolutional_layer l(30, 20, 9, 5, 24, 24);
+  check_against_internal(l);
+}
+
+TEST(convolutional, fprop_fft_connection_tbl) {
+  bool tbl[24 * 24];
+  for (size_t i = 0; i < 24 * 24; i++) tbl[i] = i % 5 != 0;
+  convolutional_layer l(24, 24, 7, 24, 24, connection_table(tbl, 24, 24),
+                        padding::same);
+  check_against_internal(l);
+}
+
+// grouped convolutions: the gemm engine multiplies each group on its own,
+// depthwise convolutions (groups == in channels) take their own kernel
+
+TEST(convolutional, groups) {
+  convolutional_layer l(8, 8, 3, 3, 6, 12, 3, padding::valid);
+  EXPECT_EQ(l.groups(), 3u);
+  EXPECT_EQ(l.in_shape()[1], shape3d(3, 3, 6 * 12 / 3));
+  EXPECT_EQ(l.fan_in_size(), 3u * 3u * 2u);
+  EXPECT_EQ(l.forward_flops(), 2u * 3u * 3u * 2u * l.out_shape()[0].size() +
+                                 l.out_shape()[0].size());
+
+  EXPECT_THROW(convolutional_layer(8, 8, 3, 3, 6, 8, 4, padding::valid),
+               nn_error);
+  EXPECT_THROW(convolutional_layer(8, 8, 3, 3, 6, 6, 0, padding::valid),
+               nn_error);
+}
+
+TEST(convolutional, fprop_bprop_gemm_groups) {
+  convolutional_layer l(9, 9, 3, 3, 6, 4, 2, padding::valid);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, fprop_bprop_gemm_groups_1x1) {
+  convolutional_layer l(6, 6, 1, 1, 8, 12, 4, padding::valid);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, fprop_bprop_depthwise) {
+  // wide enough for the unrolled loops and their tails
+  convolutional_layer l(37, 9, 3, 3, 4, 4, 4, padding::same);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, fprop_bprop_depthwise_stride) {
+  // 5x5 with two outputs per input channel
+  convolutional_layer l(27, 13, 5, 5, 3, 6, 3, padding::same, true, 2, 2);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, fprop_bprop_depthwise_generic) {
+  // a window the kernel doesn't unroll, strides differing per axis
+  convolutional_layer l(30, 12, 7, 4, 2, 2, 2, padding::valid, true, 3, 2);
+  check_gemm_backend(l);
+}
+
+TEST(convolutional, groups_match_connection_table) {
+  // a grouped layer computes what a connection table with the same groups
+  // does, with only the connected filters stored
+  const serial_size_t in = 4, out = 6, groups = 2, area = 3 * 3;
+  convolutional_layer grouped(10, 10, 3, 3, in, out, groups, padding::same);
+  convolutional_layer tbl(10, 10, 3, in, out,
+                          connection_table(groups, in, out), padding::same);
+  grouped.init_weight();
+  tbl.init_weight();
+
+  vec_t &packed = *grouped.weights()[0];
+  vec_t &full   = *tbl.weights()[0];
+  for (serial_size_t o = 0; o < out; o++) {
+    for (serial_size_t i = 0; i < in / groups; i++) {
+      const serial_size_t c = o / (out / groups) * (in / groups) + i;
+      std::copy(&packed[(o * in / groups + i) * area],
+                &packed[(o * in / groups + i + 1) * area],
+                &full[(o * in + c) * area]);
+    }
+  }
+  *tbl.weights()[1] = *grouped.weights()[1];
+
+  tensor_t x(2, vec_t(10 * 10 * in));
+  randomize_tensor(x);
+  for (backend_t engine : {backend_t::internal, backend_t::gemm}) {
+    const tensor_t expected = forward_with_engine(tbl, x, backend_t::internal);
+    const tensor_t actual   = forward_with_engine(grouped, x, engine);
+    for (size_t sample = 0; sample < x.size(); sample++) {
+      for (size_t i = 0; i < expected[sample].size(); i++) {
+        EXPECT_NEAR(expected[sample][i], actual[sample][i], 1E-5);
+      }
+    }
+  }
+}
+
+// channel-blocked layouts vectorize over the channels of a pixel. channel
+// counts which aren't a multiple of the block leave a narrower last block.
+
+inline void check_blocked_conv(convolutional_layer &l,
+                               const std::vector<serial_size_t> &blocks) {
+  l.init_weight();
+  for (auto &b : *l.weights()[1]) b = float_t(0.25);
+  check_channel_blocks(l, blocks, 1E-4);
+}
+
+TEST(convolutional, fprop_blocked) {
+  convolutional_layer l(9, 7, 3, 3, 20, 12, padding::valid);
+  // 8 and 16, and 32 which stores the activations as HWC
+  check_blocked_conv(l, {8, 16, 32});
+}
+
+TEST(convolutional, fprop_blocked_same_stride) {
+  convolutional_layer l(13, 11, 5, 5, 3, 10, padding::same, true, 2, 2);
+  check_blocked_conv(l, {8, 16});
+}
+
+TEST(convolutional, fprop_blocked_small_map) {
+  convolutional_layer l(7, 7, 3, 3, 24, 24, padding::same);
+  check_blocked_conv(l, {8, 16});
+}
+
+TEST(convolutional, fprop_blocked_depthwise) {
+  convolutional_layer l(15, 9, 3, 3, 19, 19, 19, padding::same);
+  check_blocked_conv(l, {8, 16, 19});
+}
+
+TEST(convolutional, fprop_blocked_epilogue) {
+  convolutional_layer l(6, 6, 3, 3, 8, 8, padding::same);
+  l.fuse_epilogue([](vec_t &y) {
+    for (auto &v : y) v = std::max(v, float_t(0));
+  });
+  check_blocked_conv(l, {8});
+}
+
+TEST(convolutional, blocked_unsupported) {
+  bool tbl[4 * 6];
+  for (size_t i = 0; i < 4 * 6; i++) tbl[i] = i % 3 != 0;
+  convolutional_layer with_tbl(8, 8, 3, 4, 6, connection_table(tbl, 4, 6));
+  EXPECT_FALSE(with_tbl.set_channel_block(8));
+  EXPECT_EQ(with_tbl.channel_block(), 1u);
+
+  // grouped, but not depthwise
+  convolutional_layer grouped(8, 8, 3, 3, 4, 8, 2, padding::valid);
+  EXPECT_FALSE(grouped.set_channel_block(8));
+  EXPECT_TRUE(grouped.set_channel_block(1));
+
+  // inference only
+  convolutional_layer l(5, 5, 3, 4, 4);
+  ASSERT_TRUE(l.set_channel_block(8));
+  tensor_buf data(l), grad(l);
+  l.forward_propagation(data.in_buf(), data.out_buf());
+  EXPECT_THROW(l.back_propagation(data.in_buf(), data.out_buf(),
+                                  grad.out_buf(), grad.in_buf()),
+               nn_error);
+}
+
 #ifdef CNN_USE_NNPACK
 TEST(convolutional, fprop_nnp) {
   convolutional_layer<sigmoid> l(5, 5, 3, 1, 2, padding::valid, true, 1, 1,
@@ -687,6 +1145,88 @@ TEST(convolutional,
                                      epsilon<float_t>(), GRAD_CHECK_ALL));
 }
 
+TEST(convolutional, gradient_check_gemm) {  // sigmoid - mse - gemm backend
+  network<sequential> nn;
+  bool tbl[3 * 3] = {true, false, true, false, true, false, true, true, false};
+
+  connection_table connections(tbl, 3, 3);
+
+  nn << convolutional_layer(7, 7, 3, 3, 3, connections, padding::same, true, 2,
+                            1, core::backend_t::gemm)
+     << sigmoid();
+
+  const auto test_data = generate_gradient_check_data(nn.in_data_size());
+  nn.init_weight();
+  EXPECT_TRUE(nn.gradient_check<mse>(test_data.first, test_data.second,
+                                     epsilon<float_t>(), GRAD_CHECK_ALL));
+}
+
+TEST(convolutional, gradient_check_depthwise) {
+  for (auto engine : {core::backend_t::internal, core::backend_t::gemm}) {
+    network<sequential> nn;
+    nn << convolutional_layer(7, 7, 3, 3, 2, 4, 2, padding::same, true, 2, 1,
+                              engine)
+       << sigmoid();
+
+    const auto test_data = generate_gradient_check_data(nn.in_data_size());
+    nn.init_weight();
+    EXPECT_TRUE(nn.gradient_check<mse>(test_data.first, test_data.second,
+                                       epsilon<float_t>(), GRAD_CHECK_ALL));
+  }
+}
+
+TEST(convolutional, per_thread_weight_grads) {
+  const size_t n = 9;
+  tensor_t in(n, vec_t(9 * 9 * 3)), delta(n, vec_t(5 * 5 * 4));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  for (auto &v : delta) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const vec_t *> delta_ptr;
+  for (auto &v : delta) delta_ptr.push_back(&v);
+
+  for (auto engine : {core::backend_t::internal, core::backend_t::avx,
+                      core::backend_t::gemm}) {
+    convolutional_layer parallel(9, 9, 5, 3, 4, padding::valid, true, 1, 1,
+                                 engine);
+    convolutional_layer serial(9, 9, 5, 3, 4, padding::valid, true, 1, 1,
+                               engine);
+    serial.set_parallelize(false);
+    parallel.setup(true);
+    serial.setup(true);
+    *serial.weights()[0] = *parallel.weights()[0];
+    *serial.weights()[1] = *parallel.weights()[1];
+
+    for (auto l : {&parallel, &serial}) {
+      std::vector<const tensor_t *> o;
+      l->forward({in}, o);
+      l->set_out_grads(&delta_ptr, 1);
+      l->backward();
+    }
+
+    // one gradient per worker thread instead of one per sample
+    const tensor_t &dW = *parallel.weights_grads()[0];
+    const tensor_t &db = *parallel.weights_grads()[1];
+    EXPECT_EQ(dW.size(), std::min(n, num_threads()));
+    EXPECT_EQ(db.size(), dW.size());
+    ASSERT_EQ(serial.weights_grads()[0]->size(), 1u);
+
+    vec_t dw_sum(dW[0].size()), db_sum(db[0].size());
+    for (size_t t = 0; t < dW.size(); t++) {
+      vectorize::reduce<float_t>(&dW[t][0], dw_sum.size(), &dw_sum[0]);
+      vectorize::reduce<float_t>(&db[t][0], db_sum.size(), &db_sum[0]);
+    }
+
+    const vec_t &dw_ref = (*serial.weights_grads()[0])[0];
+    const vec_t &db_ref = (*serial.weights_grads()[1])[0];
+    for (size_t i = 0; i < dw_ref.size(); i++) {
+      EXPECT_NEAR(dw_ref[i], dw_sum[i], 1E-4);
+    }
+    for (size_t i = 0; i < db_ref.size(); i++) {
+      EXPECT_NEAR(db_ref[i], db_sum[i], 1E-4);
+    }
+  }
+}
+
 TEST(convolutional,
      gradient_check12_pad_same) {  // sigmoid - mse - padding same
   network<sequential> nn;
@@ -712,6 +1252,16 @@ TEST(convolutional, read_write) {
   serialization_test(l1, l2);
 }
 
+TEST(convolutional, read_write_groups) {
+  convolutional_layer l1(6, 6, 3, 3, 4, 8, 4, padding::same);
+  convolutional_layer l2(6, 6, 3, 3, 4, 8, 4, padding::same);
+
+  l1.init_weight();
+  l2.init_weight();
+
+  serialization_test(l1, l2);
+}
+
 TEST(convolutional, read_write2) {
 #define O true
 #define X false
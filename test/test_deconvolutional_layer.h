@@ -279,4 +279,83 @@ connection_table(connection, 3, 6));
     serialization_test(layer1, layer2);
 }
 */
+// FFT deconvolution, which the avx engine runs for large windows with unit
+// strides
+
+TEST(deconvolutional, fft_size) {
+  auto fft_size = [](serial_size_t window, serial_size_t stride,
+                     serial_size_t in, serial_size_t channels) {
+    core::deconv_params p;
+    p.in       = shape3d(in, in, channels);
+    p.weight   = shape3d(window, window, channels * channels);
+    p.out      = shape3d((in - 1) * stride + window,
+                    (in - 1) * stride + window, channels);
+    p.w_stride = stride;
+    p.h_stride = stride;
+    return kernels::deconv2d_fft_size(p);
+  };
+  EXPECT_NE(0u, fft_size(5, 1, 16, 8));
+  EXPECT_NE(0u, fft_size(3, 1, 28, 32));
+  EXPECT_EQ(0u, fft_size(3, 1, 2, 1));   // tiny
+  EXPECT_EQ(0u, fft_size(5, 2, 16, 8));  // strided
+}
+
+TEST(deconvolutional, fprop_fft_tile_sizes) {
+  core::deconv_params p;
+  p.in       = shape3d(9, 7, 3);
+  p.weight   = shape3d(5, 3, 3 * 4);
+  p.out      = shape3d(13, 9, 4);
+  p.has_bias = true;
+  p.w_stride = 1;
+  p.h_stride = 1;
+
+  vec_t W(p.weight.size()), bias(4, float_t(0.25));
+  uniform_rand(W.begin(), W.end(), -1.0, 1.0);
+  tensor_t in(2, vec_t(p.in.size()));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  tensor_t expected(2, vec_t(p.out.size()));
+  core::kernels::tiny_deconv2d_kernel(p, in, W, bias, expected, false);
+  for (serial_size_t n : {8u, 16u, 32u}) {
+    vec_t S;
+    kernels::deconv2d_fft_transform_filter(p, W, n, S);
+    tensor_t out(2, vec_t(p.out.size()));
+    kernels::deconv2d_op_fft(in, S, n, bias, out, p, true);
+    for (size_t sample = 0; sample < 2; sample++) {
+      for (size_t i = 0; i < out[sample].size(); i++) {
+        EXPECT_NEAR(expected[sample][i], out[sample][i], 1E-4);
+      }
+    }
+  }
+}
+
+#ifdef CNN_USE_AVX
+TEST(deconvolutional, fprop_fft_avx) {
+  deconvolutional_layer l(16, 16, 5, 16, 8, padding::same);
+  l.init_weight();
+  for (auto &b : *l.weights()[1]) b = float_t(0.25);
+
+  tensor_t in(2, vec_t(l.in_shape()[0].size()));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  auto compare = [&]() {
+    std::vector<const tensor_t *> out;
+    l.set_backend_type(backend_t::internal);
+    l.forward({in}, out);
+    const tensor_t expected = *out[0];
+    l.set_backend_type(backend_t::avx);
+    l.forward({in}, out);
+    for (size_t sample = 0; sample < 2; sample++) {
+      for (size_t i = 0; i < expected[sample].size(); i++) {
+        EXPECT_NEAR(expected[sample][i], (*out[0])[sample][i], 1E-4);
+      }
+    }
+  };
+  compare();
+  // the cached filter spectra follow changes of the weights
+  for (auto &w : *l.weights()[0]) w = -w;
+  compare();
+}
+#endif  // CNN_USE_AVX
+
 }  // namespace tiny_dnn
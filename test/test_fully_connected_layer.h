@@ -172,6 +172,66 @@ TEST(fully_connected, forward) {
   }
 }
 
+TEST(fully_connected, batched_gemm) {
+  const size_t in_size = 37, out_size = 45, n = 5;
+  fully_connected_layer l(in_size, out_size);
+  l.setup(true);
+
+  const vec_t &W = *l.weights()[0];
+  const vec_t &b = *l.weights()[1];
+
+  tensor_t in(n, vec_t(in_size)), delta(n, vec_t(out_size));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  for (auto &v : delta) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const tensor_t *> o;
+  l.forward({in}, o);
+
+  std::vector<const vec_t *> delta_ptr;
+  for (auto &v : delta) delta_ptr.push_back(&v);
+  l.set_out_grads(&delta_ptr, 1);
+  l.backward();
+
+  const tensor_t &out        = *o[0];
+  const tensor_t &prev_delta = *l.inputs()[0]->get_gradient();
+  const tensor_t &dW         = *l.weights_grads()[0];
+  const tensor_t &db         = *l.weights_grads()[1];
+
+  // the weight gradient of the whole batch is kept in a single copy
+  ASSERT_EQ(dW.size(), 1u);
+  ASSERT_EQ(db.size(), 1u);
+
+  for (size_t s = 0; s < n; s++) {
+    for (size_t i = 0; i < out_size; i++) {
+      float_t expected = b[i];
+      for (size_t c = 0; c < in_size; c++) {
+        expected += W[c * out_size + i] * in[s][c];
+      }
+      EXPECT_NEAR(expected, out[s][i], 1E-4);
+    }
+    for (size_t c = 0; c < in_size; c++) {
+      float_t expected = 0;
+      for (size_t i = 0; i < out_size; i++) {
+        expected += W[c * out_size + i] * delta[s][i];
+      }
+      EXPECT_NEAR(expected, prev_delta[s][c], 1E-4);
+    }
+  }
+
+  for (size_t c = 0; c < in_size; c++) {
+    for (size_t i = 0; i < out_size; i++) {
+      float_t expected = 0;
+      for (size_t s = 0; s < n; s++) expected += in[s][c] * delta[s][i];
+      EXPECT_NEAR(expected, dW[0][c * out_size + i], 1E-4);
+    }
+  }
+  for (size_t i = 0; i < out_size; i++) {
+    float_t expected = 0;
+    for (size_t s = 0; s < n; s++) expected += delta[s][i];
+    EXPECT_NEAR(expected, db[0][i], 1E-4);
+  }
+}
+
 #ifdef CNN_USE_NNPACK
 TEST(fully_connected, forward_nnp) {
   nnp_initialize();
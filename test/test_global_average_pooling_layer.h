@@ -9,6 +9,11 @@
 
 #include <string>
 
+#if defined(CNN_USE_AVX) && !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "gtest/gtest.h"
 #include "testhelper.h"
 #include "tiny_dnn/tiny_dnn.h"
@@ -127,4 +132,40 @@ TEST(global_ave_pool, backward_multichannel) {
     EXPECT_FLOAT_EQ(in_grad_expected[i], in_grad[i]);
   }
 }
+
+TEST(global_ave_pool, forward_blocked) {
+  global_average_pooling_layer l(7, 5, 21);
+  check_channel_blocks(l, {8, 16, 21});
+}
+
+#if defined(CNN_USE_AVX) && !defined(_WIN32)
+// the avx kernel sums each channel with vectorize::accumulate, which must not
+// load past its last block: the blocks end right before an inaccessible page
+TEST(global_ave_pool, accumulate_at_end_of_buffer) {
+#ifdef CNN_USE_DOUBLE
+  typedef vectorize::detail::double_avx avx;
+#else
+  typedef vectorize::detail::float_avx avx;
+#endif
+  const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  void *p = ::mmap(nullptr, page * 2, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(p, MAP_FAILED);
+  ASSERT_EQ(::mprotect(static_cast<char *>(p) + page, page, PROT_NONE), 0);
+
+  const size_t block = avx::unroll_size;
+  float_t *end = reinterpret_cast<float_t *>(static_cast<char *>(p) + page);
+  for (size_t nblocks = 1; nblocks <= 9; nblocks++) {
+    const size_t n = nblocks * block;
+    float_t *start = end - n;
+    for (size_t i = 0; i < n; i++) start[i] = float_t(i + 1);
+
+    const float_t sum =
+      avx::resemble(vectorize::accumulate<std::true_type>(start, nblocks));
+    EXPECT_FLOAT_EQ(float_t(n * (n + 1) / 2), sum);
+  }
+  ::munmap(p, page * 2);
+}
+#endif  // CNN_USE_AVX
+
 }  // namespace tiny_dnn
@@ -229,6 +229,50 @@ TEST(max_pool, forward_stride_nnp_not_2x2) {
 }
 #endif
 
+#ifdef CNN_USE_AVX
+TEST(max_pool, avx_matches_internal) {
+  struct config {
+    serial_size_t w, h, pool_x, pool_y, stride_x, stride_y;
+    padding pad;
+  } configs[] = {
+    {20, 20, 2, 2, 2, 2, padding::valid}, {35, 35, 3, 3, 2, 2, padding::valid},
+    {27, 13, 3, 3, 1, 1, padding::valid}, {21, 9, 2, 2, 1, 1, padding::same},
+    {19, 18, 3, 2, 3, 2, padding::valid}, {4, 4, 2, 2, 2, 2, padding::valid},
+  };
+
+  for (const auto &cfg : configs) {
+    max_pooling_layer internal(cfg.w, cfg.h, 3, cfg.pool_x, cfg.pool_y,
+                               cfg.stride_x, cfg.stride_y, cfg.pad,
+                               core::backend_t::internal);
+    max_pooling_layer avx(cfg.w, cfg.h, 3, cfg.pool_x, cfg.pool_y,
+                          cfg.stride_x, cfg.stride_y, cfg.pad,
+                          core::backend_t::avx);
+
+    vec_t in(internal.in_data_size());
+    uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+    in[5] = in[6];  // ties must resolve to the same index
+
+    std::vector<const tensor_t *> out1, out2;
+    internal.forward({{in}}, out1);
+    avx.forward({{in}}, out2);
+    const vec_t &res1 = (*out1[0])[0];
+    const vec_t &res2 = (*out2[0])[0];
+    ASSERT_EQ(res1.size(), res2.size());
+    for (size_t i = 0; i < res1.size(); i++) {
+      EXPECT_FLOAT_EQ(res1[i], res2[i]);
+    }
+
+    vec_t delta(internal.out_data_size());
+    uniform_rand(delta.begin(), delta.end(), -1.0, 1.0);
+    vec_t grad1 = internal.backward({{delta}})[0][0];
+    vec_t grad2 = avx.backward({{delta}})[0][0];
+    for (size_t i = 0; i < grad1.size(); i++) {
+      EXPECT_FLOAT_EQ(grad1[i], grad2[i]);
+    }
+  }
+}
+#endif  // CNN_USE_AVX
+
 TEST(max_pool, forward_stride) {
   max_pooling_layer l(4, 4, 1, 2, 1);
   // clang-format off
@@ -379,4 +423,22 @@ TEST(max_pool, serialization_padding) {
 }
 #endif
 
+TEST(max_pool, forward_blocked) {
+  max_pooling_layer l(9, 7, 20, 2);
+  check_channel_blocks(l, {8, 16, 20});
+}
+
+TEST(max_pool, forward_blocked_overlapping) {
+  // 3x3 windows every 2 pixels, clipped at the right and bottom borders
+  max_pooling_layer l(10, 8, 12, 3, 3, 2, 2, padding::same);
+  check_channel_blocks(l, {8, 16});
+
+  ASSERT_TRUE(l.set_channel_block(8));
+  tensor_buf data(l), grad(l);
+  l.forward_propagation(data.in_buf(), data.out_buf());
+  EXPECT_THROW(l.back_propagation(data.in_buf(), data.out_buf(),
+                                  grad.out_buf(), grad.in_buf()),
+               nn_error);
+}
+
 }  // namespace tiny_dnn
@@ -6,6 +6,8 @@
     in the LICENSE file.
 */
 #pragma once
+#include <numeric>
+#include <vector>
 #include "gtest/gtest.h"
 #include "testhelper.h"
 #include "tiny_dnn/tiny_dnn.h"
@@ -34,4 +36,55 @@ TEST(models, alexnet) {
   auto res = nn.predict(in);
 }
 
+TEST(models, lenet) {
+  models::lenet nn;
+  EXPECT_EQ(nn.in_data_size(), serial_size_t(32 * 32));
+  EXPECT_EQ(nn.out_data_size(), serial_size_t(10));
+
+  vec_t in(nn.in_data_size());
+  uniform_rand(in.begin(), in.end(), 0, 1);
+  EXPECT_EQ(nn.predict(in).size(), 10u);
+}
+
+// outputs of a softmax classifier over n_classes
+template <typename Net>
+void check_classifier(Net &nn, serial_size_t n_classes) {
+  EXPECT_EQ(nn.in_data_size(), serial_size_t(32 * 32 * 3));
+  EXPECT_EQ(nn.out_data_size(), n_classes);
+
+  vec_t in(nn.in_data_size());
+  uniform_rand(in.begin(), in.end(), 0, 1);
+  const vec_t out = nn.predict(in);
+  ASSERT_EQ(out.size(), n_classes);
+  EXPECT_NEAR(std::accumulate(out.begin(), out.end(), float_t(0)), 1, 1e-4);
+}
+
+TEST(models, vgg) {
+  models::vgg nn(5);
+  check_classifier(nn, 5);
+}
+
+TEST(models, resnet) {
+  models::resnet nn(1);  // 1 block per stage
+  check_classifier(nn, 10);
+
+  // conv, bn, relu, 3 stages of 1 block (2 convs, 2 bns, relu, add, relu
+  // and a shortcut conv for the last 2 stages), pooling, fc, softmax
+  EXPECT_EQ(nn.layer_size(), 3 + 3 * 7 + 2 + 3u);
+
+  // one training step goes through the shortcuts
+  std::vector<vec_t> x(2, vec_t(nn.in_data_size(), float_t(0.5)));
+  std::vector<vec_t> y(2, vec_t(10, float_t(0.1)));
+  momentum opt;
+  EXPECT_TRUE(nn.fit<mse>(opt, x, y, 2, 1));
+}
+
+TEST(models, mobilenet) {
+  models::mobilenet nn;
+  check_classifier(nn, 10);
+
+  // the depthwise convolutions only store one 3x3 filter per channel
+  EXPECT_EQ(nn[3]->in_shape()[1], shape3d(3, 3, 32));
+}
+
 }  // namespace tiny_dnn
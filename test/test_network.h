@@ -7,6 +7,7 @@
 */
 #pragma once
 #include <memory>
+#include <thread>
 #include "gtest/gtest.h"
 #include "testhelper.h"
 #include "tiny_dnn/tiny_dnn.h"
@@ -345,8 +346,72 @@ TEST(network, test) {
   }
 }
 
+TEST(network, test_batch_size) {
+  network<sequential> net;
+  net << fully_connected_layer(10, 20) << tanh() << fully_connected_layer(20, 4)
+      << softmax();
+  net.init_weight();
+
+  std::vector<vec_t> in;
+  std::vector<label_t> t;
+  for (int i = 0; i < 103; i++) {
+    vec_t v(10);
+    uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+    in.push_back(v);
+    t.push_back(static_cast<label_t>(i % 4));
+  }
+
+  // batched evaluation must give the same result as one-by-one prediction
+  result expected;
+  for (size_t i = 0; i < in.size(); i++) {
+    const label_t predicted = net.predict_label(in[i]);
+    if (predicted == t[i]) expected.num_success++;
+    expected.num_total++;
+    expected.confusion_matrix[predicted][t[i]]++;
+  }
+
+  for (size_t batch_size : {1, 7, 64, 200}) {
+    result res = net.test(in, t, batch_size);
+    EXPECT_EQ(res.num_success, expected.num_success);
+    EXPECT_EQ(res.num_total, expected.num_total);
+    EXPECT_EQ(res.confusion_matrix, expected.confusion_matrix);
+
+    auto out = net.test(in, batch_size);
+    ASSERT_EQ(out.size(), in.size());
+    for (size_t i = 0; i < in.size(); i++) {
+      vec_t p = net.predict(in[i]);
+      for (size_t j = 0; j < p.size(); j++) EXPECT_FLOAT_EQ(out[i][j], p[j]);
+    }
+  }
+
+  EXPECT_THROW(net.test(in, t, 0), nn_error);
+}
+
 TEST(network, get_loss) {
-  // TODO: add unit-test for public api
+  network<sequential> net;
+  net << fully_connected_layer(10, 3) << sigmoid();
+  net.init_weight();
+
+  std::vector<vec_t> in, t;
+  std::vector<tensor_t> t_tensor;
+  for (int i = 0; i < 50; i++) {
+    vec_t v(10), target(3);
+    uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+    uniform_rand(target.begin(), target.end(), 0.0, 1.0);
+    in.push_back(v);
+    t.push_back(target);
+    t_tensor.push_back(tensor_t{target});
+  }
+
+  float_t expected = float_t(0);
+  for (size_t i = 0; i < in.size(); i++) {
+    expected += mse::f(net.predict(in[i]), t[i]);
+  }
+
+  EXPECT_NEAR(net.get_loss<mse>(in, t), expected, 1e-4);
+  EXPECT_NEAR(net.get_loss<mse>(in, t, 8), expected, 1e-4);
+  EXPECT_NEAR(net.get_loss<mse>(in, t_tensor), expected, 1e-4);
+  EXPECT_NEAR(net.get_loss<mse>(in, t_tensor, 3), expected, 1e-4);
 }
 
 TEST(network, at) {
@@ -666,6 +731,522 @@ TEST(network, read_write) {
 
 #endif  // #ifndef CNN_NO_SERIALIZATION
 
+template <typename N>
+void make_weights_file_net(N &net) {
+  net << convolutional_layer(8, 8, 3, 2, 4) << tanh()
+      << average_pooling_layer(6, 6, 4, 2) << fully_connected_layer(36, 3)
+      << softmax();
+}
+
+TEST(network, weights_file) {
+  network<sequential> n1, n2;
+  make_weights_file_net(n1);
+  make_weights_file_net(n2);
+  n1.init_weight();
+
+  const std::string path = unique_path();
+  n1.save_weights_file(path);
+  n2.load_weights_file(path, weights_map_mode::read_only);
+  std::remove(path.c_str());  // the mapping outlives the file name
+
+  EXPECT_TRUE(n1.has_same_weights(n2, float_t(0)));
+  for (auto l : n2) {
+    for (auto w : static_cast<const layer *>(l)->weights()) {
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(w->data()) % 64, 0u);
+    }
+  }
+
+  vec_t in(8 * 8 * 2);
+  uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+  EXPECT_EQ(n1.predict(in), n2.predict(in));
+}
+
+TEST(network, weights_file_copy_on_write) {
+  network<sequential> n1, n2, n3;
+  make_weights_file_net(n1);
+  make_weights_file_net(n2);
+  make_weights_file_net(n3);
+  n1.init_weight();
+
+  const std::string path = unique_path();
+  n1.save_weights_file(path);
+  n2.load_weights_file(path);  // copy_on_write by default
+
+  std::vector<vec_t> data(4, vec_t(8 * 8 * 2));
+  for (auto &d : data) uniform_rand(d.begin(), d.end(), -1.0, 1.0);
+  std::vector<label_t> labels{0, 1, 2, 0};
+  adagrad optimizer;
+  n2.train<mse>(optimizer, data, labels, 2, 1);
+  EXPECT_FALSE(n1.has_same_weights(n2, float_t(0)));
+
+  // training modified private copies, not the file
+  n3.load_weights_file(path, weights_map_mode::read_only);
+  EXPECT_TRUE(n1.has_same_weights(n3, float_t(0)));
+
+  n2.load_weights_file(path);
+  n2.init_weight();
+  std::remove(path.c_str());
+  EXPECT_FALSE(n1.has_same_weights(n2, float_t(0)));
+}
+
+TEST(network, weights_file_mismatch) {
+  network<sequential> n1, n2;
+  make_weights_file_net(n1);
+  n2 << fully_connected_layer(10, 3);
+  n1.init_weight();
+
+  const std::string path = unique_path();
+  n1.save_weights_file(path);
+  EXPECT_THROW(n2.load_weights_file(path), nn_error);
+
+  {
+    std::ofstream ofs(path.c_str(), std::ios::binary);
+    ofs << "not a weights file, but long enough to hold a header ........";
+  }
+  EXPECT_THROW(n1.load_weights_file(path), nn_error);
+  std::remove(path.c_str());
+}
+
+template <typename N>
+void copy_weights(N &src, N &dst) {
+  src.init_weight();
+  dst.init_weight();
+  for (size_t i = 0; i < src.depth(); i++) {
+    auto w1 = src[i]->weights();
+    auto w2 = dst[i]->weights();
+    for (size_t j = 0; j < w1.size(); j++) *w2[j] = *w1[j];
+  }
+}
+
+TEST(network, memory_planning) {
+  network<sequential> n1, n2;
+  for (auto n : {&n1, &n2}) {
+    *n << fully_connected_layer(16, 64) << relu()
+       << fully_connected_layer(64, 64) << relu()
+       << fully_connected_layer(64, 64) << relu()
+       << fully_connected_layer(64, 8) << softmax();
+  }
+  copy_weights(n1, n2);
+  n2.set_memory_planning(true);
+
+  std::vector<vec_t> in(5, vec_t(16));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  EXPECT_EQ(n1.test(in, 5), n2.test(in, 5));
+  EXPECT_EQ(n1.predict(in[0]), n2.predict(in[0]));  // replanned for 1 sample
+
+  // 9 activations, but no more than 3 are alive at the same time
+  size_t total = 0;
+  for (auto l : n2) total += l->out_data_size() * sizeof(float_t);
+  EXPECT_GT(n2.planned_memory_size(), 0u);
+  EXPECT_LE(n2.planned_memory_size(), 3 * 64 * sizeof(float_t));
+  EXPECT_LT(n2.planned_memory_size(), total / 2);
+
+  // the planner never applies to training
+  std::vector<label_t> labels(in.size(), 1);
+  adagrad optimizer;
+  n1.train<mse>(optimizer, in, labels, 5, 1);
+  n2.train<mse>(optimizer, in, labels, 5, 1);
+  EXPECT_TRUE(n1.has_same_weights(n2, float_t(1e-5)));
+  EXPECT_EQ(n2.planned_memory_size(), 0u);
+  EXPECT_TRUE(is_near_container(n1.predict(in[0]), n2.predict(in[0]),
+                                float_t(1e-5)));
+}
+
+TEST(network, memory_planning_graph) {
+  // two convolution branches joined by concat
+  network<graph> nets[2];
+  std::vector<std::shared_ptr<layer>> layers;  // graph doesn't own layers
+  for (auto &net : nets) {
+    auto in    = std::make_shared<input_layer>(shape3d(8, 8, 1));
+    auto conv1 = std::make_shared<convolutional_layer>(8, 8, 3, 1, 4,
+                                                       padding::same);
+    auto conv2 = std::make_shared<convolutional_layer>(8, 8, 5, 1, 4,
+                                                       padding::same);
+    auto conc = std::make_shared<concat_layer>(
+      std::vector<shape3d>{shape3d(8, 8, 4), shape3d(8, 8, 4)});
+    auto act = std::make_shared<tanh_layer>(8, 8, 8);
+    auto fc  = std::make_shared<fully_connected_layer>(8 * 8 * 8, 3);
+
+    in << conv1;
+    in << conv2;
+    (conv1, conv2) << conc << act << fc;
+    construct_graph(net, {in}, {fc});
+    layers.insert(layers.end(), {in, conv1, conv2, conc, act, fc});
+  }
+  copy_weights(nets[0], nets[1]);
+  nets[1].set_memory_planning(true);
+
+  std::vector<vec_t> in(3, vec_t(8 * 8));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  EXPECT_EQ(nets[0].test(in, 3), nets[1].test(in, 3));
+  EXPECT_GT(nets[1].planned_memory_size(), 0u);
+}
+
+#if !defined(CNN_USE_TBB) && !defined(CNN_USE_OMP) && \
+  !defined(CNN_USE_GCD) && !defined(CNN_SINGLE_THREAD)
+TEST(network, concurrent_branches) {
+  // fc0 feeds three branches which run concurrently, and whose gradients
+  // all go to the output of fc0
+  network<graph> nets[2];
+  std::vector<std::shared_ptr<layer>> layers;  // graph doesn't own layers
+  for (auto &net : nets) {
+    auto in  = std::make_shared<input_layer>(shape3d(16, 1, 1));
+    auto fc0 = std::make_shared<fully_connected_layer>(16, 16);
+    auto fc1 = std::make_shared<fully_connected_layer>(16, 8);
+    auto fc2 = std::make_shared<fully_connected_layer>(16, 8);
+    auto fc3 = std::make_shared<fully_connected_layer>(16, 8);
+    auto conc = std::make_shared<concat_layer>(std::vector<shape3d>{
+      shape3d(8, 1, 1), shape3d(8, 1, 1), shape3d(8, 1, 1)});
+    auto act = std::make_shared<tanh_layer>(24, 1, 1);
+    auto out = std::make_shared<fully_connected_layer>(24, 3);
+
+    in << fc0;
+    fc0 << fc1;
+    fc0 << fc2;
+    fc0 << fc3;
+    (fc1, fc2, fc3) << conc << act << out;
+    construct_graph(net, {in}, {out});
+    layers.insert(layers.end(), {in, fc0, fc1, fc2, fc3, conc, act, out});
+  }
+  copy_weights(nets[0], nets[1]);
+
+  std::vector<vec_t> in(8, vec_t(16));
+  std::vector<label_t> labels(in.size());
+  for (size_t i = 0; i < in.size(); i++) {
+    uniform_rand(in[i].begin(), in[i].end(), -1.0, 1.0);
+    labels[i] = i % 3;
+  }
+
+  const size_t threads = num_threads();
+  adagrad optimizers[2];
+  std::vector<vec_t> results[2];
+  for (size_t i = 0; i < 2; i++) {
+    set_num_threads(i == 0 ? 1 : 4);  // nets[0] runs sequentially
+    results[i] = nets[i].test(in);
+    nets[i].train<mse>(optimizers[i], in, labels, 4, 2);
+  }
+  set_num_threads(threads);
+
+  for (size_t i = 0; i < in.size(); i++) {
+    EXPECT_TRUE(is_near_container(results[0][i], results[1][i], float_t(0)));
+  }
+  EXPECT_TRUE(nets[0].has_same_weights(nets[1], float_t(1e-5)));
+}
+#endif
+
+#if !defined(CNN_USE_TBB) && !defined(CNN_USE_OMP) && \
+  !defined(CNN_USE_GCD) && !defined(CNN_SINGLE_THREAD)
+TEST(network, single_sample_uses_all_threads) {
+  // a single sample is split inside the kernels into chunks run by the
+  // thread pool, which must not change the result
+  std::vector<backend_t> backends = {backend_t::internal, backend_t::gemm};
+#ifdef CNN_USE_AVX
+  backends.push_back(backend_t::avx);
+#endif
+  for (auto backend : backends) {
+    const backend_t pool_backend =
+      backend == backend_t::gemm ? backend_t::internal : backend;
+    network<sequential> net;
+    net << convolutional_layer(12, 12, 5, 2, 6, padding::valid, true, 1, 1,
+                               backend)
+        << relu() << max_pooling_layer(8, 8, 6, 2, pool_backend)
+        << convolutional_layer(4, 4, 3, 6, 4, padding::same, true, 1, 1,
+                               backend)
+        << average_pooling_layer(4, 4, 4, 2)
+        << fully_connected_layer(16, 200, true, backend) << tanh()
+        << fully_connected_layer(200, 10, true, backend);
+    net.init_weight();
+
+    vec_t in(12 * 12 * 2);
+    uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+
+    const size_t threads = num_threads();
+    set_num_threads(1);
+    const vec_t expected = net.predict(in);
+    set_num_threads(4);
+    tracer::instance().start();
+    const vec_t actual = net.predict(in);
+    tracer::instance().stop();
+    set_num_threads(threads);
+
+    EXPECT_TRUE(is_near_container(expected, actual, float_t(1e-6)));
+
+    // chunks recorded while each conv and fc layer ran forward. the last fc
+    // has fewer outputs than one gemm micro-tile, so it runs in one piece
+    const auto events = tracer::instance().events();
+    std::vector<size_t> chunks;
+    for (const auto &l : events) {
+      const std::string type = l.second.name;
+      if (std::string(l.second.category) != "forward" ||
+          (type != "conv" && type != "fully-connected")) {
+        continue;
+      }
+      size_t n = 0;
+      for (const auto &c : events) {
+        if (std::string(c.second.category) == "parallel_for" &&
+            c.second.begin_ns >= l.second.begin_ns &&
+            c.second.end_ns <= l.second.end_ns) {
+          n++;
+        }
+      }
+      chunks.push_back(n);
+    }
+    ASSERT_EQ(chunks.size(), 4u);
+    for (size_t i = 0; i < 3; i++) {
+      EXPECT_GT(chunks[i], 1u) << "layer " << i << " " << to_string(backend);
+    }
+  }
+}
+#endif
+
+TEST(network, optimize_for_inference) {
+  network<sequential> net;
+  batch_normalization_layer bn1(8 * 8, 4), bn2(1, 16);
+  net << convolutional_layer(8, 8, 3, 1, 4, padding::same) << bn1 << relu()
+      << fully_connected_layer(8 * 8 * 4, 16) << bn2 << tanh()
+      << dropout_layer(16, 0.5) << fully_connected_layer(16, 3) << softmax();
+  net.init_weight();
+
+  // moving averages far from (0, 1), so that the folding matters
+  for (auto bn : {&bn1, &bn2}) {
+    vec_t mean(bn->in_shape()[0].depth_), variance(mean.size());
+    uniform_rand(mean.begin(), mean.end(), -1.0, 1.0);
+    uniform_rand(variance.begin(), variance.end(), 0.5, 2.0);
+    bn->set_mean(mean);
+    bn->set_variance(variance);
+  }
+
+  std::vector<vec_t> in(4, vec_t(8 * 8));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  const std::vector<vec_t> expected = net.test(in);
+
+  net.optimize_for_inference();
+  // conv + bn + relu, fc + bn + tanh, fc + softmax
+  ASSERT_EQ(net.depth(), 3u);
+  EXPECT_EQ(net[0]->layer_type(), "conv");
+  EXPECT_EQ(net[1]->layer_type(), "fully-connected");
+  EXPECT_EQ(net[2]->layer_type(), "fully-connected");
+
+  const std::vector<vec_t> actual = net.test(in);
+  for (size_t i = 0; i < in.size(); i++) {
+    EXPECT_TRUE(is_near_container(expected[i], actual[i], float_t(1e-5)));
+  }
+
+  std::vector<label_t> labels(in.size(), 0);
+  adagrad optimizer;
+  EXPECT_THROW(net.train<mse>(optimizer, in, labels, 4, 1), nn_error);
+}
+
+TEST(network, optimize_for_inference_graph) {
+  // fc0 -> tanh is fused, fc1 has two consumers and is kept as is
+  network<graph> net;
+  auto in   = std::make_shared<input_layer>(shape3d(16, 1, 1));
+  auto fc0  = std::make_shared<fully_connected_layer>(16, 8);
+  auto act0 = std::make_shared<tanh_layer>(8);
+  auto fc1  = std::make_shared<fully_connected_layer>(16, 8);
+  auto act1 = std::make_shared<relu_layer>(8);
+  auto act2 = std::make_shared<sigmoid_layer>(8);
+  auto conc = std::make_shared<concat_layer>(std::vector<shape3d>{
+    shape3d(8, 1, 1), shape3d(8, 1, 1), shape3d(8, 1, 1)});
+  auto drop = std::make_shared<dropout_layer>(24, 0.5);
+
+  in << fc0 << act0;
+  in << fc1;
+  fc1 << act1;
+  fc1 << act2;
+  (act0, act1, act2) << conc << drop;
+  construct_graph(net, {in}, {drop});
+
+  std::vector<vec_t> data(3, vec_t(16));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  const std::vector<vec_t> expected = net.test(data);
+
+  net.optimize_for_inference();
+  EXPECT_EQ(net.depth(), 6u);  // without act0 and drop
+  EXPECT_EQ(net.test(data), expected);
+}
+
+TEST(network, set_channel_block) {
+  network<sequential> net;
+  batch_normalization_layer bn(6 * 6, 24);
+  net << convolutional_layer(12, 12, 3, 3, 16, padding::same) << relu()
+      << max_pooling_layer(12, 12, 16, 2)
+      << convolutional_layer(6, 6, 3, 16, 24, padding::same) << bn
+      << elu() << global_average_pooling_layer(6, 6, 24)
+      << fully_connected_layer(24, 10) << softmax();
+  net.init_weight();
+
+  vec_t mean(24), variance(24);
+  uniform_rand(mean.begin(), mean.end(), -1.0, 1.0);
+  uniform_rand(variance.begin(), variance.end(), 0.5, 2.0);
+  bn.set_mean(mean);
+  bn.set_variance(variance);
+
+  std::vector<vec_t> in(3, vec_t(12 * 12 * 3));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  const std::vector<vec_t> expected = net.test(in);
+
+  for (serial_size_t block : {8u, 16u, 32u}) {
+    net.set_channel_block(block);
+    // the input of the first convolution is reordered, the output of the
+    // global average pooling is a single pixel, the same in every layout
+    ASSERT_EQ(net.depth(), 10u);
+    EXPECT_EQ(net[0]->layer_type(), "reorder");
+    EXPECT_EQ(net[1]->channel_block(), block);
+
+    const std::vector<vec_t> actual = net.test(in);
+    for (size_t i = 0; i < in.size(); i++) {
+      EXPECT_TRUE(is_near_container(expected[i], actual[i], float_t(1e-5)));
+    }
+  }
+
+  net.set_memory_planning(true);
+  const std::vector<vec_t> planned = net.test(in);
+  for (size_t i = 0; i < in.size(); i++) {
+    EXPECT_TRUE(is_near_container(expected[i], planned[i], float_t(1e-5)));
+  }
+  net.set_memory_planning(false);
+
+  std::vector<label_t> labels(in.size(), 0);
+  adagrad optimizer;
+  EXPECT_THROW(net.train<mse>(optimizer, in, labels, 3, 1), nn_error);
+
+  net.set_channel_block(1);
+  ASSERT_EQ(net.depth(), 9u);
+  EXPECT_EQ(net[0]->channel_block(), 1u);
+  EXPECT_TRUE(net.train<mse>(optimizer, in, labels, 3, 1));
+}
+
+TEST(network, set_channel_block_planar_consumer) {
+  // fc reads the blocked output of the convolution through tanh, which
+  // keeps the layout of its input
+  network<sequential> net;
+  net << convolutional_layer(5, 5, 3, 1, 12, padding::same) << tanh()
+      << fully_connected_layer(5 * 5 * 12, 4);
+  net.init_weight();
+
+  std::vector<vec_t> in(2, vec_t(5 * 5));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  const std::vector<vec_t> expected = net.test(in);
+
+  net.set_channel_block(8);
+  ASSERT_EQ(net.depth(), 4u);
+  EXPECT_EQ(net[2]->layer_type(), "reorder");
+  const std::vector<vec_t> actual = net.test(in);
+  for (size_t i = 0; i < in.size(); i++) {
+    EXPECT_TRUE(is_near_container(expected[i], actual[i], float_t(1e-5)));
+  }
+}
+
+TEST(network, set_channel_block_graph) {
+  // conv0 feeds a convolution and a pooling layer, both outputs of the
+  // network, which are reordered back to planar
+  network<graph> net;
+  auto in    = std::make_shared<input_layer>(shape3d(8, 8, 3));
+  auto conv0 = std::make_shared<convolutional_layer>(8, 8, 3, 3, 10,
+                                                     padding::same);
+  auto act   = std::make_shared<relu_layer>(shape3d(8, 8, 10));
+  auto conv1 = std::make_shared<convolutional_layer>(8, 8, 3, 10, 10,
+                                                     padding::same);
+  auto pool  = std::make_shared<max_pooling_layer>(8, 8, 10, 2);
+
+  in << conv0 << act << conv1;
+  act << pool;
+  construct_graph(net, {in}, {conv1, pool});
+  net.init_weight();
+
+  std::vector<tensor_t> data(2, tensor_t{vec_t(8 * 8 * 3)});
+  for (auto &t : data) uniform_rand(t[0].begin(), t[0].end(), -1.0, 1.0);
+  const std::vector<tensor_t> expected = net.predict(data);
+
+  net.set_channel_block(8);
+  EXPECT_EQ(net.depth(), 8u);
+  const std::vector<tensor_t> actual = net.predict(data);
+  for (size_t i = 0; i < data.size(); i++) {
+    for (size_t j = 0; j < 2; j++) {
+      EXPECT_TRUE(
+        is_near_container(expected[i][j], actual[i][j], float_t(1e-5)));
+    }
+  }
+
+  net.set_channel_block(1);
+  EXPECT_EQ(net.depth(), 5u);
+  EXPECT_EQ(net.predict(data), expected);
+}
+
+TEST(network, concurrent_predict) {
+  network<sequential> net;
+  net << convolutional_layer(8, 8, 3, 2, 4) << batch_normalization_layer(36, 4)
+      << relu() << max_pooling_layer(6, 6, 4, 2) << dropout_layer(36, 0.5)
+      << fully_connected_layer(36, 5) << softmax();
+  net.init_weight();
+
+  std::vector<vec_t> data(16, vec_t(128));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  const std::vector<vec_t> expected = net.test(data);
+
+  std::vector<execution_context<sequential>> contexts;
+  for (int t = 0; t < 4; t++) contexts.push_back(net.make_context());
+
+  std::vector<std::vector<vec_t>> out(4, std::vector<vec_t>(data.size()));
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < contexts.size(); t++) {
+    threads.emplace_back([&, t]() {
+      for (int round = 0; round < 5; round++) {
+        for (size_t i = 0; i < data.size(); i++) {
+          out[t][i] = net.predict(contexts[t], data[i]);
+        }
+      }
+    });
+  }
+  for (auto &t : threads) t.join();
+
+  for (size_t t = 0; t < out.size(); t++) EXPECT_EQ(out[t], expected);
+}
+
+TEST(network, concurrent_predict_optimized_graph) {
+  network<graph> net;
+  auto in   = std::make_shared<input_layer>(shape3d(16, 1, 1));
+  auto fc0  = std::make_shared<fully_connected_layer>(16, 8);
+  auto act0 = std::make_shared<tanh_layer>(8);
+  auto fc1  = std::make_shared<fully_connected_layer>(16, 8);
+  auto act1 = std::make_shared<relu_layer>(8);
+  auto add  = std::make_shared<elementwise_add_layer>(2, 8);
+
+  in << fc0 << act0;
+  in << fc1 << act1;
+  (act0, act1) << add;
+  construct_graph(net, {in}, {add});
+
+  std::vector<vec_t> data(8, vec_t(16));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  const std::vector<vec_t> expected = net.test(data);
+
+  net.optimize_for_inference();
+  auto ctx0 = net.make_context();
+  auto ctx1 = net.make_context();
+
+  std::vector<vec_t> out0(data.size()), out1(data.size());
+  std::thread t0([&]() {
+    for (size_t i = 0; i < data.size(); i++) {
+      out0[i] = net.predict(ctx0, data[i]);
+    }
+  });
+  std::thread t1([&]() {
+    for (size_t i = 0; i < data.size(); i++) {
+      out1[i] = net.predict(ctx1, data[i]);
+    }
+  });
+  t0.join();
+  t1.join();
+  EXPECT_EQ(out0, expected);
+  EXPECT_EQ(out1, expected);
+
+  network<graph> other;
+  EXPECT_THROW(other.predict(ctx0, data[0]), nn_error);
+}
+
 TEST(network, trainable) {
   auto net = make_mlp<sigmoid>({2, 3, 2, 1});  // fc(2,3) - fc(3,2) - fc(2,1)
 
@@ -165,4 +165,77 @@ TEST(layer_tuple, chain_operator_layer_tuple2) {
   EXPECT_EQ(slice->next_nodes()[1], relu.get());
   EXPECT_EQ(slice->next_nodes()[2], elu.get());
 }
+
+TEST(edge, contiguous_batch) {
+  fully_connected_layer fc(10, 3);
+
+  tensor_t in(4, vec_t(10));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const tensor_t *> out;
+  fc.forward({in}, out);
+
+  for (auto &e : fc.inputs()) {
+    EXPECT_TRUE(is_contiguous_batch(*e->get_gradient()));
+  }
+  EXPECT_TRUE(is_contiguous_batch(*fc.inputs()[0]->get_data()));
+  EXPECT_TRUE(is_contiguous_batch(*fc.outputs()[0]->get_data()));
+  EXPECT_TRUE(is_contiguous_batch(*fc.outputs()[0]->get_gradient()));
+  EXPECT_EQ(out[0]->size(), 4u);
+  EXPECT_EQ(*fc.inputs()[0]->get_data(), in);
+}
+
+TEST(edge, resize_batch) {
+  tensor_t t = {vec_t{1, 2, 3}};
+
+  resize_batch(t, 5);
+  ASSERT_EQ(t.size(), 5u);
+  EXPECT_TRUE(is_contiguous_batch(t));
+  for (auto &v : t) EXPECT_EQ(v, vec_t({1, 2, 3}));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(t[0].data()) % 64, 0u);
+
+  // shrinking keeps the buffer
+  t[1][0]             = 7;
+  const float_t *base = t[0].data();
+  resize_batch(t, 2);
+  ASSERT_EQ(t.size(), 2u);
+  EXPECT_EQ(t[0].data(), base);
+  EXPECT_EQ(t[1][0], float_t(7));
+
+  // a copy owns its own memory
+  tensor_t copy = t;
+  copy[0][0]    = 42;
+  EXPECT_EQ(t[0][0], float_t(1));
+  EXPECT_NE(copy[0].data(), t[0].data());
+
+  // a sample that outgrows its slot moves out of the batch buffer
+  t[0].resize(100, 0);
+  EXPECT_FALSE(is_contiguous_batch(t));
+  EXPECT_EQ(t[1][0], float_t(7));
+  t[0].resize(3);
+  resize_batch(t, 2);
+  EXPECT_TRUE(is_contiguous_batch(t));
+}
+
+TEST(edge, insert_into_bound_vec) {
+  typedef vec_t::allocator_type allocator;
+  auto block = allocator::make_block(8);
+
+  vec_t v(allocator::bind(block, 0, 8));
+  v.reserve(2);
+  v.push_back(1);
+  v.push_back(2);
+  ASSERT_EQ(v.data(), block.get());
+
+  // the new storage still fits in the slice, but the old elements are in it
+  v.insert(v.begin(), 0);
+  EXPECT_EQ(v, vec_t({0, 1, 2}));
+  EXPECT_NE(v.data(), block.get());
+
+  // the insert released the slice, so it can be handed out again
+  v.reserve(8);
+  EXPECT_EQ(v.data(), block.get());
+  EXPECT_EQ(v, vec_t({0, 1, 2}));
+}
+
 }  // namespace tiny_dnn
@@ -0,0 +1,94 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+
+TEST(profiler, records_every_layer_call) {
+  network<sequential> net;
+  net << convolutional_layer(8, 8, 3, 1, 2) << relu()
+      << max_pooling_layer(6, 6, 2, 2) << fully_connected_layer(18, 3);
+
+  std::vector<vec_t> data(4, vec_t(64));
+  std::vector<vec_t> target(4, vec_t(3));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  profiler prof;
+  net.set_profiler(&prof);
+  adagrad opt;
+  net.fit<mse>(opt, data, target, 2, 1);  // 2 batches
+  net.predict(data[0]);
+  net.set_profiler(nullptr);
+  net.predict(data[0]);  // not recorded
+
+  const std::vector<profiler::layer_stats> layers = prof.layers();
+  ASSERT_EQ(layers.size(), 4u);
+  const char *types[] = {"conv", "relu-activation", "max-pool",
+                         "fully-connected"};
+  for (size_t i = 0; i < layers.size(); i++) {
+    const auto &l = layers[i];
+    EXPECT_EQ(l.index, i);
+    EXPECT_EQ(l.layer_type, types[i]);
+    EXPECT_EQ(l.engine, to_string(net[i]->engine()));
+    EXPECT_EQ(l[profile_phase::forward].calls, 3u);
+    EXPECT_EQ(l[profile_phase::backward].calls, 2u);
+    EXPECT_EQ(l[profile_phase::update].calls, 2u);
+    EXPECT_GE(l.seconds(), 0.0);
+  }
+
+  // conv: 2 * (3 * 3 * 1) MACs for each of the 6 * 6 * 2 outputs + bias,
+  // 2 samples per batch and 1 for the prediction
+  EXPECT_EQ(layers[0][profile_phase::forward].flops,
+            uint64_t(5) * (2 * 9 * 72 + 72));
+  EXPECT_EQ(layers[3][profile_phase::forward].flops,
+            uint64_t(5) * (2 * 18 * 3 + 3));
+  EXPECT_EQ(layers[3][profile_phase::update].bytes,
+            uint64_t(2) * 3 * (18 * 3 + 3) * sizeof(float_t));
+
+  std::ostringstream table;
+  prof.print(table);
+  EXPECT_NE(table.str().find("fully-connected"), std::string::npos);
+
+  const std::string json = prof.to_json();
+  EXPECT_EQ(json.find("{\"layers\":[{\"index\":0,\"type\":\"conv\""), 0u);
+  EXPECT_NE(json.find("\"backward\":{\"calls\":2"), std::string::npos);
+
+  prof.reset();
+  EXPECT_TRUE(prof.layers().empty());
+}
+
+TEST(aligned_heap_usage, counts_live_and_peak_bytes) {
+  aligned_heap_usage &usage = aligned_heap_usage::instance();
+  const uint64_t before     = usage.bytes();
+  usage.reset_peak();
+  EXPECT_EQ(usage.peak_bytes(), before);
+
+  {
+    vec_t v(1000);
+    EXPECT_EQ(usage.bytes(), before + 1000 * sizeof(float_t));
+    {
+      auto block = aligned_allocator<float_t, 64>::make_block(500);
+      EXPECT_EQ(usage.bytes(), before + 1500 * sizeof(float_t));
+
+      // containers living in the block add nothing
+      vec_t slice(500, aligned_allocator<float_t, 64>::bind(block, 0, 500));
+      EXPECT_EQ(usage.bytes(), before + 1500 * sizeof(float_t));
+    }
+    EXPECT_EQ(usage.bytes(), before + 1000 * sizeof(float_t));
+  }
+  EXPECT_EQ(usage.bytes(), before);
+  EXPECT_EQ(usage.peak_bytes(), before + 1500 * sizeof(float_t));
+}
+
+}  // namespace tiny_dnn
@@ -111,6 +111,34 @@ TEST(quantized_deconvolutional, fprop) {
   // clang-format on
 }
 
+TEST(quantized_deconvolutional, weights_cache) {
+  quantized_deconvolutional_layer l(2, 2, 3, 1, 2);
+  l.weight_init(weight_init::constant(0.5));
+  l.bias_init(weight_init::constant(0.0));
+
+  vec_t in = {1, 2, 3, 4};
+
+  auto fprop = [&]() {
+    std::vector<const tensor_t *> o;
+    l.forward({{in}}, o);
+    return (*o[0])[0];
+  };
+
+  // quantized weights are reused while the weights are unchanged
+  vec_t out1 = fprop();
+  vec_t out2 = fprop();
+  for (size_t i = 0; i < out1.size(); i++) {
+    EXPECT_FLOAT_EQ(out1[i], out2[i]);
+  }
+
+  // mutable access through weights() invalidates the cache
+  for (auto &w : *l.weights()[0]) w = float_t(0.25);
+  vec_t out3 = fprop();
+  for (size_t i = 0; i < out3.size(); i++) {
+    EXPECT_NEAR(out1[i] * float_t(0.5), out3[i], 5E-2);
+  }
+}
+
 TEST(quantized_deconvolutional, fprop2) {
   quantized_deconvolutional_layer l(2, 2, 3, 1, 2, padding::same);
 
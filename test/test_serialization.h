@@ -183,6 +183,69 @@ TEST(serialization, serialize_conv) {
   EXPECT_EQ(net[0]->out_shape()[0], shape3d(10, 10, 5));
 }
 
+TEST(serialization, serialize_conv_groups) {
+  network<sequential> net1, net2;
+  net1 << convolutional_layer(8, 8, 3, 3, 6, 4, 2, padding::same)
+       << convolutional_layer(8, 8, 3, 3, 4, 4, 4, padding::valid, true, 2, 2);
+
+  net2.from_json(net1.to_json());
+
+  for (size_t i = 0; i < net1.layer_size(); i++) {
+    EXPECT_EQ(net1[i]->in_shape(), net2[i]->in_shape());
+    EXPECT_EQ(net1[i]->out_shape(), net2[i]->out_shape());
+  }
+  EXPECT_EQ(net2.at<convolutional_layer>(0).groups(), 2u);
+  EXPECT_EQ(net2.at<convolutional_layer>(1).groups(), 4u);
+  EXPECT_EQ(net2[1]->in_shape()[1], shape3d(3, 3, 4));
+}
+
+TEST(serialization, load_binary_model_without_format_version) {
+  // conv(6x6x2 -> 3, 3x3 same) -> max-pool -> fc(27, 4), saved as a binary
+  // model before the format version and the "groups" of convolutions
+  // clang-format off
+  const unsigned char model[] = {
+  0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x63, 0x6f, 0x6e, 0x76, 0x06, 0x00, 0x00, 0x00,
+  0x06, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x61, 0x6c, 0x6c, 0x01, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x6d, 0x61, 0x78, 0x70, 0x6f, 0x6f, 0x6c, 0x06, 0x00, 0x00, 0x00, 0x06,
+  0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02,
+  0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x66,
+  0x75, 0x6c, 0x6c, 0x79, 0x5f, 0x63, 0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74,
+  0x65, 0x64, 0x1b, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x01
+  };
+  // clang-format on
+  auto path = unique_path();
+  {
+    std::ofstream ofs(path.c_str(), std::ios::binary);
+    ofs.write(reinterpret_cast<const char *>(model), sizeof(model));
+  }
+
+  network<sequential> net;
+  net.load(path, content_type::model, file_format::binary);
+  ASSERT_EQ(net.layer_size(), 3u);
+  EXPECT_EQ(net[0]->layer_type(), "conv");
+  EXPECT_EQ(net.at<convolutional_layer>(0).groups(), 1u);
+  EXPECT_EQ(net[0]->in_shape()[0], shape3d(6, 6, 2));
+  EXPECT_EQ(net[0]->out_shape()[0], shape3d(6, 6, 3));
+  EXPECT_EQ(net[1]->layer_type(), "max-pool");
+  EXPECT_EQ(net[2]->layer_type(), "fully-connected");
+  EXPECT_EQ(net[2]->out_shape()[0], shape3d(4, 1, 1));
+
+  // saved again with the current format, grouped layers included
+  network<sequential> net2, net3;
+  net2 << convolutional_layer(6, 6, 3, 3, 4, 4, 4, padding::same)
+       << fully_connected_layer(6 * 6 * 4, 2);
+  net2.save(path, content_type::model, file_format::binary);
+  net3.load(path, content_type::model, file_format::binary);
+  EXPECT_EQ(net3.at<convolutional_layer>(0).groups(), 4u);
+  EXPECT_EQ(net3[1]->in_shape()[0], shape3d(6 * 6 * 4, 1, 1));
+}
+
 TEST(serialization, serialize_deconv) {
   network<sequential> net;
 
@@ -0,0 +1,154 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+#include "tiny_dnn/util/thread_pool.h"
+
+namespace tiny_dnn {
+
+template <typename Func>
+void run_on_pool(thread_pool &pool,
+                 size_t begin,
+                 size_t end,
+                 size_t grainsize,
+                 const Func &f) {
+  pool.run(begin, end, grainsize,
+           [](const void *ctx, size_t b, size_t e) {
+             (*static_cast<const Func *>(ctx))(b, e);
+           },
+           &f);
+}
+
+TEST(thread_pool, visits_each_index_once) {
+  thread_pool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4u);
+
+  for (size_t n : {0, 1, 3, 7, 100, 1013}) {
+    std::vector<std::atomic<int>> visited(n);
+    for (auto &v : visited) v = 0;
+
+    run_on_pool(pool, 0, n, 1, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; i++) visited[i]++;
+    });
+
+    for (size_t i = 0; i < n; i++) EXPECT_EQ(visited[i].load(), 1);
+  }
+}
+
+TEST(thread_pool, respects_grainsize) {
+  thread_pool pool(4);
+  std::atomic<size_t> min_chunk(1000);
+
+  run_on_pool(pool, 0, 1000, 64, [&](size_t b, size_t e) {
+    // only the last chunk may be smaller than grainsize
+    if (e != 1000) {
+      size_t cur = min_chunk.load();
+      while (e - b < cur && !min_chunk.compare_exchange_weak(cur, e - b)) {
+      }
+    }
+  });
+  EXPECT_GE(min_chunk.load(), 64u);
+}
+
+TEST(thread_pool, nested) {
+  thread_pool pool(3);
+  std::atomic<int> sum(0);
+
+  run_on_pool(pool, 0, 16, 1, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; i++) {
+      run_on_pool(pool, 0, 16, 1, [&](size_t b2, size_t e2) {
+        sum += static_cast<int>(e2 - b2);
+      });
+    }
+  });
+  EXPECT_EQ(sum.load(), 16 * 16);
+}
+
+TEST(thread_pool, external_caller_runs_only_its_chunks) {
+  thread_pool pool(2);
+  std::atomic<bool> started(false);
+  std::atomic<int> stolen(0);
+  std::thread::id main_id = std::this_thread::get_id();
+
+  // a slow job from another thread keeps chunks queued for a while
+  std::thread other([&] {
+    run_on_pool(pool, 0, 8, 1, [&](size_t, size_t) {
+      started = true;
+      if (std::this_thread::get_id() == main_id) stolen++;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+  });
+  while (!started) std::this_thread::yield();
+
+  std::atomic<int> count(0);
+  run_on_pool(pool, 0, 100, 1,
+              [&](size_t b, size_t e) { count += static_cast<int>(e - b); });
+  other.join();
+
+  EXPECT_EQ(count.load(), 100);
+  EXPECT_EQ(stolen.load(), 0);
+}
+
+TEST(thread_pool, propagates_exception) {
+  thread_pool pool(4);
+  EXPECT_THROW(run_on_pool(pool, 0, 100, 1,
+                           [](size_t b, size_t) {
+                             if (b == 0) throw nn_error("failed");
+                           }),
+               nn_error);
+
+  // pool is still usable after an exception
+  std::atomic<int> count(0);
+  run_on_pool(pool, 0, 100, 1,
+              [&](size_t b, size_t e) { count += static_cast<int>(e - b); });
+  EXPECT_EQ(count.load(), 100);
+}
+
+TEST(thread_pool, resize) {
+  thread_pool pool(2);
+  pool.resize(5);
+  EXPECT_EQ(pool.num_threads(), 5u);
+  pool.resize(1);
+  EXPECT_EQ(pool.num_threads(), 1u);
+
+  std::atomic<int> count(0);
+  run_on_pool(pool, 0, 10, 1,
+              [&](size_t b, size_t e) { count += static_cast<int>(e - b); });
+  EXPECT_EQ(count.load(), 10);
+}
+
+TEST(thread_pool, for_i_slots) {
+  for (size_t slots : {1, 3, 8}) {
+    const size_t n = 7;
+    std::vector<std::atomic<int>> visited(n);
+    std::vector<std::atomic<int>> owner(n);
+    for (auto &v : visited) v = 0;
+
+    for_i_slots(true, n, slots, [&](size_t i, size_t slot) {
+      visited[i]++;
+      owner[i] = static_cast<int>(slot);
+    });
+
+    // every index is visited once, and each slot owns a contiguous range
+    for (size_t i = 0; i < n; i++) {
+      EXPECT_EQ(visited[i].load(), 1);
+      EXPECT_LT(owner[i].load(), static_cast<int>(slots));
+      if (i > 0) {
+        EXPECT_LE(owner[i - 1].load(), owner[i].load());
+      }
+    }
+  }
+}
+
+}  // namespace tiny_dnn
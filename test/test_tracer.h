@@ -0,0 +1,92 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+
+TEST(tracer, records_layers_and_chunks) {
+  network<sequential> net;
+  net << fully_connected_layer(16, 8) << tanh_layer(8)
+      << fully_connected_layer(8, 2);
+
+  std::vector<vec_t> data(4, vec_t(16));
+  std::vector<vec_t> target(4, vec_t(2));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  tracer &t = tracer::instance();
+  t.start();
+  adagrad opt;
+  net.fit<mse>(opt, data, target, 4, 1);
+  {
+    trace_scope user("user", "custom", 3, 5);
+  }
+  t.stop();
+  net.predict(data[0]);  // not recorded
+
+  size_t forward = 0, backward = 0, update = 0, chunks = 0, custom = 0;
+  for (const auto &te : t.events()) {
+    const tracer::event &e = te.second;
+    const std::string cat  = e.category;
+    EXPECT_LE(e.begin_ns, e.end_ns);
+    if (cat == "forward") forward++;
+    if (cat == "backward") backward++;
+    if (cat == "update") update++;
+    if (cat == "parallel_for") {
+      EXPECT_LT(e.arg0, e.arg1);
+      chunks++;
+    }
+    if (cat == "user") {
+      EXPECT_EQ(std::string(e.name), "custom");
+      EXPECT_EQ(e.arg0, 3);
+      EXPECT_EQ(e.arg1, 5);
+      custom++;
+    }
+  }
+  EXPECT_EQ(forward, 3u);
+  EXPECT_EQ(backward, 3u);
+  EXPECT_EQ(update, 3u);
+  EXPECT_EQ(custom, 1u);
+#if !defined(CNN_USE_TBB) && !defined(CNN_USE_OMP) && \
+  !defined(CNN_USE_GCD) && !defined(CNN_SINGLE_THREAD)
+  EXPECT_GT(chunks, 0u);
+#endif
+  EXPECT_EQ(t.dropped(), 0u);
+
+  const std::string json = t.to_json();
+  EXPECT_EQ(json.find("{\"traceEvents\":[{\"name\":"), 0u);
+  EXPECT_NE(json.find("\"name\":\"fully-connected\",\"cat\":\"forward\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"begin\":3,\"end\":5}"), std::string::npos);
+}
+
+TEST(tracer, ring_buffer_keeps_latest_events) {
+  tracer &t = tracer::instance();
+  t.start(4);
+  for (int i = 0; i < 10; i++) {
+    trace_scope s("test", "event", i, i + 1);
+  }
+  t.stop();
+
+  const auto events = t.events();
+  ASSERT_EQ(events.size(), 4u);
+  for (size_t i = 0; i < events.size(); i++) {
+    EXPECT_EQ(events[i].second.arg0, int64_t(6 + i));
+  }
+  EXPECT_EQ(t.dropped(), 6u);
+
+  t.start();  // a new trace drops the old events
+  t.stop();
+  EXPECT_TRUE(t.events().empty());
+}
+
+}  // namespace tiny_dnn
@@ -226,6 +226,43 @@ std::pair<std::vector<tensor_t>,
 }
 }  // namespace
 
+// the samples of t (of shape s) moved from channel block from to to
+inline tensor_t reorder_tensor(const shape3d &s,
+                               serial_size_t from,
+                               serial_size_t to,
+                               const tensor_t &t) {
+  tensor_t r(t.size(), vec_t(s.size()));
+  for (size_t i = 0; i < t.size(); i++) {
+    reorder_channel_blocks(s, from, to, &t[i][0], &r[i][0]);
+  }
+  return r;
+}
+
+// forward l with each channel block in blocks, and compare with the planar
+// output. l has a single data input and output, and its weights are set.
+inline void check_channel_blocks(layer &l,
+                                 const std::vector<serial_size_t> &blocks,
+                                 float_t eps = 1E-5) {
+  const shape3d in = l.in_shape()[0], out = l.out_shape()[0];
+  tensor_t x(3, vec_t(in.size()));
+  for (auto &v : x) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const tensor_t *> y;
+  ASSERT_TRUE(l.set_channel_block(1));
+  l.forward({x}, y);
+  const tensor_t expected = *y[0];
+
+  for (serial_size_t block : blocks) {
+    ASSERT_TRUE(l.set_channel_block(block));
+    l.forward({reorder_tensor(in, 1, block, x)}, y);
+    const tensor_t actual = reorder_tensor(out, block, 1, *y[0]);
+    for (size_t sample = 0; sample < x.size(); sample++) {
+      EXPECT_TRUE(is_near_container(expected[sample], actual[sample], eps));
+    }
+  }
+  l.set_channel_block(1);
+}
+
 #ifndef CNN_NO_SERIALIZATION
 inline std::string layer_to_json(const layer &src) {
   std::ostringstream os;
@@ -73,6 +73,19 @@ class activation_layer : public layer {
                            std::vector<tensor_t *> &out_data) override {
     const tensor_t &x = *in_data[0];
     tensor_t &y       = *out_data[0];
+
+    if (is_elementwise() &&
+        parallelize_within_samples(layer::parallelize(), x.size())) {
+      // split the elements of each sample between the threads
+      for (size_t i = 0; i < x.size(); i++) {
+        for_(true, 0, x[i].size(),
+             [&](const blocked_range &r) {
+               forward_activation_range(x[i], y[i], r.begin(), r.end());
+             },
+             split_grain(x[i].size(), 1024));
+      }
+      return;
+    }
     for_i(x.size(), [&](int i) { forward_activation(x[i], y[i]); });
   }
 
@@ -92,13 +105,43 @@ class activation_layer : public layer {
 
   /**
    * Populate vec_t of elements 'y' according to activation y = f(x).
-   * Child classes must override this method, apply activation function
-   * element wise over a vec_t of elements.
+   * Child classes must override this method, or forward_activation_range()
+   * if the activation is element wise.
    *
    * @param x  input vector
    * @param y  output vector (values to be assigned based on input)
    **/
-  virtual void forward_activation(const vec_t &x, vec_t &y) = 0;
+  virtual void forward_activation(const vec_t &x, vec_t &y) {
+    forward_activation_range(x, y, 0, x.size());
+  }
+
+  /**
+   * Whether y[j] only depends on x[j]. The elements of a sample can then be
+   * processed by several threads with forward_activation_range().
+   **/
+  virtual bool is_elementwise() const { return false; }
+
+  bool is_layout_agnostic() const override { return is_elementwise(); }
+
+  /**
+   * Populate y[begin, end) according to activation y = f(x). Element wise
+   * activations override this method instead of forward_activation().
+   *
+   * @param x     input vector
+   * @param y     output vector
+   * @param begin first element to compute
+   * @param end   one past the last element to compute
+   **/
+  virtual void forward_activation_range(const vec_t &x,
+                                        vec_t &y,
+                                        size_t begin,
+                                        size_t end) {
+    CNN_UNREFERENCED_PARAMETER(x);
+    CNN_UNREFERENCED_PARAMETER(y);
+    CNN_UNREFERENCED_PARAMETER(begin);
+    CNN_UNREFERENCED_PARAMETER(end);
+    throw nn_error(layer_type() + " doesn't implement forward_activation");
+  }
 
   /**
    * Populate vec_t of elements 'dx' according to gradient of activation.
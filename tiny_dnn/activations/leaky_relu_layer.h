@@ -66,8 +66,13 @@ class leaky_relu_layer : public activation_layer {
 
   float_t epsilon_value() const { return epsilon_; }
 
-  void forward_activation(const vec_t &x, vec_t &y) override {
-    for (serial_size_t j = 0; j < x.size(); j++) {
+  bool is_elementwise() const override { return true; }
+
+  void forward_activation_range(const vec_t &x,
+                                vec_t &y,
+                                size_t begin,
+                                size_t end) override {
+    for (size_t j = begin; j < end; j++) {
       y[j] = x[j] > float_t(0) ? x[j] : epsilon_ * x[j];
     }
   }
@@ -76,8 +76,13 @@ class softplus_layer : public activation_layer {
 
   float_t threshold_value() const { return threshold_; }
 
-  void forward_activation(const vec_t &x, vec_t &y) override {
-    for (serial_size_t j = 0; j < x.size(); j++) {
+  bool is_elementwise() const override { return true; }
+
+  void forward_activation_range(const vec_t &x,
+                                vec_t &y,
+                                size_t begin,
+                                size_t end) override {
+    for (size_t j = begin; j < end; j++) {
       float_t betain = beta_ * x[j];
       y[j]           = (betain > threshold_) ? x[j]
                                    : (1 / beta_) * std::log1p(std::exp(betain));
@@ -17,8 +17,13 @@ class softsign_layer : public activation_layer {
 
   std::string layer_type() const override { return "softsign-activation"; }
 
-  void forward_activation(const vec_t &x, vec_t &y) override {
-    for (serial_size_t j = 0; j < x.size(); j++) {
+  bool is_elementwise() const override { return true; }
+
+  void forward_activation_range(const vec_t &x,
+                                vec_t &y,
+                                size_t begin,
+                                size_t end) override {
+    for (size_t j = begin; j < end; j++) {
       y[j] = x[j] / (1.0 + std::abs(x[j]));
     }
   }
@@ -17,9 +17,14 @@ class tanh_p1m2_layer : public activation_layer {
 
   std::string layer_type() const override { return "tanh-scaled-activation"; }
 
-  void forward_activation(const vec_t &x, vec_t &y) override {
+  bool is_elementwise() const override { return true; }
+
+  void forward_activation_range(const vec_t &x,
+                                vec_t &y,
+                                size_t begin,
+                                size_t end) override {
     float_t ep;
-    for (serial_size_t j = 0; j < x.size(); j++) {
+    for (size_t j = begin; j < end; j++) {
       ep   = std::exp(x[j]);
       y[j] = ep / (ep + (float_t(1) / ep));
     }
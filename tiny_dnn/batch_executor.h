@@ -0,0 +1,245 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tiny_dnn/network.h"
+#include "tiny_dnn/util/nn_error.h"
+
+namespace tiny_dnn {
+
+/**
+ * when batch_executor runs a forward pass
+ **/
+struct batching_policy {
+  batching_policy() : max_batch_size(32), max_delay(1000) {}
+
+  batching_policy(size_t max_batch_size, std::chrono::microseconds max_delay)
+    : max_batch_size(max_batch_size), max_delay(max_delay) {}
+
+  /** largest number of samples given to one forward pass */
+  size_t max_batch_size;
+  /** longest time a sample waits for the batch to fill up */
+  std::chrono::microseconds max_delay;
+};
+
+struct batch_executor_stats {
+  batch_executor_stats()
+    : requests(0),
+      batches(0),
+      samples(0),
+      capacity(0),
+      queue_depth(0),
+      max_queue_depth(0) {}
+
+  /** average number of samples in a forward pass */
+  double mean_batch_size() const {
+    return batches == 0 ? 0.0 : double(samples) / double(batches);
+  }
+
+  /** average of batch size / max_batch_size over the forward passes */
+  double mean_batch_fill() const {
+    return capacity == 0 ? 0.0 : double(samples) / double(capacity);
+  }
+
+  /** samples submitted */
+  size_t requests;
+  /** forward passes run */
+  size_t batches;
+  /** samples given to the forward passes */
+  size_t samples;
+  /** sum of max_batch_size over the forward passes */
+  size_t capacity;
+  /** samples waiting for a forward pass at the moment */
+  size_t queue_depth;
+  /** largest queue_depth seen */
+  size_t max_queue_depth;
+};
+
+/**
+ * runs single-sample requests of many threads as batches.
+ *
+ * submit() queues a sample and returns a future of its output. a worker
+ * thread takes up to policy().max_batch_size queued samples, as soon as
+ * there are that many or the oldest one has waited for
+ * policy().max_delay, runs them in one forward pass and sets the futures.
+ *
+ *     batch_executor<sequential> executor(net, batching_policy(
+ *                                         16, std::chrono::milliseconds(2)));
+ *     std::future<vec_t> y = executor.submit(x);  // from any thread
+ *     use(y.get());
+ *
+ * the network must not be used by other threads while the executor is
+ * alive.
+ **/
+template <typename NetType>
+class batch_executor {
+ public:
+  explicit batch_executor(network<NetType> &net,
+                          const batching_policy &policy = batching_policy())
+    : net_(net), stop_(false) {
+    set_policy(policy);
+    worker_ = std::thread([this] { worker_loop(); });
+  }
+
+  /**
+   * runs the samples still queued, then stops the worker
+   **/
+  ~batch_executor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+  }
+
+  batch_executor(const batch_executor &) = delete;
+  batch_executor &operator=(const batch_executor &) = delete;
+
+  /**
+   * queue a sample, the future receives the output of the network (or the
+   * exception thrown by the forward pass)
+   **/
+  std::future<vec_t> submit(vec_t in) {
+    if (in.size() != net_.in_data_size()) {
+      throw nn_error("input size mismatch: expected " +
+                     std::to_string(net_.in_data_size()) + ", got " +
+                     std::to_string(in.size()));
+    }
+
+    request r;
+    r.in       = std::move(in);
+    r.enqueued = clock::now();
+    std::future<vec_t> f = r.out.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(std::move(r));
+      stats_.requests++;
+      stats_.max_queue_depth =
+        std::max(stats_.max_queue_depth, queue_.size());
+    }
+    cv_.notify_all();
+    return f;
+  }
+
+  /**
+   * change the policy, applied from the next forward pass
+   **/
+  void set_policy(const batching_policy &policy) {
+    if (policy.max_batch_size == 0) {
+      throw nn_error("max batch size must be positive");
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      policy_ = policy;
+    }
+    cv_.notify_all();
+  }
+
+  batching_policy policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+  }
+
+  batch_executor_stats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_executor_stats s = stats_;
+    s.queue_depth          = queue_.size();
+    return s;
+  }
+
+  void reset_stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = batch_executor_stats();
+  }
+
+ private:
+  typedef std::chrono::steady_clock clock;
+
+  struct request {
+    vec_t in;
+    std::promise<vec_t> out;
+    clock::time_point enqueued;
+  };
+
+  // take the next batch, empty when stopped with nothing queued
+  std::vector<request> next_batch() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      if (queue_.empty()) {
+        if (stop_) return std::vector<request>();
+        cv_.wait(lock);
+        continue;
+      }
+      const clock::time_point deadline =
+        queue_.front().enqueued + policy_.max_delay;
+      if (stop_ || queue_.size() >= policy_.max_batch_size ||
+          clock::now() >= deadline) {
+        break;
+      }
+      cv_.wait_until(lock, deadline);
+    }
+
+    const size_t n = std::min(queue_.size(), policy_.max_batch_size);
+    std::vector<request> batch;
+    batch.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      batch.push_back(std::move(queue_.front()));
+      queue_.pop_front();
+    }
+    stats_.batches++;
+    stats_.samples += n;
+    stats_.capacity += policy_.max_batch_size;
+    return batch;
+  }
+
+  void worker_loop() {
+    for (;;) {
+      std::vector<request> batch = next_batch();
+      if (batch.empty()) return;
+
+      std::vector<tensor_t> in(batch.size());
+      for (size_t i = 0; i < batch.size(); i++) {
+        in[i].push_back(std::move(batch[i].in));
+      }
+
+      std::vector<tensor_t> out;
+      try {
+        out = net_.predict(in);
+      } catch (...) {
+        for (auto &r : batch) r.out.set_exception(std::current_exception());
+        continue;
+      }
+      for (size_t i = 0; i < batch.size(); i++) {
+        batch[i].out.set_value(std::move(out[i][0]));
+      }
+    }
+  }
+
+  network<NetType> &net_;
+  batching_policy policy_;
+  batch_executor_stats stats_;
+  std::deque<request> queue_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_;
+  std::thread worker_;
+};
+
+}  // namespace tiny_dnn
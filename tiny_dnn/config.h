@@ -79,6 +79,14 @@
 #define CNN_TASK_SIZE 8
 #endif
 
+/**
+ * number of samples fed to the network at once in network::test and
+ * network::get_loss.
+ */
+#ifndef CNN_TEST_BATCH_SIZE
+#define CNN_TEST_BATCH_SIZE 64
+#endif
+
 namespace tiny_dnn {
 
 /**
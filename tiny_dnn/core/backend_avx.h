@@ -7,9 +7,11 @@
 */
 #pragma once
 #include "tiny_dnn/core/backend.h"
+#include "tiny_dnn/core/weights_cache.h"
 
 #include "tiny_dnn/core/kernels/avx_deconv2d_back_kernel.h"
 #include "tiny_dnn/core/kernels/avx_deconv2d_kernel.h"
+#include "tiny_dnn/core/kernels/conv2d_op_fft.h"
 
 namespace tiny_dnn {
 namespace core {
@@ -116,10 +118,24 @@ class avx_backend : public backend {
     tensor_t &out                             = *out_data[0];
     const tensor_t &in                        = *in_data[0];  // input
 
-    fill_tensor(out, float_t{0});
-
-    kernels::avx_deconv2d_kernel(*params_d_, in, W, bias, out,
-                                 layer_->parallelize());
+    fill_tensor(
+      out, float_t{0},
+      params_d_->out.size());  // deconv2d-kernel requires padded size buffer
+
+    // large windows with unit strides take the FFT kernel when it pays off
+    const serial_size_t fft = tiny_dnn::kernels::deconv2d_fft_size(*params_d_);
+    if (fft != 0) {
+      const vec_t &S = fft_filter_.get(
+        layer_, W, 0, fft, [&](const vec_t &w, vec_t &dst) {
+          tiny_dnn::kernels::deconv2d_fft_transform_filter(*params_d_, w, fft,
+                                                           dst);
+        });
+      tiny_dnn::kernels::deconv2d_op_fft(in, S, fft, bias, out, *params_d_,
+                                         layer_->parallelize());
+    } else {
+      kernels::avx_deconv2d_kernel(*params_d_, in, W, bias, out,
+                                   layer_->parallelize());
+    }
 
     copy_and_unpad_output(out);
     out = *(*deconv_layer_worker_storage_).curr_out_unpadded_;
@@ -224,6 +240,9 @@ class avx_backend : public backend {
   std::function<void(const tensor_t &, tensor_t &)> copy_and_pad_delta;
   std::function<void(const tensor_t &, const tensor_t &, tensor_t &)>
     backward_activation;
+
+  /* Filter spectra of the FFT deconvolution, keyed by the tile size */
+  weights_cache<vec_t> fft_filter_;
 };
 
 }  // namespace core
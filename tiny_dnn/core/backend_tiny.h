@@ -9,6 +9,7 @@
 
 #include "tiny_dnn/config.h"
 #include "tiny_dnn/core/backend.h"
+#include "tiny_dnn/core/weights_cache.h"
 
 #include "tiny_dnn/core/kernels/tiny_deconv2d_back_kernel.h"
 #include "tiny_dnn/core/kernels/tiny_deconv2d_kernel.h"
@@ -95,8 +96,15 @@ class tiny_backend : public backend {
 
     fill_tensor(out, float_t{0});
 
+    const kernels::quantized_weights &qw =
+      quantized_weights_.get(
+        layer_, W, [&](const vec_t &w, kernels::quantized_weights &dst) {
+          kernels::tiny_quantized_conv2d_quantize_weights(*params_c_, w, bias,
+                                                          &dst);
+        });
+
     for (serial_size_t i = 0; i < in.size(); i++) {
-      kernels::tiny_quantized_conv2d_kernel(*params_c_, *in[i], W, bias, out[i],
+      kernels::tiny_quantized_conv2d_kernel(*params_c_, *in[i], qw, out[i],
                                             layer_->parallelize());
     }
   }
@@ -190,9 +198,16 @@ class tiny_backend : public backend {
       out, float_t{0},
       params_d_->out.size());  // deconv2d-kernel requires padded size buffer
 
+    const kernels::quantized_weights &qw =
+      quantized_weights_.get(
+        layer_, W, [&](const vec_t &w, kernels::quantized_weights &dst) {
+          kernels::tiny_quantized_deconv2d_quantize_weights(*params_d_, w,
+                                                            bias, &dst);
+        });
+
     for (serial_size_t i = 0; i < in.size(); i++) {
-      kernels::tiny_quantized_deconv2d_kernel(*params_d_, in[i], W, bias,
-                                              out[i], layer_->parallelize());
+      kernels::tiny_quantized_deconv2d_kernel(*params_d_, in[i], qw, out[i],
+                                              layer_->parallelize());
     }
 
     copy_and_unpad_output(out);
@@ -292,12 +307,20 @@ class tiny_backend : public backend {
 #ifdef CNN_USE_GEMMLOWP
     const tensor_t &in = *in_data[0];
     const vec_t &W     = (*in_data[1])[0];
+    const vec_t &b     = params_f_->has_bias_ ? (*in_data[2])[0] : vec_t();
     tensor_t &out      = *out_data[0];
 
+    const kernels::quantized_weights &qw =
+      quantized_weights_.get(
+        layer_, W, [&](const vec_t &w, kernels::quantized_weights &dst) {
+          kernels::tiny_quantized_fully_connected_quantize_weights(
+            *params_f_, w, b, &dst);
+        });
+
     for (serial_size_t i = 0; i < in.size(); i++) {
-      kernels::tiny_quantized_fully_connected_kernel(
-        *params_f_, in[i], W, params_f_->has_bias_ ? (*in_data[2])[0] : vec_t(),
-        out[i], layer_->parallelize());
+      kernels::tiny_quantized_fully_connected_kernel(*params_f_, in[i], qw, b,
+                                                     out[i],
+                                                     layer_->parallelize());
     }
 #else
     CNN_UNREFERENCED_PARAMETER(in_data);
@@ -383,6 +406,10 @@ class tiny_backend : public backend {
   std::function<void(const tensor_t &, tensor_t &)> copy_and_pad_delta;
   std::function<void(const tensor_t &, const tensor_t &, tensor_t &)>
     backward_activation;
+
+  /* 8bit weights of the quantized layers, so that inference doesn't pay
+   * for weight quantization on every sample */
+  weights_cache<kernels::quantized_weights> quantized_weights_;
 };
 
 }  // namespace core
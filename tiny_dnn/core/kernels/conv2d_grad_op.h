@@ -10,6 +10,8 @@
 #include "tiny_dnn/core/framework/op_kernel.h"
 
 #include "tiny_dnn/core/kernels/conv2d_grad_op_avx.h"
+#include "tiny_dnn/core/kernels/conv2d_op_depthwise.h"
+#include "tiny_dnn/core/kernels/conv2d_op_gemm.h"
 #include "tiny_dnn/core/kernels/conv2d_op_internal.h"
 
 namespace tiny_dnn {
@@ -38,12 +40,28 @@ class Conv2dGradOp : public core::OpKernel {
 
     const core::backend_t engine = context.engine();
 
-    if (engine == core::backend_t::internal) {
+    // grouped convolutions take the depthwise kernel or one multiplication
+    // per group on the fast engines
+    const bool grouped =
+      params.groups != 1 &&
+      (engine == core::backend_t::avx || engine == core::backend_t::gemm);
+
+    if (grouped && kernels::conv2d_is_depthwise(params)) {
+      kernels::conv2d_grad_op_depthwise(prev_out, W[0], dW, db, curr_delta,
+                                        prev_delta, params,
+                                        context.parallelize());
+    } else if (grouped) {
+      kernels::conv2d_grad_op_gemm(prev_out, W[0], dW, db, curr_delta,
+                                   prev_delta, params, context.parallelize());
+    } else if (engine == core::backend_t::internal) {
       kernels::conv2d_op_internal(prev_out, W[0], dW, db, curr_delta,
                                   prev_delta, params, context.parallelize());
     } else if (engine == core::backend_t::avx) {
       kernels::conv2d_grad_op_avx(prev_out, W[0], dW, db, curr_delta,
                                   prev_delta, params, context.parallelize());
+    } else if (engine == core::backend_t::gemm) {
+      kernels::conv2d_grad_op_gemm(prev_out, W[0], dW, db, curr_delta,
+                                   prev_delta, params, context.parallelize());
     } else {
       throw nn_error("Not supported engine: " + to_string(engine));
     }
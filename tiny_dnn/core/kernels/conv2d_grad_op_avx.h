@@ -8,6 +8,7 @@
 #pragma once
 
 #include <vector>
+#include "tiny_dnn/core/kernels/conv2d_op_gemm.h"
 #include "tiny_dnn/core/kernels/conv2d_op_internal.h"
 #include "tiny_dnn/core/params/conv_params.h"
 
@@ -882,11 +883,12 @@ void avx_conv2d_5x5_back_kernel(
   std::vector<std::vector<float, Allocator>> &curr_delta,
   std::vector<std::vector<float, Allocator>> &prev_delta,
   bool layer_parallelize) {
-  for_i(layer_parallelize, prev_out.size(), [&](size_t sample) {
-    avx_conv2d_5x5_back_kernel_one(params, prev_out[sample], W, dW[sample],
-                                   db[sample], curr_delta[sample],
-                                   &prev_delta[sample]);
-  });
+  for_i_slots(layer_parallelize, prev_out.size(), dW.size(),
+              [&](size_t sample, size_t slot) {
+                avx_conv2d_5x5_back_kernel_one(
+                  params, prev_out[sample], W, dW[slot], db[slot],
+                  curr_delta[sample], &prev_delta[sample]);
+              });
 }
 
 #endif  // CNN_USE_AVX
@@ -907,8 +909,8 @@ inline void conv2d_grad_op_avx(const tensor_t &prev_out,
   }
 #endif
 
-  conv2d_op_internal(prev_out, W, dW, db, curr_delta, prev_delta, params,
-                     layer_parallelize);
+  conv2d_grad_op_gemm(prev_out, W, dW, db, curr_delta, prev_delta, params,
+                      layer_parallelize);
 }
 
 }  // namespace kernels
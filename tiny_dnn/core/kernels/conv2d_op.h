@@ -8,10 +8,17 @@
 #pragma once
 
 #include "tiny_dnn/core/framework/op_kernel.h"
+#include "tiny_dnn/core/weights_cache.h"
 
 #include "tiny_dnn/core/kernels/conv2d_op_avx.h"
+#include "tiny_dnn/core/kernels/conv2d_op_blocked.h"
+#include "tiny_dnn/core/kernels/conv2d_op_depthwise.h"
+#include "tiny_dnn/core/kernels/conv2d_op_fft.h"
+#include "tiny_dnn/core/kernels/conv2d_op_gemm.h"
 #include "tiny_dnn/core/kernels/conv2d_op_internal.h"
 #include "tiny_dnn/core/kernels/conv2d_op_nnpack.h"
+#include "tiny_dnn/core/kernels/conv2d_op_winograd.h"
+#include "tiny_dnn/layers/layer.h"
 
 namespace tiny_dnn {
 
@@ -37,7 +44,50 @@ class Conv2dOp : public core::OpKernel {
 
     const core::backend_t engine = context.engine();
 
-    if (engine == core::backend_t::internal) {
+    // channel-blocked activations have their own kernel. grouped
+    // convolutions take the depthwise kernel or one multiplication per
+    // group, 3x3 kernels with unit strides the Winograd kernel and large
+    // windows the FFT kernel on the fast engines when they pay off; internal
+    // stays the direct reference implementation
+    const bool fast =
+      engine == core::backend_t::avx || engine == core::backend_t::gemm;
+    const serial_size_t tile = kernels::conv2d_winograd_tile(params);
+    const serial_size_t fft  = fast ? kernels::conv2d_fft_size(params) : 0;
+    if (params.channel_block != 1) {
+      const vec_t &Wb = filter_.get(
+        context.Layer(), W[0], filter_kind::blocked, params.channel_block,
+        [&](const vec_t &w, vec_t &dst) {
+          kernels::conv2d_blocked_transform_filter(params, w, dst);
+        });
+      kernels::conv2d_op_blocked(in_data, Wb, bias[0], out_data, params,
+                                 context.parallelize());
+    } else if (params.groups != 1 && engine != core::backend_t::internal) {
+      if (kernels::conv2d_is_depthwise(params)) {
+        kernels::conv2d_op_depthwise(in_data, W[0], bias[0], out_data, params,
+                                     context.parallelize());
+      } else {
+        kernels::conv2d_op_gemm(in_data, W[0], bias[0], out_data, params,
+                                context.parallelize());
+      }
+    } else if (fast &&
+               kernels::conv2d_winograd_pays_off(params, in_data.size(),
+                                                 tile)) {
+      const vec_t &U = filter_.get(
+        context.Layer(), W[0], filter_kind::winograd, tile,
+        [&](const vec_t &w, vec_t &dst) {
+          kernels::conv2d_winograd_transform_filter(params, w, tile, dst);
+        });
+      kernels::conv2d_op_winograd(in_data, U, tile, bias[0], out_data, params,
+                                  context.parallelize());
+    } else if (fft != 0) {
+      const vec_t &S = filter_.get(
+        context.Layer(), W[0], filter_kind::fft, fft,
+        [&](const vec_t &w, vec_t &dst) {
+          kernels::conv2d_fft_transform_filter(params, w, fft, dst);
+        });
+      kernels::conv2d_op_fft(in_data, S, fft, bias[0], out_data, params,
+                             context.parallelize());
+    } else if (engine == core::backend_t::internal) {
       kernels::conv2d_op_internal(in_data, W[0], bias[0], out_data, params,
                                   context.parallelize());
     } else if (engine == core::backend_t::nnpack) {
@@ -45,10 +95,20 @@ class Conv2dOp : public core::OpKernel {
     } else if (engine == core::backend_t::avx) {
       kernels::conv2d_op_avx(in_data, W[0], bias[0], out_data, params,
                              context.parallelize());
+    } else if (engine == core::backend_t::gemm) {
+      kernels::conv2d_op_gemm(in_data, W[0], bias[0], out_data, params,
+                              context.parallelize());
     } else {
       throw nn_error("Not supported engine: " + to_string(engine));
     }
   }
+
+ private:
+  enum class filter_kind { winograd, fft, blocked };
+
+  /* Filters transformed for the Winograd, the FFT or the channel-blocked
+   * kernel, keyed by the kernel and its tile size (channel block) */
+  core::weights_cache<vec_t, filter_kind> filter_;
 };
 
 }  // namespace tiny_dnn
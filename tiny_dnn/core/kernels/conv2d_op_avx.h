@@ -8,6 +8,7 @@
 #pragma once
 
 #include <vector>
+#include "tiny_dnn/core/kernels/conv2d_op_gemm.h"
 #include "tiny_dnn/core/kernels/conv2d_op_internal.h"
 #include "tiny_dnn/core/params/conv_params.h"
 
@@ -28,7 +29,6 @@ void avx_conv2d_5x5_kernel(const core::conv_params &params,
                            const std::vector<float, Allocator> &bias,
                            std::vector<float, Allocator> &a,
                            const bool layer_parallelize) {
-  CNN_UNREFERENCED_PARAMETER(layer_parallelize);
   assert(params.weight.height_ == 5 && params.weight.width_ == 5);
 
   auto &out       = params.out;
@@ -37,7 +37,6 @@ void avx_conv2d_5x5_kernel(const core::conv_params &params,
   auto w_stride   = params.w_stride;
 
   const serial_size_t out_area = out.area();
-  serial_size_t oidx           = 0;
   float bias_scale             = params.has_bias ? 1.0f : 0.0f;
   const serial_size_t stride   = params.h_stride * in_padded.width_;
   const serial_size_t inarea   = in_padded.area();
@@ -85,8 +84,10 @@ void avx_conv2d_5x5_kernel(const core::conv_params &params,
     }
   } else {
     const serial_size_t nblocks = out.width_ / 4;
-    for (serial_size_t o = 0; o < out.depth_; ++o, oidx += out_area) {
-      float *pa = &a[oidx];
+    // output channels are independent, split them for a single sample
+    for_i(layer_parallelize, out.depth_, [&](size_t o) {
+      const serial_size_t oidx = static_cast<serial_size_t>(o) * out_area;
+      float *pa                = &a[oidx];
       // init to bias value
       float b = bias[o] * bias_scale;
       {
@@ -275,7 +276,7 @@ void avx_conv2d_5x5_kernel(const core::conv_params &params,
           }    // y loop
         }
       }  // in depth loop
-    }    // out depth loop
+    });  // out depth loop
   }      // else
 }  // avx_conv2d_5x5_kernel float ver
 
@@ -456,15 +457,16 @@ inline void conv2d_op_avx(const tensor_t &in_data,
                           const bool layer_parallelize) {
 #ifdef CNN_USE_AVX
   if (params.weight.height_ == 5 && params.weight.width_ == 5) {
-    // @todo consider better parallelization
-    for_i(layer_parallelize, in_data.size(), [&](size_t i) {
-      avx_conv2d_5x5_kernel(params, in_data[i], W, bias, out_data[i],
-                            layer_parallelize);
+    const bool split =
+      parallelize_within_samples(layer_parallelize, in_data.size());
+    for_i(layer_parallelize && !split, in_data.size(), [&](size_t i) {
+      avx_conv2d_5x5_kernel(params, in_data[i], W, bias, out_data[i], split);
+      if (params.epilogue) params.epilogue(out_data[i]);
     });
     return;
   }
 #endif
-  conv2d_op_internal(in_data, W, bias, out_data, params, layer_parallelize);
+  conv2d_op_gemm(in_data, W, bias, out_data, params, layer_parallelize);
 }
 
 }  // namespace kernels
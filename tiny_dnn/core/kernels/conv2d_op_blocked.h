@@ -0,0 +1,315 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "tiny_dnn/core/params/conv_params.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+// convolution of channel-blocked activations (see blocked_index). the SIMD
+// lanes hold consecutive channels of one pixel instead of consecutive pixels
+// of a row, so no lane is wasted at the end of the rows of small maps (7x7,
+// 14x14), and the kernel doesn't depend on the width of the image.
+//
+// conv2d_blocked_transform_filter interleaves the filters of each block of
+// output channels like the activations, so that a tap (input channel, ky,
+// kx) is a vector of output channels. a dense convolution multiplies it by
+// a broadcast input element, a depthwise one by the vector of the same
+// channels of the input pixel. R outputs of a row are accumulated in
+// registers at a time.
+
+namespace blocked_detail {
+
+struct geometry {
+  serial_size_t block;  // channel block
+  serial_size_t id;     // input channels
+  serial_size_t kw, kh, sx, sy;
+  serial_size_t pw;  // width of the padded input
+  size_t parea;      // area of the padded input
+  serial_size_t ow;
+};
+
+inline geometry make_geometry(const core::conv_params &params) {
+  geometry g;
+  g.block = params.channel_block;
+  g.id    = params.in.depth_;
+  g.kw    = params.weight.width_;
+  g.kh    = params.weight.height_;
+  g.sx    = params.w_stride;
+  g.sy    = params.h_stride;
+  g.pw    = params.in_padded.width_;
+  g.parea = params.in_padded.area();
+  g.ow    = params.out.width_;
+  return g;
+}
+
+// the input sample src with the zero padding of params around it, in the
+// same block. src itself if there is no padding.
+inline const float_t *pad_input(const core::conv_params &params,
+                                const vec_t &src,
+                                vec_t &buf) {
+  if (params.pad_type == padding::valid) return &src[0];
+
+  const serial_size_t block = params.channel_block;
+  const serial_size_t left  = params.weight.width_ / 2;
+  const serial_size_t top   = params.weight.height_ / 2;
+  buf.assign(params.in_padded.size(), float_t(0));
+  for (serial_size_t first = 0; first < params.in.depth_; first += block) {
+    const size_t row = params.in.width_ * block_width(params.in, block, first);
+    for (serial_size_t y = 0; y < params.in.height_; y++) {
+      const float_t *p = &src[blocked_index(params.in, block, 0, y, first)];
+      std::copy(p, p + row, &buf[blocked_index(params.in_padded, block, left,
+                                               top + y, first)]);
+    }
+  }
+  return &buf[0];
+}
+
+// outputs (ox + r, oy), r < R, of the channels [c, c + C * T::unroll_size)
+// of an output block of width bw. in is the padded sample, w the weights of
+// the block, bias (nullptr if none) and out point to channel c of the block.
+// each input element is broadcast once for the C vectors of channels.
+template <typename T, int R, int C>
+void dense_tile(const geometry &g,
+                const float_t *in,
+                const float_t *w,
+                const float_t *bias,
+                serial_size_t bw,
+                serial_size_t ox,
+                serial_size_t oy,
+                float_t *out) {
+  typedef typename T::register_type reg;
+  const size_t taps = g.kw * g.kh;
+  const size_t n    = T::unroll_size;
+
+  reg acc[C][R];
+  for (int v = 0; v < C; v++) {
+    const reg b =
+      bias ? T::template load<std::false_type>(bias + v * n) : T::zero();
+    for (int r = 0; r < R; r++) acc[v][r] = b;
+  }
+
+  for (serial_size_t first = 0; first < g.id; first += g.block) {
+    const serial_size_t ibw = std::min(g.block, g.id - first);
+    const float_t *pin      = in + first * g.parea;
+    const float_t *pw       = w + first * taps * bw;
+    const size_t step       = g.sx * ibw;
+    for (serial_size_t ky = 0; ky < g.kh; ky++) {
+      const float_t *row = pin + ((oy * g.sy + ky) * g.pw + ox * g.sx) * ibw;
+      for (serial_size_t kx = 0; kx < g.kw; kx++) {
+        const float_t *px  = row + kx * ibw;
+        const float_t *pwt = pw + (ky * g.kw + kx) * bw;
+        for (serial_size_t k = 0; k < ibw; k++) {
+          reg wv[C];
+          for (int v = 0; v < C; v++) {
+            wv[v] = T::template load<std::false_type>(pwt + k * taps * bw +
+                                                      v * n);
+          }
+          for (int r = 0; r < R; r++) {
+            const reg x = T::set1(px[r * step + k]);
+            for (int v = 0; v < C; v++) {
+              acc[v][r] = T::madd(wv[v], x, acc[v][r]);
+            }
+          }
+        }
+      }
+    }
+  }
+  for (int v = 0; v < C; v++) {
+    for (int r = 0; r < R; r++) {
+      T::template store<std::false_type>(
+        out + (oy * g.ow + ox + r) * bw + v * n, acc[v][r]);
+    }
+  }
+}
+
+// same as dense_tile with C = 1 for a depthwise convolution, where in
+// points to the channel c of the input block of the output block
+template <typename T, int R>
+void depthwise_tile(const geometry &g,
+                    const float_t *in,
+                    const float_t *w,
+                    const float_t *bias,
+                    serial_size_t bw,
+                    serial_size_t ox,
+                    serial_size_t oy,
+                    float_t *out) {
+  typedef typename T::register_type reg;
+
+  reg acc[R];
+  const reg b = bias ? T::template load<std::false_type>(bias) : T::zero();
+  for (int r = 0; r < R; r++) acc[r] = b;
+
+  const size_t step = g.sx * bw;
+  for (serial_size_t ky = 0; ky < g.kh; ky++) {
+    const float_t *row = in + ((oy * g.sy + ky) * g.pw + ox * g.sx) * bw;
+    for (serial_size_t kx = 0; kx < g.kw; kx++) {
+      const reg wv =
+        T::template load<std::false_type>(w + (ky * g.kw + kx) * bw);
+      const float_t *px = row + kx * bw;
+      for (int r = 0; r < R; r++) {
+        acc[r] = T::madd(
+          wv, T::template load<std::false_type>(px + r * step), acc[r]);
+      }
+    }
+  }
+  for (int r = 0; r < R; r++) {
+    T::template store<std::false_type>(out + (oy * g.ow + ox + r) * bw,
+                                       acc[r]);
+  }
+}
+
+// the channels [c, c + C * T::unroll_size) of output row oy, R outputs at a
+// time while they fit
+template <bool Depthwise, typename T, int C>
+void channels_row(const geometry &g,
+                  const float_t *in,
+                  const float_t *w,
+                  const float_t *bias,
+                  serial_size_t bw,
+                  serial_size_t c,
+                  serial_size_t oy,
+                  float_t *out) {
+  // about 12 accumulators for the 16 registers of SSE and AVX
+  const int R       = Depthwise ? 4 : 12 / C;
+  const float_t *pb = bias ? bias + c : nullptr;
+  serial_size_t ox  = 0;
+  if (Depthwise) {
+    for (; ox + R <= g.ow; ox += R) {
+      depthwise_tile<T, R>(g, in + c, w + c, pb, bw, ox, oy, out + c);
+    }
+    for (; ox < g.ow; ox++) {
+      depthwise_tile<T, 1>(g, in + c, w + c, pb, bw, ox, oy, out + c);
+    }
+  } else {
+    for (; ox + R <= g.ow; ox += R) {
+      dense_tile<T, R, C>(g, in, w + c, pb, bw, ox, oy, out + c);
+    }
+    for (; ox < g.ow; ox++) {
+      dense_tile<T, 1, C>(g, in, w + c, pb, bw, ox, oy, out + c);
+    }
+  }
+}
+
+// output row oy of the block of width bw. the channels are taken two
+// vectors at a time (one for a depthwise convolution, which has nothing to
+// share between them), then the rest of the block one by one.
+template <bool Depthwise>
+void output_row(const geometry &g,
+                const float_t *in,
+                const float_t *w,
+                const float_t *bias,
+                serial_size_t bw,
+                serial_size_t oy,
+                float_t *out) {
+  typedef vectorize::CNN_VECTORIZE_TYPE V;
+  typedef vectorize::detail::scalar_generic<float_t> S;
+
+  serial_size_t c = 0;
+  if (!Depthwise) {
+    for (; c + 2 * V::unroll_size <= bw; c += 2 * V::unroll_size) {
+      channels_row<Depthwise, V, 2>(g, in, w, bias, bw, c, oy, out);
+    }
+  }
+  for (; c + V::unroll_size <= bw; c += V::unroll_size) {
+    channels_row<Depthwise, V, 1>(g, in, w, bias, bw, c, oy, out);
+  }
+  for (; c < bw; c++) {
+    channels_row<Depthwise, S, 1>(g, in, w, bias, bw, c, oy, out);
+  }
+}
+
+}  // namespace blocked_detail
+
+/**
+ * whether conv2d_op_blocked can compute the layer: a dense convolution
+ * without connection table, or a depthwise one with one filter per channel
+ **/
+inline bool conv2d_blocked_supported(const core::conv_params &params) {
+  if (!params.tbl.is_empty()) return false;
+  return params.groups == 1 || (params.groups == params.in.depth_ &&
+                                params.out.depth_ == params.in.depth_);
+}
+
+/**
+ * rearrange the filters W for conv2d_op_blocked: the taps of the output
+ * channels [first, first + width) of a block are stored from
+ * first * (in.depth_ / groups) * kw * kh on, tap (i, ky, kx) of channel o
+ * at ((i * kh + ky) * kw + kx) * width + o - first.
+ **/
+inline void conv2d_blocked_transform_filter(const core::conv_params &params,
+                                            const vec_t &W,
+                                            vec_t &Wb) {
+  const serial_size_t block = params.channel_block;
+  const serial_size_t ig    = params.in.depth_ / params.groups;
+  const size_t taps         = params.weight.width_ * params.weight.height_;
+  Wb.resize(W.size());
+  for (serial_size_t o = 0; o < params.out.depth_; o++) {
+    const serial_size_t first = o / block * block;
+    const serial_size_t bw    = block_width(params.out, block, first);
+    float_t *dst              = &Wb[first * ig * taps + o - first];
+    const float_t *src        = &W[o * ig * taps];
+    for (size_t t = 0; t < ig * taps; t++) dst[t * bw] = src[t];
+  }
+}
+
+/**
+ * convolution of the channel-blocked input in_data (unpadded, block
+ * params.channel_block) into the blocked out_data, with the filters
+ * rearranged by conv2d_blocked_transform_filter.
+ **/
+inline void conv2d_op_blocked(const tensor_t &in_data,
+                              const vec_t &Wb,
+                              const vec_t &bias,
+                              tensor_t &out_data,
+                              const core::conv_params &params,
+                              const bool parallelize) {
+  using namespace blocked_detail;
+  if (!conv2d_blocked_supported(params)) {
+    throw nn_error("no channel-blocked kernel for this convolution");
+  }
+  const geometry g           = make_geometry(params);
+  const bool depthwise       = params.groups != 1;
+  const serial_size_t block  = params.channel_block;
+  const serial_size_t oh     = params.out.height_;
+  const serial_size_t blocks = (params.out.depth_ + block - 1) / block;
+  const size_t taps          = g.kw * g.kh;
+  const size_t ig            = depthwise ? 1 : g.id;
+
+  // with a small batch, the rows of the output blocks are split instead
+  const bool split = parallelize_within_samples(parallelize, in_data.size());
+
+  for_i(parallelize && !split, in_data.size(), [&](size_t sample) {
+    vec_t buf;
+    const float_t *in = pad_input(params, in_data[sample], buf);
+    vec_t &a          = out_data[sample];
+    for_i(split, blocks * oh,
+          [&](size_t j) {
+            const serial_size_t first = j / oh * block;
+            const serial_size_t oy    = j % oh;
+            const serial_size_t bw    = block_width(params.out, block, first);
+            const float_t *w          = &Wb[first * ig * taps];
+            const float_t *b = params.has_bias ? &bias[first] : nullptr;
+            float_t *out     = &a[first * params.out.area()];
+            if (depthwise) {
+              output_row<true>(g, in + first * g.parea, w, b, bw, oy, out);
+            } else {
+              output_row<false>(g, in, w, b, bw, oy, out);
+            }
+          },
+          1);
+    if (params.epilogue) params.epilogue(a);
+  });
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
@@ -0,0 +1,410 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "tiny_dnn/core/params/conv_params.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+// depthwise convolution: groups == in channels, so every output channel o
+// sees the single input channel o / (out channels / in channels).
+//
+// there is nothing to sum over the channels and im2col + gemm would multiply
+// matrices of a single row, so each output plane is computed directly from
+// its input plane, vectorized along the output rows. with a stride s > 1 the
+// rows of the input are first split into their s phases (elements p, p + s,
+// p + 2s, ...), after which the tap kx of consecutive outputs reads
+// consecutive elements of phase kx % s again.
+
+namespace depthwise_detail {
+
+// length of a phase of an input row
+inline size_t phase_width(const core::conv_params &params) {
+  return (params.in_padded.width_ + params.w_stride - 1) / params.w_stride;
+}
+
+// offsets of the taps (kx, ky) of output (0, 0) in the phase layout, where
+// row r of the input plane has its phase p at (r * s + p) * phase_width.
+// output row y adds y * row_step(params).
+inline std::vector<size_t> tap_offsets(const core::conv_params &params) {
+  const serial_size_t s = params.w_stride;
+  const size_t pw       = phase_width(params);
+  std::vector<size_t> off(params.weight.width_ * params.weight.height_);
+  for (serial_size_t ky = 0; ky < params.weight.height_; ky++) {
+    for (serial_size_t kx = 0; kx < params.weight.width_; kx++) {
+      off[ky * params.weight.width_ + kx] = (ky * s + kx % s) * pw + kx / s;
+    }
+  }
+  return off;
+}
+
+inline size_t row_step(const core::conv_params &params) {
+  return params.h_stride * params.w_stride * phase_width(params);
+}
+
+// dst[j] = src[j * s] for j < n. a stride S known at compile time (0 if not)
+// lets the compiler vectorize the copy.
+template <size_t S>
+void gather_strided(const float_t *src, size_t s, size_t n, float_t *dst) {
+  const size_t step = S ? S : s;
+  for (size_t j = 0; j < n; j++) dst[j] = src[j * step];
+}
+
+// dst[x] += element x / s of phase x % s of the row src, for x < n
+template <size_t S>
+void add_interleaved(const float_t *src,
+                     size_t pw,
+                     size_t s,
+                     size_t n,
+                     float_t *dst) {
+  const size_t step = S ? S : s;
+  for (size_t x = 0; x < n; x++) dst[x] += src[x % step * pw + x / step];
+}
+
+// the padded input plane src in the phase layout, in buf unless the stride
+// is 1 (the plane itself then)
+inline const float_t *split_phases(const core::conv_params &params,
+                                   const float_t *src,
+                                   vec_t &buf) {
+  const serial_size_t s = params.w_stride;
+  if (s == 1) return src;
+
+  const size_t iw = params.in_padded.width_;
+  const size_t ih = params.in_padded.height_;
+  const size_t pw = phase_width(params);
+  buf.resize(ih * s * pw);
+  float_t *dst = &buf[0];
+  for (size_t r = 0; r < ih; r++, src += iw) {
+    for (size_t p = 0; p < s; p++, dst += pw) {
+      const size_t n = (iw - p + s - 1) / s;
+      if (s == 2) {
+        gather_strided<2>(src + p, s, n, dst);
+      } else {
+        gather_strided<0>(src + p, s, n, dst);
+      }
+    }
+  }
+  return &buf[0];
+}
+
+// dst += src in the phase layout
+inline void merge_phases(const core::conv_params &params,
+                         const float_t *src,
+                         float_t *dst) {
+  const size_t s  = params.w_stride;
+  const size_t iw = params.in_padded.width_;
+  const size_t ih = params.in_padded.height_;
+  const size_t pw = phase_width(params);
+  for (size_t r = 0; r < ih; r++, src += s * pw, dst += iw) {
+    if (s == 2) {
+      add_interleaved<2>(src, pw, s, iw, dst);
+    } else {
+      add_interleaved<0>(src, pw, s, iw, dst);
+    }
+  }
+}
+
+// out = bias + the kw x kh filter w over the input plane src (phase layout,
+// tap offsets off). KW and KH fix the window at compile time, 0 takes it
+// from params.
+template <serial_size_t KW, serial_size_t KH>
+void forward_plane(const core::conv_params &params,
+                   const size_t *off,
+                   const float_t *src,
+                   const float_t *w,
+                   float_t bias,
+                   float_t *out) {
+  typedef vectorize::CNN_VECTORIZE_TYPE T;
+  typedef typename T::register_type reg;
+  const serial_size_t taps =
+    (KW ? KW : params.weight.width_) * (KH ? KH : params.weight.height_);
+  const serial_size_t ow = params.out.width_;
+  const size_t step      = row_step(params);
+  const size_t v         = T::unroll_size;
+
+  for (serial_size_t y = 0; y < params.out.height_; y++) {
+    const float_t *row = src + y * step;
+    float_t *pout      = out + y * ow;
+    size_t x           = 0;
+    // two vectors at a time, to hide the latency of the sums
+    for (; x + 2 * v <= ow; x += 2 * v) {
+      reg sum0 = T::set1(bias), sum1 = sum0;
+      for (serial_size_t t = 0; t < taps; t++) {
+        const float_t *p = row + off[t] + x;
+        const reg wv     = T::set1(w[t]);
+        sum0 = T::madd(wv, T::template load<std::false_type>(p), sum0);
+        sum1 = T::madd(wv, T::template load<std::false_type>(p + v), sum1);
+      }
+      T::template store<std::false_type>(pout + x, sum0);
+      T::template store<std::false_type>(pout + x + v, sum1);
+    }
+    for (; x + v <= ow; x += v) {
+      reg sum = T::set1(bias);
+      for (serial_size_t t = 0; t < taps; t++) {
+        sum = T::madd(T::set1(w[t]),
+                      T::template load<std::false_type>(row + off[t] + x), sum);
+      }
+      T::template store<std::false_type>(pout + x, sum);
+    }
+    for (; x < ow; x++) {
+      float_t sum = bias;
+      for (serial_size_t t = 0; t < taps; t++) sum += w[t] * row[off[t] + x];
+      pout[x] = sum;
+    }
+  }
+}
+
+// the output gradient plane dy with its rows padded by zeros for
+// input_grad_plane: row y at dst + y * pad_width + pad_left
+inline size_t grad_pad_left(const core::conv_params &params) {
+  return (params.weight.width_ - 1) / params.w_stride;
+}
+
+inline size_t grad_pad_width(const core::conv_params &params) {
+  return grad_pad_left(params) + phase_width(params);
+}
+
+inline void pad_grad(const core::conv_params &params,
+                     const float_t *dy,
+                     vec_t &dst) {
+  const serial_size_t ow = params.out.width_;
+  const size_t width     = grad_pad_width(params);
+  dst.assign(params.out.height_ * width, float_t(0));
+  for (serial_size_t y = 0; y < params.out.height_; y++, dy += ow) {
+    std::copy(dy, dy + ow, &dst[y * width + grad_pad_left(params)]);
+  }
+}
+
+// dst += the filter w applied backwards to the output gradient (padded by
+// pad_grad), i.e. the gradient of the input plane in the phase layout.
+// element j of phase p of row r sums the taps (kx, ky) with kx % s == p
+// of the outputs (j - kx / s, (r - ky) / h_stride), so each vector of dst
+// is summed in registers and stored once.
+template <serial_size_t KW, serial_size_t KH>
+void input_grad_plane(const core::conv_params &params,
+                      const float_t *w,
+                      const float_t *dy,
+                      float_t *dst) {
+  typedef vectorize::CNN_VECTORIZE_TYPE T;
+  typedef typename T::register_type reg;
+  const serial_size_t kw    = KW ? KW : params.weight.width_;
+  const serial_size_t kh    = KH ? KH : params.weight.height_;
+  const serial_size_t s     = params.w_stride;
+  const serial_size_t sy    = params.h_stride;
+  const size_t pw           = phase_width(params);
+  const size_t width        = grad_pad_width(params);
+  const size_t v            = T::unroll_size;
+  const float_t *const base = dy + grad_pad_left(params);
+
+  for (serial_size_t r = 0; r < params.in_padded.height_; r++) {
+    // the rows ky = r % sy, r % sy + sy, ... of the filter meet this row,
+    // from the outputs y0, y0 - 1, ...
+    const serial_size_t ky0 = r % sy;
+    const int y0            = static_cast<int>(r / sy);
+    const int oh            = static_cast<int>(params.out.height_);
+    for (serial_size_t p = 0; p < s; p++, dst += pw) {
+      size_t j = 0;
+      for (; j + v <= pw; j += v) {
+        reg sum = T::zero();
+        int y   = y0;
+        for (serial_size_t ky = ky0; ky < kh && y >= 0; ky += sy, y--) {
+          if (y >= oh) continue;
+          const float_t *d = base + y * width + j;
+          for (serial_size_t kx = p, i = 0; kx < kw; kx += s, i++) {
+            sum = T::madd(T::set1(w[ky * kw + kx]),
+                          T::template load<std::false_type>(d - i), sum);
+          }
+        }
+        T::template store<std::false_type>(
+          dst + j, T::add(sum, T::template load<std::false_type>(dst + j)));
+      }
+      for (; j < pw; j++) {
+        float_t sum = float_t(0);
+        int y       = y0;
+        for (serial_size_t ky = ky0; ky < kh && y >= 0; ky += sy, y--) {
+          if (y >= oh) continue;
+          const float_t *d = base + y * width + j;
+          for (serial_size_t kx = p, i = 0; kx < kw; kx += s, i++) {
+            sum += w[ky * kw + kx] * *(d - i);
+          }
+        }
+        dst[j] += sum;
+      }
+    }
+  }
+}
+
+// dw += the gradient of the filter from the input plane src (phase layout,
+// tap offsets off) and the output gradient dy. a row of KW taps is summed
+// per pass over dy, a single tap when the window isn't fixed at compile time.
+template <serial_size_t KW, serial_size_t KH>
+void weight_grad_plane(const core::conv_params &params,
+                       const size_t *off,
+                       const float_t *src,
+                       const float_t *dy,
+                       float_t *dw) {
+  typedef vectorize::CNN_VECTORIZE_TYPE T;
+  typedef typename T::register_type reg;
+  const serial_size_t taps =
+    (KW ? KW : params.weight.width_) * (KH ? KH : params.weight.height_);
+  const serial_size_t n  = KW ? KW : 1;
+  const serial_size_t ow = params.out.width_;
+  const size_t step      = row_step(params);
+  const size_t v         = T::unroll_size;
+
+  for (serial_size_t t0 = 0; t0 < taps; t0 += n) {
+    reg sum[KW ? KW : 1];
+    float_t tail[KW ? KW : 1];
+    for (serial_size_t t = 0; t < n; t++) {
+      sum[t]  = T::zero();
+      tail[t] = float_t(0);
+    }
+    for (serial_size_t y = 0; y < params.out.height_; y++) {
+      const float_t *row = src + y * step;
+      const float_t *d   = dy + y * ow;
+      size_t x           = 0;
+      for (; x + v <= ow; x += v) {
+        const reg dv = T::template load<std::false_type>(d + x);
+        for (serial_size_t t = 0; t < n; t++) {
+          sum[t] = T::madd(
+            T::template load<std::false_type>(row + off[t0 + t] + x), dv,
+            sum[t]);
+        }
+      }
+      for (; x < ow; x++) {
+        for (serial_size_t t = 0; t < n; t++) {
+          tail[t] += row[off[t0 + t] + x] * d[x];
+        }
+      }
+    }
+    for (serial_size_t t = 0; t < n; t++) {
+      dw[t0 + t] += T::resemble(sum[t]) + tail[t];
+    }
+  }
+}
+
+}  // namespace depthwise_detail
+
+/**
+ * whether params is a depthwise convolution, which conv2d_op_depthwise runs
+ **/
+inline bool conv2d_is_depthwise(const core::conv_params &params) {
+  return params.groups > 1 && params.groups == params.in.depth_;
+}
+
+inline void conv2d_op_depthwise(const tensor_t &in_data,
+                                const vec_t &W,
+                                const vec_t &bias,
+                                tensor_t &out_data,
+                                const core::conv_params &params,
+                                const bool parallelize) {
+  using namespace depthwise_detail;
+  if (!conv2d_is_depthwise(params)) {
+    throw nn_error("depthwise convolution needs groups == in channels");
+  }
+  const serial_size_t kw   = params.weight.width_;
+  const serial_size_t kh   = params.weight.height_;
+  const serial_size_t mult = params.out.depth_ / params.in.depth_;
+  const std::vector<size_t> off = tap_offsets(params);
+
+  // with a small batch, the channels of a sample are split instead
+  const bool split = parallelize_within_samples(parallelize, in_data.size());
+
+  for_i(parallelize && !split, in_data.size(), [&](size_t sample) {
+    vec_t &a = out_data[sample];
+    for_i(split, params.out.depth_,
+          [&](size_t o) {
+            vec_t buf;
+            const float_t *src = split_phases(
+              params,
+              &in_data[sample][params.in_padded.get_index(0, 0, o / mult)],
+              buf);
+            const float_t *pw = &W[o * kw * kh];
+            const float_t b   = params.has_bias ? bias[o] : float_t(0);
+            float_t *out      = &a[params.out.get_index(0, 0, o)];
+            if (kw == 3 && kh == 3) {
+              forward_plane<3, 3>(params, &off[0], src, pw, b, out);
+            } else if (kw == 5 && kh == 5) {
+              forward_plane<5, 5>(params, &off[0], src, pw, b, out);
+            } else {
+              forward_plane<0, 0>(params, &off[0], src, pw, b, out);
+            }
+          },
+          1);
+    if (params.epilogue) params.epilogue(a);
+  });
+}
+
+inline void conv2d_grad_op_depthwise(const tensor_t &prev_out,
+                                     const vec_t &W,
+                                     tensor_t &dW,
+                                     tensor_t &db,
+                                     tensor_t &curr_delta,
+                                     tensor_t &prev_delta,
+                                     const core::conv_params &params,
+                                     const bool parallelize) {
+  using namespace depthwise_detail;
+  if (!conv2d_is_depthwise(params)) {
+    throw nn_error("depthwise convolution needs groups == in channels");
+  }
+  const serial_size_t kw   = params.weight.width_;
+  const serial_size_t kh   = params.weight.height_;
+  const serial_size_t mult = params.out.depth_ / params.in.depth_;
+  const bool phases        = params.w_stride != 1;
+  const std::vector<size_t> off = tap_offsets(params);
+
+  // samples of the same slot share one row of dW and db
+  for_i_slots(parallelize, prev_out.size(), dW.size(), [&](size_t sample,
+                                                           size_t slot) {
+    vec_t buf, dbuf, dy_padded;
+    for (serial_size_t o = 0; o < params.out.depth_; o++) {
+      const size_t in_idx = params.in_padded.get_index(0, 0, o / mult);
+      const float_t *src  = split_phases(params, &prev_out[sample][in_idx],
+                                        buf);
+      const float_t *dy =
+        &curr_delta[sample][params.out.get_index(0, 0, o)];
+      const float_t *pw = &W[o * kw * kh];
+      float_t *pdw      = &dW[slot][o * kw * kh];
+
+      // propagate delta to previous layer
+      pad_grad(params, dy, dy_padded);
+      float_t *dst = &prev_delta[sample][in_idx];
+      if (phases) {
+        dbuf.assign(params.in_padded.height_ * params.w_stride *
+                      phase_width(params),
+                    float_t(0));
+        dst = &dbuf[0];
+      }
+      if (kw == 3 && kh == 3) {
+        input_grad_plane<3, 3>(params, pw, &dy_padded[0], dst);
+        weight_grad_plane<3, 3>(params, &off[0], src, dy, pdw);
+      } else if (kw == 5 && kh == 5) {
+        input_grad_plane<5, 5>(params, pw, &dy_padded[0], dst);
+        weight_grad_plane<5, 5>(params, &off[0], src, dy, pdw);
+      } else {
+        input_grad_plane<0, 0>(params, pw, &dy_padded[0], dst);
+        weight_grad_plane<0, 0>(params, &off[0], src, dy, pdw);
+      }
+      if (phases) merge_phases(params, dst, &prev_delta[sample][in_idx]);
+
+      // accumulate db
+      if (params.has_bias) {
+        db[slot][o] +=
+          std::accumulate(dy, dy + params.out.area(), float_t{0});
+      }
+    }
+  });
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
@@ -0,0 +1,559 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tiny_dnn/core/kernels/gemm.h"
+#include "tiny_dnn/core/params/conv_params.h"
+#include "tiny_dnn/core/params/deconv_params.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+// FFT convolution for large windows (overlap-save).
+//
+// the output is cut into m x m tiles, each computed from a T x T tile of
+// the input (m = T - window + 1, T a power of two). the cross-correlation
+// of an input tile with a filter is the inverse transform of X .* conj(W),
+// of which the first m x m values don't wrap around, so for every
+// frequency the convolution is a complex (out channels x in channels) by
+// (in channels x tiles) matrix multiplication. with T = 32 a 7x7 window
+// takes about 13 multiplications per output and channel pair instead of
+// 49, an 11x11 window about 19 instead of 121 (with T = 64).
+//
+// the transforms are real 2D FFTs: the rows are transformed two at a time
+// as one complex FFT, leaving T x (T / 2 + 1) frequencies, then the
+// columns. deconvolutions with unit strides are the same correlation of
+// the input padded by window - 1 with the flipped filters.
+
+namespace fft_detail {
+
+// in place radix-2 DFT of n complex values, n a power of two
+class fft_plan {
+ public:
+  explicit fft_plan(serial_size_t n)
+    : n_(n), rev_(n), cos_(n / 2), sin_(n / 2) {
+    serial_size_t bits = 0;
+    while ((serial_size_t(1) << bits) < n) bits++;
+    if (n < 2 || (serial_size_t(1) << bits) != n) {
+      throw nn_error("FFT size must be a power of two");
+    }
+    for (serial_size_t k = 0; k < n; k++) {
+      serial_size_t r = 0;
+      for (serial_size_t b = 0; b < bits; b++) {
+        r |= ((k >> b) & 1) << (bits - 1 - b);
+      }
+      rev_[k] = r;
+    }
+    const double pi = 3.14159265358979323846;
+    for (serial_size_t k = 0; k < n / 2; k++) {
+      cos_[k] = static_cast<float_t>(std::cos(2 * pi * k / n));
+      sin_[k] = static_cast<float_t>(std::sin(2 * pi * k / n));
+    }
+  }
+
+  serial_size_t size() const { return n_; }
+
+  // transforms the n elements at re/im + k * stride, each of width values
+  // transformed independently. the inverse transform isn't scaled by 1/n.
+  void transform(float_t *re,
+                 float_t *im,
+                 size_t stride,
+                 size_t width,
+                 bool inverse) const {
+    for (serial_size_t k = 0; k < n_; k++) {
+      const serial_size_t r = rev_[k];
+      if (k >= r) continue;
+      std::swap_ranges(re + k * stride, re + k * stride + width,
+                       re + r * stride);
+      std::swap_ranges(im + k * stride, im + k * stride + width,
+                       im + r * stride);
+    }
+    const float_t sign = inverse ? float_t(1) : float_t(-1);
+    for (serial_size_t half = 1; half < n_; half *= 2) {
+      const serial_size_t step = n_ / (2 * half);
+      for (serial_size_t i = 0; i < n_; i += 2 * half) {
+        for (serial_size_t j = 0; j < half; j++) {
+          const float_t wr = cos_[j * step];
+          const float_t wi = sign * sin_[j * step];
+          float_t *ar = re + (i + j) * stride, *ai = im + (i + j) * stride;
+          float_t *br = ar + half * stride, *bi = ai + half * stride;
+          for (size_t w = 0; w < width; w++) {
+            const float_t tr = wr * br[w] - wi * bi[w];
+            const float_t ti = wr * bi[w] + wi * br[w];
+            br[w]            = ar[w] - tr;
+            bi[w]            = ai[w] - ti;
+            ar[w] += tr;
+            ai[w] += ti;
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  serial_size_t n_;
+  std::vector<serial_size_t> rev_;
+  std::vector<float_t> cos_, sin_;
+};
+
+// the real T x T signals are passed as pairs of rows: zr and zi hold T x
+// (T / 2) values, zr[j * T / 2 + r] = x[2 * r][j] and zi[j * T / 2 + r] =
+// x[2 * r + 1][j], so that the FFTs of all rows run side by side.
+
+// (sre, sim) = the T x (T / 2 + 1) frequencies of the signal in (zr, zi),
+// which is overwritten
+inline void forward_2d(const fft_plan &p,
+                       float_t *zr,
+                       float_t *zi,
+                       float_t *sre,
+                       float_t *sim) {
+  const serial_size_t n = p.size(), h = n / 2 + 1, pairs = n / 2;
+  // rows 2r and 2r + 1 as the real and imaginary part of one signal
+  p.transform(zr, zi, pairs, pairs, false);
+  for (serial_size_t k = 0; k < h; k++) {
+    const serial_size_t nk = (n - k) & (n - 1);
+    const float_t *ar = zr + k * pairs, *ai = zi + k * pairs;
+    const float_t *br = zr + nk * pairs, *bi = zi + nk * pairs;
+    for (serial_size_t r = 0; r < pairs; r++) {
+      sre[2 * r * h + k]       = (ar[r] + br[r]) * float_t(0.5);
+      sim[2 * r * h + k]       = (ai[r] - bi[r]) * float_t(0.5);
+      sre[(2 * r + 1) * h + k] = (ai[r] + bi[r]) * float_t(0.5);
+      sim[(2 * r + 1) * h + k] = (br[r] - ar[r]) * float_t(0.5);
+    }
+  }
+  p.transform(sre, sim, h, h, false);
+}
+
+// the first 2 * pairs rows of the signal (zr, zi) of the frequencies
+// (sre, sim), scaled by T * T; sre and sim are overwritten
+inline void inverse_2d(const fft_plan &p,
+                       float_t *sre,
+                       float_t *sim,
+                       serial_size_t pairs,
+                       float_t *zr,
+                       float_t *zi) {
+  const serial_size_t n = p.size(), h = n / 2 + 1, stride = n / 2;
+  p.transform(sre, sim, h, h, true);
+  // the spectra a and b of rows 2r and 2r + 1 are hermitian: z = a + i b
+  for (serial_size_t k = 0; k < n; k++) {
+    const serial_size_t kk = k < h ? k : n - k;
+    const float_t conj     = k < h ? float_t(1) : float_t(-1);
+    float_t *pr = zr + k * stride, *pi = zi + k * stride;
+    for (serial_size_t r = 0; r < pairs; r++) {
+      const float_t ar = sre[2 * r * h + kk], ai = sim[2 * r * h + kk];
+      const float_t br = sre[(2 * r + 1) * h + kk];
+      const float_t bi = sim[(2 * r + 1) * h + kk];
+      pr[r]            = ar - conj * bi;
+      pi[r]            = conj * ai + br;
+    }
+  }
+  p.transform(zr, zi, stride, pairs, true);
+}
+
+// spectra are stored in blocks of V frequencies (V = SIMD width): for each
+// block and channel V real parts followed by V imaginary parts
+inline size_t spectrum_blocks(serial_size_t n) {
+  typedef vectorize::CNN_VECTORIZE_TYPE T;
+  const size_t freqs = size_t(n) * (n / 2 + 1);
+  return (freqs + T::unroll_size - 1) / T::unroll_size;
+}
+
+// stores frequency f of (sre, sim) at block f / V of dst, for channel c of
+// channels
+inline void store_spectrum(const float_t *sre,
+                           const float_t *sim,
+                           size_t freqs,
+                           serial_size_t c,
+                           serial_size_t channels,
+                           float_t scale,
+                           float_t *dst) {
+  const size_t v = vectorize::CNN_VECTORIZE_TYPE::unroll_size;
+  for (size_t f = 0; f < freqs; f++) {
+    float_t *d = dst + ((f / v) * channels + c) * 2 * v + f % v;
+    d[0]       = sre[f] * scale;
+    d[v]       = sim[f] * scale;
+  }
+}
+
+// (yr, yi) = sum over the channels of s .* x for the spectra x of lanes
+// tiles, x + l * x_stride and yr/yi + l * y_stride for tile l. each block
+// of s is applied to all the tiles while it is in cache.
+inline void multiply_spectra(const float_t *s,
+                             const float_t *x,
+                             size_t x_stride,
+                             size_t lanes,
+                             serial_size_t channels,
+                             size_t blocks,
+                             float_t *yr,
+                             float_t *yi,
+                             size_t y_stride) {
+  typedef vectorize::CNN_VECTORIZE_TYPE T;
+  typedef typename T::register_type reg;
+  const size_t v      = T::unroll_size;
+  const size_t stride = 2 * v;
+  const reg minus_one = T::set1(float_t(-1));
+  for (size_t b = 0; b < blocks; b++) {
+    for (size_t l = 0; l < lanes; l++) {
+      const float_t *ps = s + b * channels * stride;
+      const float_t *px = x + l * x_stride + b * channels * stride;
+      // two channels at a time into separate sums, to hide the latency
+      reg rr0 = T::zero(), ii0 = T::zero(), ri0 = T::zero(), ir0 = T::zero();
+      reg rr1 = T::zero(), ii1 = T::zero(), ri1 = T::zero(), ir1 = T::zero();
+      serial_size_t c = 0;
+      for (; c + 2 <= channels; c += 2, ps += 2 * stride, px += 2 * stride) {
+        const reg sr0 = T::template load<std::false_type>(ps);
+        const reg si0 = T::template load<std::false_type>(ps + v);
+        const reg xr0 = T::template load<std::false_type>(px);
+        const reg xi0 = T::template load<std::false_type>(px + v);
+        const reg sr1 = T::template load<std::false_type>(ps + stride);
+        const reg si1 = T::template load<std::false_type>(ps + stride + v);
+        const reg xr1 = T::template load<std::false_type>(px + stride);
+        const reg xi1 = T::template load<std::false_type>(px + stride + v);
+        rr0           = T::madd(sr0, xr0, rr0);
+        ii0           = T::madd(si0, xi0, ii0);
+        ri0           = T::madd(sr0, xi0, ri0);
+        ir0           = T::madd(si0, xr0, ir0);
+        rr1           = T::madd(sr1, xr1, rr1);
+        ii1           = T::madd(si1, xi1, ii1);
+        ri1           = T::madd(sr1, xi1, ri1);
+        ir1           = T::madd(si1, xr1, ir1);
+      }
+      if (c < channels) {
+        const reg sr0 = T::template load<std::false_type>(ps);
+        const reg si0 = T::template load<std::false_type>(ps + v);
+        const reg xr0 = T::template load<std::false_type>(px);
+        const reg xi0 = T::template load<std::false_type>(px + v);
+        rr0           = T::madd(sr0, xr0, rr0);
+        ii0           = T::madd(si0, xi0, ii0);
+        ri0           = T::madd(sr0, xi0, ri0);
+        ir0           = T::madd(si0, xr0, ir0);
+      }
+      const reg rr = T::add(rr0, rr1), ii = T::add(ii0, ii1);
+      const reg im = T::add(T::add(ri0, ri1), T::add(ir0, ir1));
+      T::template store<std::false_type>(yr + l * y_stride + b * v,
+                                         T::madd(minus_one, ii, rr));
+      T::template store<std::false_type>(yi + l * y_stride + b * v, im);
+    }
+  }
+}
+
+// the spectra of the kw x kh filters W[o * id + c] for tiles of n x n,
+// conjugated for the correlation and scaled by 1 / (n * n); out channel o
+// starts at S[o * spectrum_blocks(n) * 2 * V * id]
+inline void transform_filter(const vec_t &W,
+                             const core::connection_table &tbl,
+                             serial_size_t kw,
+                             serial_size_t kh,
+                             serial_size_t id,
+                             serial_size_t od,
+                             bool flip,
+                             serial_size_t n,
+                             vec_t &S) {
+  const fft_plan p(n);
+  const size_t freqs  = size_t(n) * (n / 2 + 1);
+  const size_t plane  = spectrum_blocks(n) * 2 *
+                       vectorize::CNN_VECTORIZE_TYPE::unroll_size * id;
+  const float_t scale = float_t(1) / (float_t(n) * n);
+
+  S.assign(od * plane, float_t(0));
+  vec_t buf(n * n + 2 * freqs);
+  float_t *zr = &buf[0], *zi = zr + n * n / 2, *sre = zi + n * n / 2;
+  float_t *sim = sre + freqs;
+  for (serial_size_t o = 0; o < od; o++) {
+    for (serial_size_t c = 0; c < id; c++) {
+      if (!tbl.is_connected(o, c)) continue;
+      const float_t *w = &W[(size_t(id) * o + c) * kw * kh];
+      std::fill(zr, zr + n * n, float_t(0));
+      for (serial_size_t y = 0; y < kh; y++) {
+        float_t *z = (y % 2 ? zi : zr) + y / 2;
+        for (serial_size_t i = 0; i < kw; i++) {
+          z[i * n / 2] =
+            flip ? w[(kh - 1 - y) * kw + (kw - 1 - i)] : w[y * kw + i];
+        }
+      }
+      forward_2d(p, zr, zi, sre, sim);
+      // conj(w) = (re, -im)
+      for (size_t f = 0; f < freqs; f++) sim[f] = -sim[f];
+      store_spectrum(sre, sim, freqs, c, id, scale, &S[o * plane]);
+    }
+  }
+}
+
+struct correlation {
+  serial_size_t iw, ih, id;    // input planes
+  serial_size_t pad_w, pad_h;  // zeros around the input (deconvolution)
+  serial_size_t kw, kh;        // window
+  serial_size_t ow, oh, od;    // output planes
+};
+
+// out = correlation of the inputs with the filters of S, plus bias if
+// has_bias; see transform_filter
+inline void correlate(const tensor_t &in_data,
+                      const vec_t &S,
+                      serial_size_t n,
+                      const correlation &cr,
+                      const vec_t &bias,
+                      bool has_bias,
+                      tensor_t &out_data,
+                      const bool parallelize) {
+  const fft_plan p(n);
+  const size_t freqs     = size_t(n) * (n / 2 + 1);
+  const size_t fblocks   = spectrum_blocks(n);
+  const size_t padded    = fblocks * vectorize::CNN_VECTORIZE_TYPE::unroll_size;
+  const serial_size_t id = cr.id, od = cr.od;
+  const size_t plane     = padded * 2 * id;  // spectra of a tile
+  const serial_size_t mw = n - cr.kw + 1, mh = n - cr.kh + 1;
+  const size_t tiles_w   = (cr.ow + mw - 1) / mw;
+  const size_t tiles     = tiles_w * ((cr.oh + mh - 1) / mh);
+  const size_t total     = tiles * in_data.size();
+
+  // tiles per block: the spectra of a block take about 2MB, so that they
+  // stay in cache while the filters of each out channel are applied
+  const size_t block  = std::min(
+    total, std::max<size_t>(1, (size_t(1) << 19) / plane));
+  const size_t blocks = (total + block - 1) / block;
+
+  // with fewer blocks than threads, the channels of each block are split
+  // between the threads instead
+  const bool split = parallelize && blocks < num_threads();
+
+  for_i(parallelize && !split, blocks, [&](size_t b) {
+    const size_t t0    = b * block;
+    const size_t lanes = std::min(block, total - t0);
+    vec_t X(lanes * plane);
+
+    for_i(split, id, [&](size_t c) {
+      vec_t scratch(n * n + 2 * freqs);
+      float_t *zr = &scratch[0], *zi = zr + n * n / 2, *sre = zi + n * n / 2;
+      float_t *sim = sre + freqs;
+      for (size_t l = 0; l < lanes; l++) {
+        const size_t tile  = (t0 + l) % tiles;
+        const long x0      = long((tile % tiles_w) * mw) - long(cr.pad_w);
+        const long y0      = long((tile / tiles_w) * mh) - long(cr.pad_h);
+        const float_t *pin = &in_data[(t0 + l) / tiles][size_t(c) * cr.iw *
+                                                         cr.ih];
+        for (serial_size_t i = 0; i < n; i++) {
+          const long y = y0 + long(i);
+          float_t *z   = (i % 2 ? zi : zr) + i / 2;
+          for (serial_size_t j = 0; j < n; j++) {
+            const long xx = x0 + long(j);
+            z[j * n / 2]  = (y >= 0 && y < long(cr.ih) && xx >= 0 &&
+                            xx < long(cr.iw))
+                             ? pin[y * cr.iw + xx]
+                             : float_t(0);
+          }
+        }
+        forward_2d(p, zr, zi, sre, sim);
+        store_spectrum(sre, sim, freqs, static_cast<serial_size_t>(c), id,
+                       float_t(1), &X[l * plane]);
+      }
+    }, 1);
+
+    for_i(split, od, [&](size_t o) {
+      vec_t scratch(n * n + 2 * padded * lanes);
+      float_t *zr = &scratch[0], *zi = zr + n * n / 2, *Y = zi + n * n / 2;
+      const float_t b0 = has_bias ? bias[o] : float_t(0);
+      multiply_spectra(&S[o * plane], &X[0], plane, lanes, id, fblocks, Y,
+                       Y + padded, 2 * padded);
+      for (size_t l = 0; l < lanes; l++) {
+        float_t *sre = Y + l * 2 * padded, *sim = sre + padded;
+        const size_t tile = (t0 + l) % tiles;
+        const size_t x0   = (tile % tiles_w) * mw;
+        const size_t y0   = (tile / tiles_w) * mh;
+        const size_t rows = std::min<size_t>(mh, cr.oh - y0);
+        const size_t cols = std::min<size_t>(mw, cr.ow - x0);
+        inverse_2d(p, sre, sim, static_cast<serial_size_t>((rows + 1) / 2),
+                   zr, zi);
+        float_t *pout = &out_data[(t0 + l) / tiles][size_t(o) * cr.ow *
+                                                    cr.oh];
+        for (size_t i = 0; i < rows; i++) {
+          const float_t *z = (i % 2 ? zi : zr) + i / 2;
+          for (size_t j = 0; j < cols; j++) {
+            pout[(y0 + i) * cr.ow + x0 + j] = z[j * n / 2] + b0;
+          }
+        }
+      }
+    }, 1);
+  }, 1);
+}
+
+// estimated cost of the FFT convolution with n x n tiles, in
+// multiply-adds of a gemm. a transform costs about 16 of them per
+// n * n * log2(n), gathering the tiles included.
+inline double fft_cost(serial_size_t n, const correlation &cr) {
+  if (n < cr.kw + 1 || n < cr.kh + 1) {
+    return std::numeric_limits<double>::infinity();
+  }
+  const double mw = n - cr.kw + 1, mh = n - cr.kh + 1;
+  const double tiles = std::ceil(cr.ow / mw) * std::ceil(cr.oh / mh);
+  const double freqs = double(n) * (n / 2 + 1);
+  double log2n       = 0;
+  for (serial_size_t k = n; k > 1; k /= 2) log2n++;
+  const double products = 4.0 * freqs * cr.id * cr.od;
+  const double ffts     = 16.0 * (cr.id + cr.od) * n * n * log2n;
+  return tiles * (products + ffts);
+}
+
+// the cheapest tile size, or 0 unless the FFT convolution is estimated to
+// be margin times cheaper than direct multiply-adds
+inline serial_size_t fft_size(const correlation &cr,
+                              double direct,
+                              double margin) {
+  // tiles beyond the padded output would only add zeros
+  const serial_size_t span = std::max(cr.ow + cr.kw, cr.oh + cr.kh);
+  serial_size_t best       = 0;
+  double best_cost         = direct / margin;
+  for (serial_size_t n = 8; n <= 64; n *= 2) {
+    const double cost = fft_cost(n, cr);
+    if (cost < best_cost) {
+      best      = n;
+      best_cost = cost;
+    }
+    if (n >= span) break;
+  }
+  return best;
+}
+
+inline correlation conv_correlation(const core::conv_params &params) {
+  return {params.in_padded.width_,
+          params.in_padded.height_,
+          params.in.depth_,
+          0,
+          0,
+          params.weight.width_,
+          params.weight.height_,
+          params.out.width_,
+          params.out.height_,
+          params.out.depth_};
+}
+
+inline correlation deconv_correlation(const core::deconv_params &params) {
+  return {params.in.width_,
+          params.in.height_,
+          params.in.depth_,
+          params.weight.width_ - 1,
+          params.weight.height_ - 1,
+          params.weight.width_,
+          params.weight.height_,
+          params.out.width_,
+          params.out.height_,
+          params.out.depth_};
+}
+
+}  // namespace fft_detail
+
+/**
+ * FFT tile size for params, or 0 if im2col + gemm is expected to be faster
+ * (or the strides aren't 1, or the channels are grouped). only windows of
+ * 5x5 and up on large enough outputs pay for the transforms.
+ **/
+inline serial_size_t conv2d_fft_size(const core::conv_params &params) {
+  if (params.w_stride != 1 || params.h_stride != 1) return 0;
+  if (params.groups != 1) return 0;
+  // 3x3 windows are left to the Winograd kernel
+  if (params.weight.width_ * params.weight.height_ < 25) return 0;
+  const fft_detail::correlation cr = fft_detail::conv_correlation(params);
+  const double direct = double(cr.ow) * cr.oh * cr.kw * cr.kh * cr.id * cr.od;
+  return fft_detail::fft_size(cr, direct, 1.5);
+}
+
+/**
+ * transform the filters W for the FFT kernel with n x n tiles.
+ **/
+inline void conv2d_fft_transform_filter(const core::conv_params &params,
+                                        const vec_t &W,
+                                        serial_size_t n,
+                                        vec_t &S) {
+  fft_detail::transform_filter(W, params.tbl, params.weight.width_,
+                               params.weight.height_, params.in.depth_,
+                               params.out.depth_, false, n, S);
+}
+
+/**
+ * FFT convolution with filters transformed by
+ * conv2d_fft_transform_filter(params, W, n, S). the tiles are blocked and
+ * split between the threads like those of conv2d_op_winograd.
+ **/
+inline void conv2d_op_fft(const tensor_t &in_data,
+                          const vec_t &S,
+                          serial_size_t n,
+                          const vec_t &bias,
+                          tensor_t &out_data,
+                          const core::conv_params &params,
+                          const bool parallelize) {
+  if (params.w_stride != 1 || params.h_stride != 1) {
+    throw nn_error("FFT convolution needs unit strides");
+  }
+  fft_detail::correlate(in_data, S, n, fft_detail::conv_correlation(params),
+                        bias, params.has_bias, out_data, parallelize);
+  if (params.epilogue) {
+    for_i(parallelize, out_data.size(),
+          [&](size_t sample) { params.epilogue(out_data[sample]); });
+  }
+}
+
+inline void conv2d_op_fft(const tensor_t &in_data,
+                          const vec_t &W,
+                          const vec_t &bias,
+                          tensor_t &out_data,
+                          const core::conv_params &params,
+                          const bool parallelize,
+                          serial_size_t n) {
+  vec_t S;
+  conv2d_fft_transform_filter(params, W, n, S);
+  conv2d_op_fft(in_data, S, n, bias, out_data, params, parallelize);
+}
+
+/**
+ * FFT tile size for the deconvolution params, or 0 if the direct loops
+ * are expected to be faster (or the strides aren't 1).
+ **/
+inline serial_size_t deconv2d_fft_size(const core::deconv_params &params) {
+  if (params.w_stride != 1 || params.h_stride != 1) return 0;
+  const fft_detail::correlation cr = fft_detail::deconv_correlation(params);
+  const double direct =
+    double(cr.iw) * cr.ih * cr.kw * cr.kh * cr.id * cr.od;
+  // the direct loops scatter one product at a time, some 20 times slower
+  // than gemm
+  return fft_detail::fft_size(cr, direct * 20, 1.5);
+}
+
+inline void deconv2d_fft_transform_filter(const core::deconv_params &params,
+                                          const vec_t &W,
+                                          serial_size_t n,
+                                          vec_t &S) {
+  fft_detail::transform_filter(W, params.tbl, params.weight.width_,
+                               params.weight.height_, params.in.depth_,
+                               params.out.depth_, true, n, S);
+}
+
+/**
+ * deconvolution with unit strides into the padded outputs (params.out),
+ * with filters transformed by deconv2d_fft_transform_filter.
+ **/
+inline void deconv2d_op_fft(const tensor_t &in_data,
+                            const vec_t &S,
+                            serial_size_t n,
+                            const vec_t &bias,
+                            tensor_t &out_data,
+                            const core::deconv_params &params,
+                            const bool parallelize) {
+  if (params.w_stride != 1 || params.h_stride != 1) {
+    throw nn_error("FFT deconvolution needs unit strides");
+  }
+  fft_detail::correlate(in_data, S, n, fft_detail::deconv_correlation(params),
+                        bias, params.has_bias, out_data, parallelize);
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
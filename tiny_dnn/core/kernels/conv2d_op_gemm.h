@@ -0,0 +1,227 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include "tiny_dnn/core/kernels/gemm.h"
+#include "tiny_dnn/core/params/conv_params.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+// convolution lowered to matrix multiplication.
+//
+// the weights of output channel o are row o of a od x (id * kh * kw) matrix,
+// and im2col lays the receptive field of output pixel p out as column p of a
+// (id * kh * kw) x (oh * ow) matrix, so that out = W * col. with groups,
+// group g is a multiplication of its own: rows g * od / groups, ... of W
+// (which then have id / groups * kh * kw columns) with the im2col rows of
+// its input channels.
+
+// col[(c * kh + ky) * kw + kx][y * ow + x] = in(x * w_stride + kx,
+//                                               y * h_stride + ky, c)
+// the input channels are split between the threads when parallelize is set.
+inline void conv2d_im2col(const core::conv_params &params,
+                          const float_t *in,
+                          float_t *col,
+                          bool parallelize = false) {
+  const serial_size_t ow = params.out.width_;
+  const serial_size_t oh = params.out.height_;
+  const serial_size_t sx = params.w_stride;
+  const serial_size_t sy = params.h_stride;
+  const size_t rows      = params.weight.width_ * params.weight.height_;
+
+  for_i(parallelize, params.in.depth_,
+        [&](size_t c) {
+          float_t *dst = col + c * rows * oh * ow;
+          for (serial_size_t ky = 0; ky < params.weight.height_; ky++) {
+            for (serial_size_t kx = 0; kx < params.weight.width_; kx++) {
+              for (serial_size_t y = 0; y < oh; y++) {
+                const float_t *src = in + params.in_padded.get_index(
+                                            kx, y * sy + ky, c);
+                if (sx == 1) {
+                  std::copy(src, src + ow, dst);
+                } else {
+                  for (serial_size_t x = 0; x < ow; x++) dst[x] = src[x * sx];
+                }
+                dst += ow;
+              }
+            }
+          }
+        },
+        1);
+}
+
+// inverse of conv2d_im2col. overlapping receptive fields are summed into in.
+inline void conv2d_col2im(const core::conv_params &params,
+                          const float_t *col,
+                          float_t *in) {
+  const serial_size_t ow = params.out.width_;
+  const serial_size_t oh = params.out.height_;
+  const serial_size_t sx = params.w_stride;
+  const serial_size_t sy = params.h_stride;
+
+  for (serial_size_t c = 0; c < params.in.depth_; c++) {
+    for (serial_size_t ky = 0; ky < params.weight.height_; ky++) {
+      for (serial_size_t kx = 0; kx < params.weight.width_; kx++) {
+        for (serial_size_t y = 0; y < oh; y++) {
+          float_t *dst = in + params.in_padded.get_index(kx, y * sy + ky, c);
+          for (serial_size_t x = 0; x < ow; x++) dst[x * sx] += col[x];
+          col += ow;
+        }
+      }
+    }
+  }
+}
+
+// with a 1x1 kernel and unit strides the input already is the column matrix
+inline bool conv2d_is_pointwise(const core::conv_params &params) {
+  return params.weight.width_ == 1 && params.weight.height_ == 1 &&
+         params.w_stride == 1 && params.h_stride == 1 &&
+         params.in_padded.width_ == params.out.width_ &&
+         params.in_padded.height_ == params.out.height_;
+}
+
+// weights with the filters of disconnected (out, in) pairs set to zero
+inline const float_t *conv2d_gemm_weights(const core::conv_params &params,
+                                          const vec_t &W,
+                                          vec_t &masked) {
+  if (params.tbl.is_empty()) return &W[0];
+
+  const serial_size_t id   = params.in.depth_;
+  const serial_size_t area = params.weight.width_ * params.weight.height_;
+  masked                   = W;
+  for (serial_size_t o = 0; o < params.out.depth_; o++) {
+    for (serial_size_t inc = 0; inc < id; inc++) {
+      if (params.tbl.is_connected(o, inc)) continue;
+      float_t *pw = &masked[params.weight.get_index(0, 0, id * o + inc)];
+      std::fill(pw, pw + area, float_t(0));
+    }
+  }
+  return &masked[0];
+}
+
+inline void conv2d_op_gemm(const tensor_t &in_data,
+                           const vec_t &W,
+                           const vec_t &bias,
+                           tensor_t &out_data,
+                           const core::conv_params &params,
+                           const bool parallelize) {
+  const size_t od      = params.out.depth_;
+  const size_t groups  = params.groups;
+  const size_t og      = od / groups;
+  const size_t area    = params.out.area();
+  const size_t patch   = params.weight.size() / od;
+  const bool pointwise = conv2d_is_pointwise(params);
+
+  vec_t masked;
+  const float_t *pw = conv2d_gemm_weights(params, W, masked);
+
+  // with a small batch, im2col and the multiplication of each sample are
+  // split between the threads instead
+  const bool split = parallelize_within_samples(parallelize, in_data.size());
+
+  for_i(parallelize && !split, in_data.size(), [&](size_t sample) {
+    vec_t col;
+    const float_t *pcol = &in_data[sample][0];
+    if (!pointwise) {
+      col.resize(groups * patch * area);
+      conv2d_im2col(params, pcol, &col[0], split);
+      pcol = &col[0];
+    }
+
+    float_t *out = &out_data[sample][0];
+    for (size_t g = 0; g < groups; g++) {
+      parallel_gemm(split, false, false, og, area, patch, pw + g * og * patch,
+                    patch, pcol + g * patch * area, area, out + g * og * area,
+                    area, false);
+    }
+
+    if (params.has_bias) {
+      for (size_t o = 0; o < od; o++) {
+        vectorize::add(bias[o], area, out + o * area);
+      }
+    }
+    if (params.epilogue) params.epilogue(out_data[sample]);
+  });
+}
+
+inline void conv2d_grad_op_gemm(const tensor_t &prev_out,
+                                const vec_t &W,
+                                tensor_t &dW,
+                                tensor_t &db,
+                                tensor_t &curr_delta,
+                                tensor_t &prev_delta,
+                                const core::conv_params &params,
+                                const bool parallelize) {
+  const size_t od       = params.out.depth_;
+  const size_t groups   = params.groups;
+  const size_t og       = od / groups;
+  const size_t area     = params.out.area();
+  const size_t patch    = params.weight.size() / od;
+  const bool pointwise  = conv2d_is_pointwise(params);
+  const bool masked_tbl = !params.tbl.is_empty();
+
+  vec_t masked;
+  const float_t *pw = conv2d_gemm_weights(params, W, masked);
+
+  // samples of the same slot share one row of dW and db
+  for_i_slots(parallelize, prev_out.size(), dW.size(), [&](size_t sample,
+                                                           size_t slot) {
+    const float_t *delta = &curr_delta[sample][0];
+    vec_t col;
+
+    // propagate delta to previous layer: prev_delta += col2im(W^T * delta)
+    if (!pointwise) col.resize(groups * patch * area);
+    float_t *pdst = pointwise ? &prev_delta[sample][0] : &col[0];
+    for (size_t g = 0; g < groups; g++) {
+      gemm(true, false, patch, area, og, pw + g * og * patch, patch,
+           delta + g * og * area, area, pdst + g * patch * area, area,
+           pointwise);
+    }
+    if (!pointwise) conv2d_col2im(params, &col[0], &prev_delta[sample][0]);
+
+    // accumulate dw: dW += delta * col^T
+    const float_t *pcol = &prev_out[sample][0];
+    if (!pointwise) {
+      conv2d_im2col(params, pcol, &col[0]);
+      pcol = &col[0];
+    }
+
+    if (masked_tbl) {
+      vec_t dw(od * patch);
+      gemm(false, true, od, patch, area, delta, area, pcol, area, &dw[0],
+           patch, false);
+      const serial_size_t id   = params.in.depth_;
+      const serial_size_t size = params.weight.width_ * params.weight.height_;
+      for (serial_size_t o = 0; o < od; o++) {
+        for (serial_size_t inc = 0; inc < id; inc++) {
+          if (!params.tbl.is_connected(o, inc)) continue;
+          const serial_size_t idx = params.weight.get_index(0, 0, id * o + inc);
+          vectorize::reduce<float_t>(&dw[idx], size, &dW[slot][idx]);
+        }
+      }
+    } else {
+      for (size_t g = 0; g < groups; g++) {
+        gemm(false, true, og, patch, area, delta + g * og * area, area,
+             pcol + g * patch * area, area, &dW[slot][g * og * patch], patch,
+             true);
+      }
+    }
+
+    // accumulate db
+    if (params.has_bias) {
+      for (size_t o = 0; o < od; o++) {
+        const float_t *d = delta + o * area;
+        db[slot][o] += std::accumulate(d, d + area, float_t{0});
+      }
+    }
+  });
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
@@ -16,59 +16,65 @@ inline void conv2d_op_internal(const tensor_t &in_data,
                                tensor_t &out_data,
                                const core::conv_params &params,
                                const bool parallelize) {
-  for_(parallelize, 0, in_data.size(),
-       [&](const blocked_range &r) {
-         size_t out_area           = params.out.area();
-         serial_size_t iw          = params.in_padded.width_;
-         serial_size_t id          = params.in.depth_;
-         serial_size_t ow          = params.out.width_;
-         serial_size_t oh          = params.out.height_;
-         serial_size_t od          = params.out.depth_;
-         serial_size_t kw          = params.weight.width_;
-         serial_size_t kh          = params.weight.height_;
-         serial_size_t elem_stride = params.w_stride;
-         serial_size_t line_stride = iw * params.h_stride;
-         for (size_t sample = r.begin(); sample < r.end(); sample++) {
-           const vec_t &in = in_data[sample];
-           vec_t &a        = out_data[sample];
-           for (serial_size_t o = 0; o < od; o++) {
-             float_t *pa = &a[params.out.get_index(0, 0, o)];
-             for (serial_size_t inc = 0; inc < id; inc++) {
-               if (!params.tbl.is_connected(o, inc)) continue;
-               serial_size_t idx;
-               idx                = params.weight.get_index(0, 0, id * o + inc);
-               const float_t *pw  = &W[idx];
-               idx                = params.in_padded.get_index(0, 0, inc);
-               const float_t *pin = &in[idx];
-               float_t *pout      = pa;
-               for (serial_size_t y = 0; y < oh; y++) {
-                 const float_t *pin_line = pin;
-                 for (serial_size_t x = 0; x < ow; x++) {
-                   const float_t *pin_element = pin_line;
-                   const float_t *pw_element  = pw;
-                   float_t sum{0};
-                   // should be optimized for small kernel(3x3,5x5)
-                   for (serial_size_t wy = 0; wy < kh; wy++) {    // NOLINT
-                     for (serial_size_t wx = 0; wx < kw; wx++) {  // NOLINT
-                       sum += pw_element[wx] * pin_element[wx];
-                     }
-                     pw_element += kw;
-                     pin_element += iw;
-                   }
-                   pout[x] += sum;
-                   pin_line += elem_stride;
-                 }
-                 pout += ow;
-                 pin += line_stride;
-               }
-             }
-             if (params.has_bias) {
-               vectorize::add(bias[o], out_area, pa);
-             }
-           }
-         }
-       },
-       0);
+  size_t out_area           = params.out.area();
+  serial_size_t iw          = params.in_padded.width_;
+  serial_size_t id          = params.in.depth_;
+  serial_size_t ow          = params.out.width_;
+  serial_size_t oh          = params.out.height_;
+  serial_size_t od          = params.out.depth_;
+  serial_size_t kw          = params.weight.width_;
+  serial_size_t kh          = params.weight.height_;
+  serial_size_t elem_stride = params.w_stride;
+  serial_size_t line_stride = iw * params.h_stride;
+  serial_size_t ig          = id / params.groups;
+  serial_size_t og          = od / params.groups;
+
+  // with a small batch, the output channels of a sample are split instead
+  const bool split = parallelize_within_samples(parallelize, in_data.size());
+
+  for_i(parallelize && !split, in_data.size(), [&](size_t sample) {
+    const vec_t &in = in_data[sample];
+    vec_t &a        = out_data[sample];
+    for_i(split, od,
+          [&](size_t o) {
+            float_t *pa = &a[params.out.get_index(0, 0, o)];
+            for (serial_size_t i = 0; i < ig; i++) {
+              const serial_size_t inc = o / og * ig + i;
+              if (!params.tbl.is_connected(o, inc)) continue;
+              serial_size_t idx;
+              idx                = params.weight.get_index(0, 0, ig * o + i);
+              const float_t *pw  = &W[idx];
+              idx                = params.in_padded.get_index(0, 0, inc);
+              const float_t *pin = &in[idx];
+              float_t *pout      = pa;
+              for (serial_size_t y = 0; y < oh; y++) {
+                const float_t *pin_line = pin;
+                for (serial_size_t x = 0; x < ow; x++) {
+                  const float_t *pin_element = pin_line;
+                  const float_t *pw_element  = pw;
+                  float_t sum{0};
+                  // should be optimized for small kernel(3x3,5x5)
+                  for (serial_size_t wy = 0; wy < kh; wy++) {    // NOLINT
+                    for (serial_size_t wx = 0; wx < kw; wx++) {  // NOLINT
+                      sum += pw_element[wx] * pin_element[wx];
+                    }
+                    pw_element += kw;
+                    pin_element += iw;
+                  }
+                  pout[x] += sum;
+                  pin_line += elem_stride;
+                }
+                pout += ow;
+                pin += line_stride;
+              }
+            }
+            if (params.has_bias) {
+              vectorize::add(bias[o], out_area, pa);
+            }
+          },
+          1);
+    if (params.epilogue) params.epilogue(a);
+  });
 }
 
 /******************************************************************/
@@ -83,15 +89,20 @@ void conv2d_op_internal(const tensor_t &prev_out,
                         const core::conv_params &params,
                         const bool parallelize) {
   typedef typename vec_t::value_type float_t;
+  const serial_size_t ig = params.in.depth_ / params.groups;
+  const serial_size_t og = params.out.depth_ / params.groups;
 
-  for_i(parallelize, prev_out.size(), [&](int sample) {
+  // samples of the same slot share one row of dW and db
+  for_i_slots(parallelize, prev_out.size(), dW.size(), [&](size_t sample,
+                                                           size_t slot) {
     // propagate delta to previous layer
     for (serial_size_t inc = 0; inc < params.in.depth_; inc++) {
-      for (serial_size_t outc = 0; outc < params.out.depth_; outc++) {
+      for (serial_size_t outc = inc / ig * og; outc < (inc / ig + 1) * og;
+           outc++) {
         if (!params.tbl.is_connected(outc, inc)) continue;
 
         serial_size_t idx = 0;
-        idx               = params.in.depth_ * outc + inc;
+        idx               = ig * outc + inc % ig;
         idx               = params.weight.get_index(0, 0, idx);
         const float_t *pw = &W[idx];
 
@@ -128,7 +139,8 @@ void conv2d_op_internal(const tensor_t &prev_out,
 
     // accumulate dw
     for (serial_size_t inc = 0; inc < params.in.depth_; inc++) {
-      for (serial_size_t outc = 0; outc < params.out.depth_; outc++) {
+      for (serial_size_t outc = inc / ig * og; outc < (inc / ig + 1) * og;
+           outc++) {
         if (!params.tbl.is_connected(outc, inc)) continue;
 
         for (serial_size_t wy = 0; wy < params.weight.height_; wy++) {
@@ -161,8 +173,8 @@ void conv2d_op_internal(const tensor_t &prev_out,
               }
             }
 
-            idx = params.in.depth_ * outc + inc;
-            dW[sample][params.weight.get_index(wx, wy, idx)] += dst;
+            idx = ig * outc + inc % ig;
+            dW[slot][params.weight.get_index(wx, wy, idx)] += dst;
           }
         }
       }
@@ -174,7 +186,7 @@ void conv2d_op_internal(const tensor_t &prev_out,
         serial_size_t idx     = params.out.get_index(0, 0, outc);
         const float_t *delta  = &curr_delta[sample][idx];
         const float_t *deltaa = delta + params.out.width_ * params.out.height_;
-        db[sample][outc] += std::accumulate(delta, deltaa, float_t{0});
+        db[slot][outc] += std::accumulate(delta, deltaa, float_t{0});
       }
     }
   });
@@ -75,6 +75,8 @@ inline void conv2d_op_nnpack(const tensor_t &in_data,
 
   // TODO: embed it into a class
   pthreadpool_destroy(threadpool);
+
+  if (params.epilogue) params.epilogue(out_data[0]);
 #else
   CNN_UNREFERENCED_PARAMETER(in_data);
   CNN_UNREFERENCED_PARAMETER(W);
@@ -0,0 +1,346 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "tiny_dnn/core/kernels/gemm.h"
+#include "tiny_dnn/core/params/conv_params.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+// Winograd convolution F(m x m, 3 x 3) for 3x3 kernels with unit strides.
+//
+// the output is cut into m x m tiles, each computed from an a x a tile of
+// the input (a = m + 2). with the transforms
+//
+//   U = G g G^T      (3x3 filter g,  a x a)
+//   V = B^T d B      (input tile d,  a x a)
+//   Y = A^T M A      (output tile Y, m x m)
+//
+// the convolution becomes M = U .* V summed over the input channels, which
+// for each of the a * a points is a (out channels x in channels) by
+// (in channels x tiles) matrix multiplication. F(2x2, 3x3) needs 16
+// multiplications per 4 outputs instead of 36, F(4x4, 3x3) 36 per 16
+// instead of 144.
+// Based on: A. Lavin and S. Gray, Fast algorithms for convolutional neural
+// networks, 2016
+
+namespace winograd_detail {
+
+// F(2x2, 3x3)
+static const float_t bt2[4 * 4] = {1, 0, -1, 0,  //
+                                   0, 1, 1,  0,  //
+                                   0, -1, 1, 0,  //
+                                   0, 1, 0,  -1};
+static const float_t g2[4 * 3]  = {1,   0,    0,    //
+                                  0.5, 0.5,  0.5,  //
+                                  0.5, -0.5, 0.5,  //
+                                  0,   0,    1};
+static const float_t at2[2 * 4] = {1, 1, 1, 0,  //
+                                   0, 1, -1, -1};
+
+// F(4x4, 3x3)
+static const float_t bt4[6 * 6] = {4, 0,  -5, 0,  1, 0,  //
+                                   0, -4, -4, 1,  1, 0,  //
+                                   0, 4,  -4, -1, 1, 0,  //
+                                   0, -2, -1, 2,  1, 0,  //
+                                   0, 2,  -1, -2, 1, 0,  //
+                                   0, 4,  0,  -5, 0, 1};
+static const float_t g4[6 * 3]  = {
+  float_t(1) / 4,  0,                0,                //
+  -float_t(1) / 6, -float_t(1) / 6,  -float_t(1) / 6,  //
+  -float_t(1) / 6, float_t(1) / 6,   -float_t(1) / 6,  //
+  float_t(1) / 24, float_t(1) / 12,  float_t(1) / 6,   //
+  float_t(1) / 24, -float_t(1) / 12, float_t(1) / 6,   //
+  0,               0,                1};
+static const float_t at4[4 * 6] = {1, 1, 1,  1, 1,  0,  //
+                                   0, 1, -1, 2, -2, 0,  //
+                                   0, 1, 1,  4, 4,  0,  //
+                                   0, 1, -1, 8, -8, 1};
+
+struct transforms {
+  serial_size_t m;   // output tile size
+  serial_size_t a;   // input tile size, m + 2
+  const float_t *bt;  // a x a
+  const float_t *g;   // a x 3
+  const float_t *at;  // m x a
+};
+
+inline transforms get_transforms(serial_size_t m) {
+  if (m == 2) return {2, 4, bt2, g2, at2};
+  if (m == 4) return {4, 6, bt4, g4, at4};
+  throw nn_error("unsupported Winograd tile size");
+}
+
+// dst[l] = sum_k coef[k] * src[k * stride + l] for l < lanes.
+// the zero coefficients of the transforms are skipped.
+inline void combine(const float_t *coef,
+                    serial_size_t n,
+                    const float_t *src,
+                    size_t stride,
+                    size_t lanes,
+                    float_t *dst) {
+  typedef vectorize::CNN_VECTORIZE_TYPE T;
+  const float_t *rows[8];
+  float_t c[8];
+  serial_size_t nz = 0;
+  for (serial_size_t k = 0; k < n; k++) {
+    if (coef[k] == float_t(0)) continue;
+    rows[nz] = src + k * stride;
+    c[nz++]  = coef[k];
+  }
+
+  const size_t sz = T::unroll_size;
+  size_t l        = 0;
+  for (; l + sz <= lanes; l += sz) {
+    typename T::register_type acc = T::zero();
+    for (serial_size_t k = 0; k < nz; k++) {
+      acc = T::madd(T::set1(c[k]),
+                    T::template load<std::false_type>(rows[k] + l), acc);
+    }
+    T::template store<std::false_type>(dst + l, acc);
+  }
+  for (; l < lanes; l++) {
+    float_t acc = 0;
+    for (serial_size_t k = 0; k < nz; k++) acc += c[k] * rows[k][l];
+    dst[l] = acc;
+  }
+}
+
+// dst[(i * n + j) * dst_stride + l] = (X s X^T)[i][j][l] for an n x n
+// matrix of lanes s with rows src + (i * n + j) * src_stride, X = coef
+// (rows x n). tmp holds rows * n * lanes values.
+inline void transform_2d(const float_t *coef,
+                         serial_size_t rows,
+                         serial_size_t n,
+                         const float_t *src,
+                         size_t src_stride,
+                         size_t lanes,
+                         float_t *tmp,
+                         float_t *dst,
+                         size_t dst_stride) {
+  // tmp = X s
+  for (serial_size_t i = 0; i < rows; i++) {
+    for (serial_size_t j = 0; j < n; j++) {
+      combine(coef + i * n, n, src + j * src_stride, n * src_stride, lanes,
+              tmp + (i * n + j) * lanes);
+    }
+  }
+  // dst = tmp X^T
+  for (serial_size_t i = 0; i < rows; i++) {
+    for (serial_size_t j = 0; j < rows; j++) {
+      combine(coef + j * n, n, tmp + i * n * lanes, lanes, lanes,
+              dst + (i * rows + j) * dst_stride);
+    }
+  }
+}
+
+}  // namespace winograd_detail
+
+/**
+ * output tile size used for params (2 or 4), or 0 if the Winograd kernel
+ * can't run it (kernel other than 3x3, strides other than 1 or groups). small
+ * outputs use F(2x2, 3x3), whose tiles waste less of the border.
+ **/
+inline serial_size_t conv2d_winograd_tile(const core::conv_params &params) {
+  if (params.weight.width_ != 3 || params.weight.height_ != 3 ||
+      params.w_stride != 1 || params.h_stride != 1 || params.groups != 1) {
+    return 0;
+  }
+  return std::min(params.out.width_, params.out.height_) >= 8 ? 4 : 2;
+}
+
+/**
+ * whether the Winograd kernel with m x m output tiles is expected to beat
+ * im2col + gemm on batch samples. with few channels the transforms cost
+ * about as much as the multiplications they save, and with few tiles the
+ * multiplications get too small to run efficiently.
+ **/
+inline bool conv2d_winograd_pays_off(const core::conv_params &params,
+                                     size_t batch,
+                                     serial_size_t m) {
+  if (m == 0) return false;
+  const size_t tiles = static_cast<size_t>((params.out.width_ + m - 1) / m) *
+                       ((params.out.height_ + m - 1) / m) * batch;
+  return params.in.depth_ >= 24 && params.out.depth_ >= 16 && tiles >= 64;
+}
+
+/**
+ * transform the filters W for the Winograd kernel with m x m output tiles.
+ * U holds a * a matrices of out channels x in channels; the filters of
+ * disconnected (out, in) pairs are zero.
+ **/
+inline void conv2d_winograd_transform_filter(const core::conv_params &params,
+                                             const vec_t &W,
+                                             serial_size_t m,
+                                             vec_t &U) {
+  const winograd_detail::transforms t = winograd_detail::get_transforms(m);
+  const serial_size_t a               = t.a;
+  const serial_size_t id              = params.in.depth_;
+  const serial_size_t od              = params.out.depth_;
+  const size_t plane                  = size_t(od) * id;
+
+  U.assign(a * a * plane, float_t(0));
+  for (serial_size_t o = 0; o < od; o++) {
+    for (serial_size_t inc = 0; inc < id; inc++) {
+      if (!params.tbl.is_connected(o, inc)) continue;
+      const float_t *g = &W[params.weight.get_index(0, 0, id * o + inc)];
+
+      // tmp = G g (a x 3), u = tmp G^T (a x a)
+      float_t tmp[6 * 3];
+      for (serial_size_t i = 0; i < a; i++) {
+        for (serial_size_t j = 0; j < 3; j++) {
+          tmp[i * 3 + j] = t.g[i * 3] * g[j] + t.g[i * 3 + 1] * g[3 + j] +
+                           t.g[i * 3 + 2] * g[6 + j];
+        }
+      }
+      for (serial_size_t i = 0; i < a; i++) {
+        for (serial_size_t j = 0; j < a; j++) {
+          const float_t u = tmp[i * 3] * t.g[j * 3] +
+                            tmp[i * 3 + 1] * t.g[j * 3 + 1] +
+                            tmp[i * 3 + 2] * t.g[j * 3 + 2];
+          U[(i * a + j) * plane + size_t(o) * id + inc] = u;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Winograd convolution with filters transformed by
+ * conv2d_winograd_transform_filter(params, W, m, U).
+ *
+ * the tiles of all samples are numbered together and processed in blocks
+ * which are split between the threads. a block is small enough for its
+ * transformed inputs and products to stay in cache, and large enough to
+ * keep the multiplications efficient even for small images.
+ **/
+inline void conv2d_op_winograd(const tensor_t &in_data,
+                               const vec_t &U,
+                               serial_size_t m,
+                               const vec_t &bias,
+                               tensor_t &out_data,
+                               const core::conv_params &params,
+                               const bool parallelize) {
+  using namespace winograd_detail;
+  const transforms t     = get_transforms(m);
+  const serial_size_t a  = t.a;
+  const size_t aa        = size_t(a) * a;
+  const serial_size_t id = params.in.depth_;
+  const serial_size_t od = params.out.depth_;
+  const serial_size_t iw = params.in_padded.width_;
+  const serial_size_t ih = params.in_padded.height_;
+  const serial_size_t ow = params.out.width_;
+  const serial_size_t oh = params.out.height_;
+  const size_t tiles_w   = (ow + m - 1) / m;
+  const size_t tiles     = tiles_w * ((oh + m - 1) / m);
+  const size_t total     = tiles * in_data.size();
+
+  // tiles per block: V (a * a * id) and M (a * a * od) of a block take
+  // about 2MB, in whole micro-kernel widths
+  const size_t budget = (size_t(1) << 19) / (aa * (id + od));
+  const size_t block =
+    std::min(total, std::max<size_t>(16, budget / 16 * 16));
+  const size_t blocks = (total + block - 1) / block;
+
+  // with fewer blocks than threads, the channels and the points of each
+  // block are split between the threads instead
+  const bool split = parallelize && blocks < num_threads();
+
+  for_i(parallelize && !split, blocks, [&](size_t b) {
+    const size_t t0    = b * block;
+    const size_t lanes = std::min(block, total - t0);
+
+    vec_t buf(aa * (id + od) * lanes);
+    float_t *V = &buf[0];              // aa x id x lanes
+    float_t *M = V + aa * id * lanes;  // aa x od x lanes
+
+    // V = B^T d B for every input channel
+    for_i(split, id, [&](size_t c) {
+      vec_t scratch(2 * aa * lanes);
+      float_t *d = &scratch[0];  // aa x lanes
+      for (size_t l = 0; l < lanes; l++) {
+        const size_t tile  = (t0 + l) % tiles;
+        const size_t x0    = (tile % tiles_w) * m;
+        const size_t y0    = (tile / tiles_w) * m;
+        const float_t *pin = &in_data[(t0 + l) / tiles][0] +
+                             params.in_padded.get_index(0, 0, c);
+        if (x0 + a <= iw && y0 + a <= ih) {
+          for (serial_size_t i = 0; i < a; i++) {
+            const float_t *row = pin + (y0 + i) * iw + x0;
+            for (serial_size_t j = 0; j < a; j++) {
+              d[(i * a + j) * lanes + l] = row[j];
+            }
+          }
+        } else {
+          // the last row or column of tiles reaches past the input
+          for (serial_size_t i = 0; i < a; i++) {
+            for (serial_size_t j = 0; j < a; j++) {
+              const size_t x = x0 + j, y = y0 + i;
+              d[(i * a + j) * lanes + l] =
+                (x < iw && y < ih) ? pin[y * iw + x] : float_t(0);
+            }
+          }
+        }
+      }
+      transform_2d(t.bt, a, a, d, lanes, lanes, d + aa * lanes,
+                   V + c * lanes, id * lanes);
+    }, 1);
+
+    // M = U V at each point
+    for_i(split, aa, [&](size_t p) {
+      gemm(false, false, od, lanes, id, &U[p * od * id], id,
+           V + p * id * lanes, lanes, M + p * od * lanes, lanes, false);
+    }, 1);
+
+    // Y = A^T M A for every output channel
+    for_i(split, od, [&](size_t o) {
+      vec_t scratch((m + a) * m * lanes);
+      float_t *y = &scratch[0];  // m x m x lanes
+      transform_2d(t.at, m, a, M + o * lanes, od * lanes, lanes,
+                   y + m * m * lanes, y, lanes);
+      const float_t b0 = params.has_bias ? bias[o] : float_t(0);
+      for (size_t l = 0; l < lanes; l++) {
+        const size_t tile = (t0 + l) % tiles;
+        const size_t x0   = (tile % tiles_w) * m;
+        const size_t y0   = (tile / tiles_w) * m;
+        float_t *pout     = &out_data[(t0 + l) / tiles][0] +
+                        params.out.get_index(0, 0, o);
+        for (serial_size_t i = 0; i < m && y0 + i < oh; i++) {
+          for (serial_size_t j = 0; j < m && x0 + j < ow; j++) {
+            pout[(y0 + i) * ow + x0 + j] = y[(i * m + j) * lanes + l] + b0;
+          }
+        }
+      }
+    }, 1);
+  }, 1);
+
+  if (params.epilogue) {
+    for_i(parallelize, out_data.size(),
+          [&](size_t sample) { params.epilogue(out_data[sample]); });
+  }
+}
+
+inline void conv2d_op_winograd(const tensor_t &in_data,
+                               const vec_t &W,
+                               const vec_t &bias,
+                               tensor_t &out_data,
+                               const core::conv_params &params,
+                               const bool parallelize) {
+  const serial_size_t m = conv2d_winograd_tile(params);
+  if (m == 0) throw nn_error("Winograd convolution needs 3x3, stride 1");
+  vec_t U;
+  conv2d_winograd_transform_filter(params, W, m, U);
+  conv2d_op_winograd(in_data, U, m, bias, out_data, params, parallelize);
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
@@ -7,34 +7,53 @@
 */
 #pragma once
 
+#include "tiny_dnn/core/kernels/gemm.h"
 #include "tiny_dnn/core/params/fully_params.h"
 
 namespace tiny_dnn {
 namespace kernels {
 
+// the batch is processed as one matrix multiplication when all samples are
+// stored contiguously (see is_contiguous_batch), one sample at a time
+// otherwise.
+inline bool fully_connected_is_batched(const tensor_t &a, const tensor_t &b) {
+  return is_contiguous_batch(a) && is_contiguous_batch(b);
+}
+
 inline void fully_connected_op_internal(const tensor_t &in_data,
                                         const vec_t &W,
                                         const vec_t &bias,
                                         tensor_t &out_data,
                                         const fully_params &params,
                                         const bool layer_parallelize) {
-  for_i(layer_parallelize, in_data.size(), [&](int sample) {
-    const vec_t &in = in_data[sample];
-    vec_t &out      = out_data[sample];
+  const size_t in_size  = params.in_size_;
+  const size_t out_size = params.out_size_;
 
-    for (serial_size_t i = 0; i < params.out_size_; i++) {
-      out[i] = float_t{0};
-      for (serial_size_t c = 0; c < params.in_size_; c++) {
-        out[i] += W[c * params.out_size_ + i] * in[c];
-      }
+  // out (samples x out_size) = in (samples x in_size) * W (in_size x out_size)
+  if (fully_connected_is_batched(in_data, out_data)) {
+    parallel_gemm(layer_parallelize, false, false, in_data.size(), out_size,
+                  in_size, &in_data[0][0], batch_stride(in_size), &W[0],
+                  out_size, &out_data[0][0], batch_stride(out_size), false);
+  } else {
+    for (size_t sample = 0; sample < in_data.size(); sample++) {
+      parallel_gemm(layer_parallelize, false, false, 1, out_size, in_size,
+                    &in_data[sample][0], in_size, &W[0], out_size,
+                    &out_data[sample][0], out_size, false);
+    }
+  }
 
+  if (params.has_bias_ || params.epilogue) {
+    for (size_t sample = 0; sample < out_data.size(); sample++) {
       if (params.has_bias_) {
-        out[i] += bias[i];
+        vectorize::add(&bias[0], out_size, &out_data[sample][0]);
       }
+      if (params.epilogue) params.epilogue(out_data[sample]);
     }
-  });
+  }
 }
 
+// the weight gradient is reduced over the batch into dW[0] and db[0]
+// (see fully_connected_layer::weight_grad_sample_count).
 inline void fully_connected_op_internal(const tensor_t &prev_out,
                                         const vec_t &W,
                                         tensor_t &dW,
@@ -43,31 +62,41 @@ inline void fully_connected_op_internal(const tensor_t &prev_out,
                                         tensor_t &prev_delta,
                                         const fully_params &params,
                                         const bool layer_parallelize) {
-  for (serial_size_t sample = 0; sample < prev_out.size(); sample++) {
-    for (serial_size_t c = 0; c < params.in_size_; c++) {
-      // propagate delta to previous layer
-      // prev_delta[c] += current_delta[r] * W_[c * out_size_ + r]
-      prev_delta[sample][c] += vectorize::dot(
-        &curr_delta[sample][0], &W[c * params.out_size_], params.out_size_);
-    }
+  const size_t in_size  = params.in_size_;
+  const size_t out_size = params.out_size_;
+  float_t *dw           = &dW[0][0];
 
-    for_(layer_parallelize, 0, size_t(params.out_size_),
-         [&](const blocked_range &r) {
-           // accumulate weight-step using delta
-           // dW[c * out_size + i] += current_delta[i] * prev_out[c]
-           for (serial_size_t c = 0; c < params.in_size_; c++) {
-             vectorize::muladd(&curr_delta[sample][r.begin()],
-                               prev_out[sample][c], r.end() - r.begin(),
-                               &dW[sample][c * params.out_size_ + r.begin()]);
-           }
+  if (fully_connected_is_batched(prev_out, curr_delta) &&
+      is_contiguous_batch(prev_delta)) {
+    const size_t n             = prev_out.size();
+    const float_t *prev_out0   = &prev_out[0][0];
+    const float_t *curr_delta0 = &curr_delta[0][0];
 
-           if (params.has_bias_) {
-             // vec_t& db = *in_grad[2];
-             for (size_t i = r.begin(); i < r.end(); i++) {
-               db[sample][i] += curr_delta[sample][i];
-             }
-           }
-         });
+    // prev_delta += curr_delta * W^T
+    parallel_gemm(layer_parallelize, false, true, n, in_size, out_size,
+                  curr_delta0, batch_stride(out_size), &W[0], out_size,
+                  &prev_delta[0][0], batch_stride(in_size), true);
+
+    // dW += prev_out^T * curr_delta
+    parallel_gemm(layer_parallelize, true, false, in_size, out_size, n,
+                  prev_out0, batch_stride(in_size), curr_delta0,
+                  batch_stride(out_size), dw, out_size, true);
+  } else {
+    for (size_t sample = 0; sample < prev_out.size(); sample++) {
+      parallel_gemm(layer_parallelize, false, true, 1, in_size, out_size,
+                    &curr_delta[sample][0], out_size, &W[0], out_size,
+                    &prev_delta[sample][0], in_size, true);
+
+      parallel_gemm(layer_parallelize, true, false, in_size, out_size, 1,
+                    &prev_out[sample][0], in_size, &curr_delta[sample][0],
+                    out_size, dw, out_size, true);
+    }
+  }
+
+  if (params.has_bias_) {
+    for (size_t sample = 0; sample < curr_delta.size(); sample++) {
+      vectorize::reduce<float_t>(&curr_delta[sample][0], out_size, &db[0][0]);
+    }
   }
 }
 
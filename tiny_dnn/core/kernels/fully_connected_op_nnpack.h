@@ -46,6 +46,7 @@ inline void fully_connected_op_nnpack(const tensor_t &in_data,
     for_i(layer_parallelize, params.out_size_,
           [&](int i) { output_ptr[i] += bias[i]; });
   }
+  if (params.epilogue) params.epilogue(out_data[0]);
 #else
   CNN_UNREFERENCED_PARAMETER(in_data);
   CNN_UNREFERENCED_PARAMETER(W);
@@ -0,0 +1,333 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+
+#ifdef CNN_USE_AVX
+#include "tiny_dnn/core/kernels/avx_kernel_common.h"
+#endif
+
+namespace tiny_dnn {
+namespace kernels {
+
+namespace gemm_detail {
+
+#if defined(CNN_USE_AVX) && !defined(CNN_USE_DOUBLE)
+static const size_t gemm_mr = 6;
+static const size_t gemm_nr = 16;
+#else
+static const size_t gemm_mr = 4;
+static const size_t gemm_nr = 8;
+#endif
+static const size_t gemm_mc = 72;
+static const size_t gemm_kc = 256;
+static const size_t gemm_nc = 1024;
+
+// uninitialized aligned scratch memory
+class gemm_buffer {
+ public:
+  explicit gemm_buffer(size_t size)
+    : block_(vec_t::allocator_type::make_block(size)) {}
+  float_t *get() { return block_.get(); }
+
+ private:
+  std::shared_ptr<float_t> block_;
+};
+
+// copy rows [i0, i0 + mc) x cols [k0, k0 + kc) of op(A) into panels of
+// gemm_mr rows, stored column by column. missing rows are zero.
+inline void pack_a(bool trans,
+                   const float_t *A,
+                   size_t lda,
+                   size_t i0,
+                   size_t k0,
+                   size_t mc,
+                   size_t kc,
+                   float_t *dst) {
+  for (size_t i = 0; i < mc; i += gemm_mr) {
+    const size_t mr = std::min(gemm_mr, mc - i);
+    if (trans) {
+      for (size_t k = 0; k < kc; k++) {
+        const float_t *src = A + (k0 + k) * lda + i0 + i;
+        size_t r           = 0;
+        for (; r < mr; r++) dst[r] = src[r];
+        for (; r < gemm_mr; r++) dst[r] = float_t(0);
+        dst += gemm_mr;
+      }
+    } else {
+      for (size_t k = 0; k < kc; k++) {
+        const float_t *src = A + (i0 + i) * lda + k0 + k;
+        size_t r           = 0;
+        for (; r < mr; r++) dst[r] = src[r * lda];
+        for (; r < gemm_mr; r++) dst[r] = float_t(0);
+        dst += gemm_mr;
+      }
+    }
+  }
+}
+
+// copy rows [k0, k0 + kc) x cols [j0, j0 + nc) of op(B) into panels of
+// gemm_nr columns, stored row by row. missing columns are zero.
+inline void pack_b(bool trans,
+                   const float_t *B,
+                   size_t ldb,
+                   size_t k0,
+                   size_t j0,
+                   size_t kc,
+                   size_t nc,
+                   float_t *dst) {
+  for (size_t j = 0; j < nc; j += gemm_nr) {
+    const size_t nr = std::min(gemm_nr, nc - j);
+    if (trans) {
+      for (size_t k = 0; k < kc; k++) {
+        const float_t *src = B + (j0 + j) * ldb + k0 + k;
+        size_t c           = 0;
+        for (; c < nr; c++) dst[c] = src[c * ldb];
+        for (; c < gemm_nr; c++) dst[c] = float_t(0);
+        dst += gemm_nr;
+      }
+    } else {
+      for (size_t k = 0; k < kc; k++) {
+        const float_t *src = B + (k0 + k) * ldb + j0 + j;
+        size_t c           = 0;
+        for (; c < nr; c++) dst[c] = src[c];
+        for (; c < gemm_nr; c++) dst[c] = float_t(0);
+        dst += gemm_nr;
+      }
+    }
+  }
+}
+
+// write the mr x nr top-left part of a gemm_mr x gemm_nr tile to C
+inline void store_tile(const float_t *tile,
+                       float_t *C,
+                       size_t ldc,
+                       size_t mr,
+                       size_t nr,
+                       bool accumulate) {
+  for (size_t r = 0; r < mr; r++) {
+    const float_t *src = tile + r * gemm_nr;
+    float_t *dst       = C + r * ldc;
+    if (accumulate) {
+      for (size_t c = 0; c < nr; c++) dst[c] += src[c];
+    } else {
+      for (size_t c = 0; c < nr; c++) dst[c] = src[c];
+    }
+  }
+}
+
+#if defined(CNN_USE_AVX) && !defined(CNN_USE_DOUBLE)
+
+inline void micro_kernel(size_t kc,
+                         const float *pa,
+                         const float *pb,
+                         float *C,
+                         size_t ldc,
+                         size_t mr,
+                         size_t nr,
+                         bool accumulate) {
+  __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+  __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+  __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+  __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+  __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+  for (size_t k = 0; k < kc; k++) {
+    const __m256 b0 = _mm256_load_ps(pb);
+    const __m256 b1 = _mm256_load_ps(pb + 8);
+    __m256 a;
+    a   = _mm256_broadcast_ss(pa + 0);
+    c00 = madd256_ps(a, b0, c00);
+    c01 = madd256_ps(a, b1, c01);
+    a   = _mm256_broadcast_ss(pa + 1);
+    c10 = madd256_ps(a, b0, c10);
+    c11 = madd256_ps(a, b1, c11);
+    a   = _mm256_broadcast_ss(pa + 2);
+    c20 = madd256_ps(a, b0, c20);
+    c21 = madd256_ps(a, b1, c21);
+    a   = _mm256_broadcast_ss(pa + 3);
+    c30 = madd256_ps(a, b0, c30);
+    c31 = madd256_ps(a, b1, c31);
+    a   = _mm256_broadcast_ss(pa + 4);
+    c40 = madd256_ps(a, b0, c40);
+    c41 = madd256_ps(a, b1, c41);
+    a   = _mm256_broadcast_ss(pa + 5);
+    c50 = madd256_ps(a, b0, c50);
+    c51 = madd256_ps(a, b1, c51);
+    pa += gemm_mr;
+    pb += gemm_nr;
+  }
+
+  const __m256 acc[gemm_mr][2] = {{c00, c01}, {c10, c11}, {c20, c21},
+                                  {c30, c31}, {c40, c41}, {c50, c51}};
+
+  if (mr == gemm_mr && nr == gemm_nr) {
+    for (size_t r = 0; r < gemm_mr; r++) {
+      float *dst = C + r * ldc;
+      __m256 v0  = acc[r][0];
+      __m256 v1  = acc[r][1];
+      if (accumulate) {
+        v0 = _mm256_add_ps(v0, _mm256_loadu_ps(dst));
+        v1 = _mm256_add_ps(v1, _mm256_loadu_ps(dst + 8));
+      }
+      _mm256_storeu_ps(dst, v0);
+      _mm256_storeu_ps(dst + 8, v1);
+    }
+  } else {
+    alignas(32) float tile[gemm_mr * gemm_nr];
+    for (size_t r = 0; r < gemm_mr; r++) {
+      _mm256_store_ps(tile + r * gemm_nr, acc[r][0]);
+      _mm256_store_ps(tile + r * gemm_nr + 8, acc[r][1]);
+    }
+    store_tile(tile, C, ldc, mr, nr, accumulate);
+  }
+}
+
+#else  // CNN_USE_AVX && !CNN_USE_DOUBLE
+
+inline void micro_kernel(size_t kc,
+                         const float_t *pa,
+                         const float_t *pb,
+                         float_t *C,
+                         size_t ldc,
+                         size_t mr,
+                         size_t nr,
+                         bool accumulate) {
+  float_t tile[gemm_mr * gemm_nr] = {};
+
+  for (size_t k = 0; k < kc; k++) {
+    for (size_t r = 0; r < gemm_mr; r++) {
+      const float_t a = pa[r];
+      float_t *t      = tile + r * gemm_nr;
+      for (size_t c = 0; c < gemm_nr; c++) t[c] += a * pb[c];
+    }
+    pa += gemm_mr;
+    pb += gemm_nr;
+  }
+  store_tile(tile, C, ldc, mr, nr, accumulate);
+}
+
+#endif  // CNN_USE_AVX && !CNN_USE_DOUBLE
+
+}  // namespace gemm_detail
+
+/**
+ * blocked matrix multiplication.
+ *
+ * C (M x N) = op(A) (M x K) * op(B) (K x N), or C += ... when accumulate is
+ * set. matrices are row-major; op(X) is X or X^T depending on trans_*.
+ *
+ * panels of op(A) and op(B) are packed into contiguous buffers sized to stay
+ * in cache (gemm_mc x gemm_kc and gemm_kc x gemm_nc), and each
+ * gemm_mr x gemm_nr block of C is computed in registers by a micro-kernel.
+ **/
+inline void gemm(bool trans_a,
+                 bool trans_b,
+                 size_t M,
+                 size_t N,
+                 size_t K,
+                 const float_t *A,
+                 size_t lda,
+                 const float_t *B,
+                 size_t ldb,
+                 float_t *C,
+                 size_t ldc,
+                 bool accumulate) {
+  using namespace gemm_detail;
+
+  if (M == 0 || N == 0) return;
+  if (K == 0) {
+    if (!accumulate) {
+      for (size_t i = 0; i < M; i++) {
+        std::fill(C + i * ldc, C + i * ldc + N, float_t(0));
+      }
+    }
+    return;
+  }
+
+  const size_t m_max = std::min(gemm_mc, (M + gemm_mr - 1) / gemm_mr * gemm_mr);
+  const size_t n_max = std::min(gemm_nc, (N + gemm_nr - 1) / gemm_nr * gemm_nr);
+  const size_t k_max = std::min(gemm_kc, K);
+
+  gemm_buffer packed_a(m_max * k_max);
+  gemm_buffer packed_b(n_max * k_max);
+
+  for (size_t jc = 0; jc < N; jc += gemm_nc) {
+    const size_t nc = std::min(gemm_nc, N - jc);
+
+    for (size_t pc = 0; pc < K; pc += gemm_kc) {
+      const size_t kc = std::min(gemm_kc, K - pc);
+      // only the first slice of K may overwrite C
+      const bool acc = accumulate || pc > 0;
+
+      pack_b(trans_b, B, ldb, pc, jc, kc, nc, packed_b.get());
+
+      for (size_t ic = 0; ic < M; ic += gemm_mc) {
+        const size_t mc = std::min(gemm_mc, M - ic);
+
+        pack_a(trans_a, A, lda, ic, pc, mc, kc, packed_a.get());
+
+        for (size_t jr = 0; jr < nc; jr += gemm_nr) {
+          const float_t *pb = packed_b.get() + jr * kc;
+          for (size_t ir = 0; ir < mc; ir += gemm_mr) {
+            micro_kernel(kc, packed_a.get() + ir * kc, pb,
+                         C + (ic + ir) * ldc + jc + jr, ldc,
+                         std::min(gemm_mr, mc - ir), std::min(gemm_nr, nc - jr),
+                         acc);
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * gemm() with the columns of C distributed over the worker threads.
+ * every task gets a slice of gemm_task_cols columns, so that the cost of
+ * packing op(A) again in each task stays small, unless that leaves threads
+ * idle: narrow matrices (e.g. a fully connected layer with a single sample)
+ * are cut into slices as small as gemm_nr columns.
+ **/
+inline void parallel_gemm(bool parallelize,
+                          bool trans_a,
+                          bool trans_b,
+                          size_t M,
+                          size_t N,
+                          size_t K,
+                          const float_t *A,
+                          size_t lda,
+                          const float_t *B,
+                          size_t ldb,
+                          float_t *C,
+                          size_t ldc,
+                          bool accumulate) {
+  const size_t nr             = gemm_detail::gemm_nr;
+  const size_t threads        = num_threads();
+  const size_t per_thread     = (N + nr * threads - 1) / (nr * threads) * nr;
+  const size_t gemm_task_cols = std::max(nr, std::min(8 * nr, per_thread));
+  const size_t tasks          = (N + gemm_task_cols - 1) / gemm_task_cols;
+
+  if (!parallelize || tasks < 2) {
+    gemm(trans_a, trans_b, M, N, K, A, lda, B, ldb, C, ldc, accumulate);
+    return;
+  }
+
+  for_i(true, tasks,
+        [&](size_t t) {
+          const size_t j0 = t * gemm_task_cols;
+          const size_t nc = std::min(gemm_task_cols, N - j0);
+          gemm(trans_a, trans_b, M, nc, K, A, lda,
+               trans_b ? B + j0 * ldb : B + j0, ldb, C + j0, ldc, accumulate);
+        },
+        1);
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
@@ -9,6 +9,7 @@
 
 #include "tiny_dnn/core/framework/op_kernel.h"
 #include "tiny_dnn/core/kernels/global_avepool_op_avx.h"
+#include "tiny_dnn/core/kernels/global_avepool_op_blocked.h"
 #include "tiny_dnn/core/kernels/global_avepool_op_internal.h"
 
 namespace tiny_dnn {
@@ -30,7 +31,10 @@ class GlobalAvePoolOp : public core::OpKernel {
 
     const core::backend_t engine = context.engine();
 
-    if (engine == core::backend_t::avx) {
+    if (params.channel_block != 1) {
+      kernels::global_avepool_op_blocked(in_data, out_data, params,
+                                         context.parallelize());
+    } else if (engine == core::backend_t::avx) {
 #ifdef CNN_USE_AVX
       kernels::global_avepool_op_avx(in_data, out_data, params,
                                      context.parallelize());
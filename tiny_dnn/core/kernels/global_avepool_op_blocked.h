@@ -0,0 +1,72 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include "tiny_dnn/core/params/global_avepool_params.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+// out[c, c + T::unroll_size) = mean of the channels [c, c + T::unroll_size)
+// of a block of width bw over area pixels. in points to channel c of the
+// block.
+template <typename T>
+void global_avepool_blocked_channels(const float_t *in,
+                                     serial_size_t bw,
+                                     serial_size_t area,
+                                     float_t *out) {
+  typedef typename T::register_type reg;
+  reg sum0 = T::zero(), sum1 = T::zero();
+  serial_size_t p = 0;
+  // two sums, to hide the latency of the additions
+  for (; p + 2 <= area; p += 2) {
+    sum0 = T::add(sum0, T::template load<std::false_type>(in + p * bw));
+    sum1 = T::add(sum1, T::template load<std::false_type>(in + (p + 1) * bw));
+  }
+  if (p < area) {
+    sum0 = T::add(sum0, T::template load<std::false_type>(in + p * bw));
+  }
+  T::template store<std::false_type>(
+    out, T::mul(T::add(sum0, sum1), T::set1(float_t(1) / area)));
+}
+
+/**
+ * global average pooling of channel-blocked activations (block
+ * params.channel_block), vectorized over the channels of each pixel
+ **/
+inline void global_avepool_op_blocked(
+  const tensor_t &in_data,
+  tensor_t &out_data,
+  const core::global_avepool_params &params,
+  const bool layer_parallelize) {
+  typedef vectorize::CNN_VECTORIZE_TYPE V;
+  typedef vectorize::detail::scalar_generic<float_t> S;
+  const serial_size_t block = params.channel_block;
+  const serial_size_t area  = params.in.area();
+
+  for_i(layer_parallelize, in_data.size(), [&](size_t sample) {
+    const vec_t &in = in_data[sample];
+    vec_t &out      = out_data[sample];
+    for (serial_size_t first = 0; first < params.in.depth_; first += block) {
+      const serial_size_t bw = block_width(params.in, block, first);
+      const float_t *pin     = &in[first * area];
+      serial_size_t c        = 0;
+      for (; c + V::unroll_size <= bw; c += V::unroll_size) {
+        global_avepool_blocked_channels<V>(pin + c, bw, area,
+                                           &out[first + c]);
+      }
+      for (; c < bw; c++) {
+        global_avepool_blocked_channels<S>(pin + c, bw, area,
+                                           &out[first + c]);
+      }
+    }
+  });
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
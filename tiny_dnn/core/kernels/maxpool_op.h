@@ -10,6 +10,7 @@
 #include "tiny_dnn/core/framework/op_kernel.h"
 
 #include "tiny_dnn/core/kernels/maxpool_op_avx.h"
+#include "tiny_dnn/core/kernels/maxpool_op_blocked.h"
 #include "tiny_dnn/core/kernels/maxpool_op_internal.h"
 #include "tiny_dnn/core/kernels/maxpool_op_nnpack.h"
 
@@ -35,7 +36,10 @@ class MaxPoolOp : public core::OpKernel {
 
     const core::backend_t engine = context.engine();
 
-    if (engine == core::backend_t::internal) {
+    if (params.channel_block != 1) {
+      kernels::maxpool_op_blocked(in_data, out_data, params,
+                                  context.parallelize());
+    } else if (engine == core::backend_t::internal) {
       kernels::maxpool_op_internal(in_data, out_data, params.out2inmax,
                                    params.out2in, context.parallelize());
     } else if (engine == core::backend_t::nnpack) {
@@ -53,8 +57,8 @@ class MaxPoolOp : public core::OpKernel {
       */
       kernels::maxpool_op_nnpack(in_data, out_data, params);
     } else if (engine == core::backend_t::avx) {
-      kernels::maxpool_op_avx(in_data, out_data, params.out2inmax,
-                              params.out2in, context.parallelize());
+      kernels::maxpool_op_avx(in_data, out_data, params.out2inmax, params,
+                              context.parallelize());
     } else {
       throw nn_error("Not supported engine: " + to_string(engine));
     }
@@ -8,28 +8,229 @@
 #pragma once
 
 #include "tiny_dnn/core/kernels/maxpool_op_internal.h"
+#include "tiny_dnn/core/params/maxpool_params.h"
 
 namespace tiny_dnn {
 namespace kernels {
 
-inline void maxpool_op_avx(
-  const tensor_t &in_data,
-  tensor_t &out_data,
+#if defined(CNN_USE_AVX) && !defined(CNN_USE_DOUBLE)
+
+// load p[0], p[stride], ..., p[7 * stride] (stride is 1 or 2)
+template <int stride>
+inline __m256 maxpool_load8_ps(const float *p) {
+  if (stride == 1) return _mm256_loadu_ps(p);
+
+  const __m256 a  = _mm256_loadu_ps(p);
+  const __m256 b  = _mm256_loadu_ps(p + 8);
+  const __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+  const __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+  return _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// max-pool count (multiple of 8) outputs of a row whose windows are entirely
+// inside the input. in points to the top-left element of the first window,
+// which is at index first_index in the sample.
+template <int stride>
+inline void maxpool_row_avx(const float *in,
+                            float *out,
+                            serial_size_t *max,
+                            serial_size_t first_index,
+                            serial_size_t count,
+                            serial_size_t in_w,
+                            serial_size_t px,
+                            serial_size_t py,
+                            const float *offset) {
+  const __m256 lowest = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+
+  const __m128i lane_lo = _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+  const __m128i lane_hi = _mm_add_epi32(lane_lo, _mm_set1_epi32(4 * stride));
+
+  for (serial_size_t ox = 0; ox < count; ox += 8) {
+    const float *pin = in + ox * stride;
+    __m256 best      = lowest;
+    __m256 best_k    = _mm256_setzero_ps();
+
+    // keep the offset (dy * in_w + dx) of the maximum inside the window;
+    // the first one wins on ties, as in the internal kernel
+    for (serial_size_t dy = 0; dy < py; dy++) {
+      for (serial_size_t dx = 0; dx < px; dx++) {
+        const __m256 v   = maxpool_load8_ps<stride>(pin + dy * in_w + dx);
+        const __m256 gt  = _mm256_cmp_ps(v, best, _CMP_GT_OQ);
+        const __m256 off = _mm256_broadcast_ss(&offset[dy * px + dx]);
+        // max_ps(v, best) returns v only if v > best
+        best   = _mm256_max_ps(v, best);
+        best_k = _mm256_or_ps(_mm256_and_ps(gt, off),
+                              _mm256_andnot_ps(gt, best_k));
+      }
+    }
+    _mm256_storeu_ps(out + ox, best);
+
+    // index = first_index + (ox + lane) * stride + offset
+    const __m256i k = _mm256_cvttps_epi32(best_k);
+    const __m128i base =
+      _mm_set1_epi32(static_cast<int>(first_index + ox * stride));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(max + ox),
+                     _mm_add_epi32(_mm_add_epi32(base, lane_lo),
+                                   _mm256_castsi256_si128(k)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(max + ox + 4),
+                     _mm_add_epi32(_mm_add_epi32(base, lane_hi),
+                                   _mm256_extractf128_si256(k, 1)));
+  }
+}
+
+// scalar path for a single output, used near the borders where the window
+// is clipped. scan order and comparison are the same as maxpool_op_internal.
+inline void maxpool_window(const vec_t &in,
+                           vec_t &out,
+                           std::vector<serial_size_t> &max,
+                           const core::maxpool_params &params,
+                           serial_size_t c,
+                           serial_size_t ox,
+                           serial_size_t oy) {
+  const serial_size_t ix = ox * params.stride_x;
+  const serial_size_t iy = oy * params.stride_y;
+  const serial_size_t dxmax =
+    std::min(params.pool_size_x, params.in.width_ - ix);
+  const serial_size_t dymax =
+    std::min(params.pool_size_y, params.in.height_ - iy);
+
+  float_t max_value = std::numeric_limits<float_t>::lowest();
+  serial_size_t idx = 0;
+  for (serial_size_t dy = 0; dy < dymax; dy++) {
+    const serial_size_t row = params.in.get_index(ix, iy + dy, c);
+    for (serial_size_t dx = 0; dx < dxmax; dx++) {
+      if (in[row + dx] > max_value) {
+        max_value = in[row + dx];
+        idx       = row + dx;
+      }
+    }
+  }
+  const serial_size_t o = params.out.get_index(ox, oy, c);
+  max[o]                = idx;
+  out[o]                = max_value;
+}
+
+// float version
+inline void maxpool_op_avx(const tensor_t &in_data,
+                           tensor_t &out_data,
+                           std::vector<std::vector<serial_size_t>> &max_idx,
+                           const core::maxpool_params &params,
+                           const bool layer_parallelize) {
+  const serial_size_t in_w = params.in.width_;
+  const serial_size_t in_h = params.in.height_;
+  const serial_size_t sx   = params.stride_x;
+  const serial_size_t sy   = params.stride_y;
+  const serial_size_t px   = params.pool_size_x;
+  const serial_size_t py   = params.pool_size_y;
+
+  // output columns [0, vec_w) have their whole window inside the row, and
+  // 8 of them can be loaded without reading past the end of the row.
+  serial_size_t vec_w = 0;
+  if (sx == 1 || sx == 2) {
+    while (vec_w + 8 <= params.out.width_ &&
+           (vec_w + 7) * sx + px + sx - 2 < in_w) {
+      vec_w += 8;
+    }
+  }
+
+  // offset of each window element from the top-left corner of the window.
+  // they are small enough to be exact in float.
+  vec_t offset(px * py);
+  for (serial_size_t dy = 0; dy < py; dy++) {
+    for (serial_size_t dx = 0; dx < px; dx++) {
+      offset[dy * px + dx] = static_cast<float>(dy * in_w + dx);
+    }
+  }
+
+  // with a small batch, the channels of a sample are split instead
+  const bool split =
+    parallelize_within_samples(layer_parallelize, in_data.size());
+
+  for_i(layer_parallelize && !split, in_data.size(), [&](int sample) {
+    const vec_t &in                 = in_data[sample];
+    vec_t &out                      = out_data[sample];
+    std::vector<serial_size_t> &max = max_idx[sample];
+
+    for_i(split, params.in.depth_,
+          [&](serial_size_t c) {
+            for (serial_size_t oy = 0; oy < params.out.height_; oy++) {
+              const serial_size_t iy = oy * sy;
+              serial_size_t ox       = 0;
+
+              if (iy + py <= in_h && vec_w > 0) {
+                const serial_size_t row0 = params.in.get_index(0, iy, c);
+                const serial_size_t orow = params.out.get_index(0, oy, c);
+
+                if (sx == 1) {
+                  maxpool_row_avx<1>(&in[row0], &out[orow], &max[orow], row0,
+                                     vec_w, in_w, px, py, &offset[0]);
+                } else {
+                  maxpool_row_avx<2>(&in[row0], &out[orow], &max[orow], row0,
+                                     vec_w, in_w, px, py, &offset[0]);
+                }
+                ox = vec_w;
+              }
+
+              for (; ox < params.out.width_; ox++) {
+                maxpool_window(in, out, max, params, c, ox, oy);
+              }
+            }
+          },
+          1);
+  });
+}
+
+// float version
+inline void maxpool_grad_op_avx(
+  tensor_t &prev_delta,
+  const tensor_t &curr_delta,
   std::vector<std::vector<serial_size_t>> &max_idx,
-  const std::vector<std::vector<serial_size_t>> &out2in,
+  const core::maxpool_params &params,
   const bool layer_parallelize) {
-  maxpool_op_internal(in_data, out_data, max_idx, out2in, layer_parallelize);
+  // with overlapping windows an input may be the maximum of several outputs,
+  // let the internal kernel resolve it through in2out.
+  if (params.stride_x < params.pool_size_x ||
+      params.stride_y < params.pool_size_y) {
+    maxpool_grad_op_internal(prev_delta, curr_delta, max_idx, params.in2out,
+                             layer_parallelize);
+    return;
+  }
+
+  // every input belongs to at most one window: scatter the output deltas
+  // to the recorded maxima. prev_delta is expected to be zero-filled.
+  for_i(layer_parallelize, prev_delta.size(), [&](int sample) {
+    vec_t &prev                           = prev_delta[sample];
+    const vec_t &curr                     = curr_delta[sample];
+    const std::vector<serial_size_t> &max = max_idx[sample];
+
+    for (serial_size_t o = 0; o < curr.size(); o++) {
+      prev[max[o]] = curr[o];
+    }
+  });
+}
+
+#else  // CNN_USE_AVX && !CNN_USE_DOUBLE
+
+inline void maxpool_op_avx(const tensor_t &in_data,
+                           tensor_t &out_data,
+                           std::vector<std::vector<serial_size_t>> &max_idx,
+                           const core::maxpool_params &params,
+                           const bool layer_parallelize) {
+  maxpool_op_internal(in_data, out_data, max_idx, params.out2in,
+                      layer_parallelize);
 }
 
 inline void maxpool_grad_op_avx(
   tensor_t &prev_delta,
   const tensor_t &curr_delta,
   std::vector<std::vector<serial_size_t>> &max_idx,
-  const std::vector<serial_size_t> &in2out,
+  const core::maxpool_params &params,
   const bool layer_parallelize) {
-  maxpool_grad_op_internal(prev_delta, curr_delta, max_idx, in2out,
+  maxpool_grad_op_internal(prev_delta, curr_delta, max_idx, params.in2out,
                            layer_parallelize);
 }
 
+#endif  // CNN_USE_AVX && !CNN_USE_DOUBLE
+
 }  // namespace kernels
 }  // namespace tiny_dnn
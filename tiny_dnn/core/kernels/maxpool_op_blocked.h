@@ -0,0 +1,91 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+#include "tiny_dnn/core/params/maxpool_params.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+// output row oy of the channels [c, c + T::unroll_size) of a block of width
+// bw, where in and out point to channel c of the block. the windows are
+// clipped at the borders like in maxpool_op_internal.
+template <typename T>
+void maxpool_blocked_row(const core::maxpool_params &params,
+                         const float_t *in,
+                         serial_size_t bw,
+                         serial_size_t oy,
+                         float_t *out) {
+  typedef typename T::register_type reg;
+  const serial_size_t in_w = params.in.width_;
+  const serial_size_t iy   = oy * params.stride_y;
+  const serial_size_t dymax =
+    std::min(params.pool_size_y, params.in.height_ - iy);
+  const reg lowest = T::set1(std::numeric_limits<float_t>::lowest());
+
+  for (serial_size_t ox = 0; ox < params.out.width_; ox++) {
+    const serial_size_t ix    = ox * params.stride_x;
+    const serial_size_t dxmax = std::min(params.pool_size_x, in_w - ix);
+    reg best                  = lowest;
+    for (serial_size_t dy = 0; dy < dymax; dy++) {
+      const float_t *p = in + ((iy + dy) * in_w + ix) * bw;
+      for (serial_size_t dx = 0; dx < dxmax; dx++) {
+        best = T::max(T::template load<std::false_type>(p + dx * bw), best);
+      }
+    }
+    T::template store<std::false_type>(
+      out + (oy * params.out.width_ + ox) * bw, best);
+  }
+}
+
+/**
+ * max-pooling of channel-blocked activations (block params.channel_block),
+ * vectorized over the channels of each pixel. the positions of the maxima
+ * aren't recorded, it's for inference only.
+ **/
+inline void maxpool_op_blocked(const tensor_t &in_data,
+                               tensor_t &out_data,
+                               const core::maxpool_params &params,
+                               const bool layer_parallelize) {
+  typedef vectorize::CNN_VECTORIZE_TYPE V;
+  typedef vectorize::detail::scalar_generic<float_t> S;
+  const serial_size_t block  = params.channel_block;
+  const serial_size_t oh     = params.out.height_;
+  const serial_size_t blocks = (params.in.depth_ + block - 1) / block;
+
+  // with a small batch, the rows of the blocks are split instead
+  const bool split =
+    parallelize_within_samples(layer_parallelize, in_data.size());
+
+  for_i(layer_parallelize && !split, in_data.size(), [&](size_t sample) {
+    const vec_t &in = in_data[sample];
+    vec_t &out      = out_data[sample];
+    for_i(split, blocks * oh,
+          [&](size_t j) {
+            const serial_size_t first = j / oh * block;
+            const serial_size_t oy    = j % oh;
+            const serial_size_t bw    = block_width(params.in, block, first);
+            const float_t *pin        = &in[first * params.in.area()];
+            float_t *pout             = &out[first * params.out.area()];
+            serial_size_t c           = 0;
+            for (; c + V::unroll_size <= bw; c += V::unroll_size) {
+              maxpool_blocked_row<V>(params, pin + c, bw, oy, pout + c);
+            }
+            for (; c < bw; c++) {
+              maxpool_blocked_row<S>(params, pin + c, bw, oy, pout + c);
+            }
+          },
+          1);
+  });
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
@@ -16,24 +16,32 @@ inline void maxpool_op_internal(
   std::vector<std::vector<serial_size_t>> &max_idx,
   const std::vector<std::vector<serial_size_t>> &out2in,
   const bool layer_parallelize) {
-  for_i(layer_parallelize, in_data.size(), [&](int sample) {
+  // with a small batch, the outputs of a sample are split instead
+  const bool split =
+    parallelize_within_samples(layer_parallelize, in_data.size());
+
+  for_i(layer_parallelize && !split, in_data.size(), [&](int sample) {
     const vec_t &in                 = in_data[sample];
     vec_t &out                      = out_data[sample];
     std::vector<serial_size_t> &max = max_idx[sample];
 
-    for (serial_size_t i = 0; i < out2in.size(); i++) {
-      const auto &in_index = out2in[i];
-      float_t max_value    = std::numeric_limits<float_t>::lowest();
-      serial_size_t idx    = 0;
-      for (auto j : in_index) {
-        if (in[j] > max_value) {
-          max_value = in[j];
-          idx       = j;
-        }
-      }
-      max[i] = idx;
-      out[i] = max_value;
-    }
+    for_(split, 0, out2in.size(),
+         [&](const blocked_range &r) {
+           for (size_t i = r.begin(); i < r.end(); i++) {
+             const auto &in_index = out2in[i];
+             float_t max_value    = std::numeric_limits<float_t>::lowest();
+             serial_size_t idx    = 0;
+             for (auto j : in_index) {
+               if (in[j] > max_value) {
+                 max_value = in[j];
+                 idx       = j;
+               }
+             }
+             max[i] = idx;
+             out[i] = max_value;
+           }
+         },
+         split_grain(out2in.size(), 256));
   });
 }
 
@@ -249,6 +249,21 @@ void quantize_down_and_shrink_range(std::vector<T1> &input,
                                                  *max_new, &(*output)[0]);
 }
 
+/**
+ * filter and bias of a layer converted to 8bit, together with the ranges
+ * they were quantized with. weights don't change between forward calls,
+ * so this is computed once and shared by all samples.
+ **/
+struct quantized_weights {
+  std::vector<uint8_t> W;
+  std::vector<uint8_t> bias;
+  float_t min_filter    = float_t(0);
+  float_t max_filter    = float_t(0);
+  float_t min_bias      = float_t(0);
+  float_t max_bias      = float_t(0);
+  int32_t offset_filter = 0;
+};
+
 }  // namespace kernels
 }  // namespace core
 }  // namespace tiny_dnn
@@ -14,46 +14,31 @@ namespace tiny_dnn {
 namespace core {
 namespace kernels {
 
-inline void tiny_quantized_conv2d_kernel(const conv_params &params,
-                                         const vec_t &in,
-                                         const vec_t &W,
-                                         const vec_t &bias,
-                                         vec_t &a,
-                                         const bool layer_parallelize) {
-  // image quantization
-  float_t min_input(in[0]);
-  float_t max_input(in[0]);
-  for (serial_size_t inc = 0; inc < params.in.depth_; inc++) {
-    for (serial_size_t ins = 0;
-         ins < params.in_padded.height_ * params.in_padded.height_; ins++) {
-      serial_size_t idx = params.in_padded.get_index(0, 0, inc);
-      min_input         = std::min(min_input, (&in[idx])[ins]);
-      max_input         = std::max(max_input, (&in[idx])[ins]);
-    }
-  }
-  std::vector<uint8_t> in_quantized =
-    float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+inline void tiny_quantized_conv2d_quantize_weights(const conv_params &params,
+                                                   const vec_t &W,
+                                                   const vec_t &bias,
+                                                   quantized_weights *qw) {
   // filter quantization
   float_t min_filter(W[0]);
   float_t max_filter(W[0]);
-  for (serial_size_t inc = 0; inc < params.in_padded.depth_; inc++) {
-    for (serial_size_t ins = 0;
-         ins < params.weight.height_ * params.weight.height_; ins++) {
-      serial_size_t idx = params.in_padded.get_index(0, 0, inc);
-      min_filter        = std::min(min_filter, (&W[idx])[ins]);
-      max_filter        = std::max(max_filter, (&W[idx])[ins]);
-    }
+  for (serial_size_t i = 0; i < W.size(); i++) {
+    min_filter = std::min(min_filter, W[i]);
+    max_filter = std::max(max_filter, W[i]);
   }
   if (min_filter == max_filter) {
     max_filter = W[0] + 1e-3f;
     min_filter = W[0] - 1e-3f;
   }
-  std::vector<uint8_t> W_quantized =
-    float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
+  qw->W = float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
+
+  qw->min_filter    = min_filter;
+  qw->max_filter    = max_filter;
+  qw->offset_filter = int64_to_int32(
+    float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter));
   // bias quantization
   float_t min_bias(0);
   float_t max_bias(0);
-  std::vector<uint8_t> bias_quantized;
+  qw->bias.clear();
   if (params.has_bias) {
     for (serial_size_t inc = 0; inc < params.out.depth_; inc++) {
       min_bias = std::min(min_bias, bias[inc]);
@@ -63,14 +48,33 @@ inline void tiny_quantized_conv2d_kernel(const conv_params &params,
       max_bias = bias[0] + 1e-3f;
       min_bias = bias[0] - 1e-3f;
     }
-    bias_quantized =
-      float_tensor_to_quantized<uint8_t>(bias, min_bias, max_bias);
+    qw->bias = float_tensor_to_quantized<uint8_t>(bias, min_bias, max_bias);
   }
+  qw->min_bias = min_bias;
+  qw->max_bias = max_bias;
+}
+
+inline void tiny_quantized_conv2d_kernel(const conv_params &params,
+                                         const vec_t &in,
+                                         const quantized_weights &qw,
+                                         vec_t &a,
+                                         const bool layer_parallelize) {
+  // image quantization
+  float_t min_input(in[0]);
+  float_t max_input(in[0]);
+  for (serial_size_t i = 0; i < in.size(); i++) {
+    min_input = std::min(min_input, in[i]);
+    max_input = std::max(max_input, in[i]);
+  }
+  std::vector<uint8_t> in_quantized =
+    float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+  const std::vector<uint8_t> &W_quantized    = qw.W;
+  const std::vector<uint8_t> &bias_quantized = qw.bias;
   // output range
   float_t min_output_value;
   float_t max_output_value;
   quantization_range_for_multiplication<uint8_t, uint8_t, int32_t>(
-    min_input, max_input, min_filter, max_filter, &min_output_value,
+    min_input, max_input, qw.min_filter, qw.max_filter, &min_output_value,
     &max_output_value);
 
   std::vector<int32_t> a_quantized(a.size(), static_cast<int32_t>(0));
@@ -78,8 +82,7 @@ inline void tiny_quantized_conv2d_kernel(const conv_params &params,
   // calculating offset
   const int32_t offset_input = int64_to_int32(
     float_to_quantized_unclamped<uint8_t>(0.0f, min_input, max_input));
-  const int32_t offset_filter = int64_to_int32(
-    float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter));
+  const int32_t offset_filter = qw.offset_filter;
   const int32_t zero_in_total_space = int64_to_int32(
     float_to_quantized<int32_t>(0.0f, min_output_value, max_output_value));
 
@@ -144,6 +147,17 @@ inline void tiny_quantized_conv2d_kernel(const conv_params &params,
                                          max_output_requantized);
 }
 
+inline void tiny_quantized_conv2d_kernel(const conv_params &params,
+                                         const vec_t &in,
+                                         const vec_t &W,
+                                         const vec_t &bias,
+                                         vec_t &a,
+                                         const bool layer_parallelize) {
+  quantized_weights qw;
+  tiny_quantized_conv2d_quantize_weights(params, W, bias, &qw);
+  tiny_quantized_conv2d_kernel(params, in, qw, a, layer_parallelize);
+}
+
 inline void tiny_quantized_conv2d_back_kernel(const conv_params &params,
                                               const vec_t &prev_out,
                                               const vec_t &W,
@@ -154,13 +168,9 @@ inline void tiny_quantized_conv2d_back_kernel(const conv_params &params,
   // previous output quantization
   float_t min_prev_out(prev_out[0]);
   float_t max_prev_out(prev_out[0]);
-  for (serial_size_t inc = 0; inc < params.in.depth_; inc++) {
-    for (serial_size_t ins = 0;
-         ins < params.in_padded.height_ * params.in_padded.height_; ins++) {
-      serial_size_t idx = params.in_padded.get_index(0, 0, inc);
-      min_prev_out      = std::min(min_prev_out, (&prev_out[idx])[ins]);
-      max_prev_out      = std::max(min_prev_out, (&prev_out[idx])[ins]);
-    }
+  for (serial_size_t i = 0; i < prev_out.size(); i++) {
+    min_prev_out = std::min(min_prev_out, prev_out[i]);
+    max_prev_out = std::max(max_prev_out, prev_out[i]);
   }
   std::vector<uint8_t> prev_out_quantized =
     float_tensor_to_quantized<uint8_t>(prev_out, min_prev_out, max_prev_out);
@@ -168,13 +178,9 @@ inline void tiny_quantized_conv2d_back_kernel(const conv_params &params,
   // filter quantization
   float_t min_filter(W[0]);
   float_t max_filter(W[0]);
-  for (serial_size_t inc = 0; inc < params.in_padded.depth_; inc++) {
-    for (serial_size_t ins = 0;
-         ins < params.weight.height_ * params.weight.height_; ins++) {
-      serial_size_t idx = params.in_padded.get_index(0, 0, inc);
-      min_filter        = std::min(min_filter, (&W[idx])[ins]);
-      max_filter        = std::max(max_filter, (&W[idx])[ins]);
-    }
+  for (serial_size_t i = 0; i < W.size(); i++) {
+    min_filter = std::min(min_filter, W[i]);
+    max_filter = std::max(max_filter, W[i]);
   }
   if (min_filter == max_filter) {
     max_filter = W[0] + 1e-3f;
@@ -186,13 +192,9 @@ inline void tiny_quantized_conv2d_back_kernel(const conv_params &params,
   // current delta quantization
   float_t min_curr_delta(curr_delta[0]);
   float_t max_curr_delta(curr_delta[0]);
-  for (serial_size_t inc = 0; inc < params.out.depth_; inc++) {
-    for (serial_size_t ins = 0; ins < params.out.height_ * params.out.height_;
-         ins++) {
-      serial_size_t idx = params.out.get_index(0, 0, inc);
-      min_curr_delta    = std::min(min_curr_delta, (&curr_delta[idx])[ins]);
-      max_curr_delta    = std::max(max_curr_delta, (&curr_delta[idx])[ins]);
-    }
+  for (serial_size_t i = 0; i < curr_delta.size(); i++) {
+    min_curr_delta = std::min(min_curr_delta, curr_delta[i]);
+    max_curr_delta = std::max(max_curr_delta, curr_delta[i]);
   }
   std::vector<uint8_t> curr_delta_quantized =
     float_tensor_to_quantized<uint8_t>(curr_delta, min_curr_delta,
@@ -14,25 +14,11 @@ namespace tiny_dnn {
 namespace core {
 namespace kernels {
 
-inline void tiny_quantized_deconv2d_kernel(const deconv_params &params,
-                                           const vec_t &in,
-                                           const vec_t &W,
-                                           const vec_t &bias,
-                                           vec_t &out,
-                                           const bool layer_parallelize) {
-  // image quantization
-  float_t min_input(in[0]);
-  float_t max_input(in[0]);
-  for (serial_size_t inc = 0; inc < params.in.depth_; inc++) {
-    for (serial_size_t ins = 0; ins < params.in.height_ * params.in.height_;
-         ins++) {
-      serial_size_t idx = params.in.get_index(0, 0, inc);
-      min_input         = std::min(min_input, (&in[idx])[ins]);
-      max_input         = std::max(max_input, (&in[idx])[ins]);
-    }
-  }
-  std::vector<uint8_t> in_quantized =
-    float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+inline void tiny_quantized_deconv2d_quantize_weights(
+  const deconv_params &params,
+  const vec_t &W,
+  const vec_t &bias,
+  quantized_weights *qw) {
   // filter quantization
   float_t min_filter(W[0]);
   float_t max_filter(W[0]);
@@ -48,12 +34,16 @@ inline void tiny_quantized_deconv2d_kernel(const deconv_params &params,
     max_filter = W[0] + 1e-3f;
     min_filter = W[0] - 1e-3f;
   }
-  std::vector<uint8_t> W_quantized =
-    float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
+  qw->W = float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
+
+  qw->min_filter    = min_filter;
+  qw->max_filter    = max_filter;
+  qw->offset_filter = int64_to_int32(
+    float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter));
   // bias quantization
   float_t min_bias(0);
   float_t max_bias(0);
-  std::vector<uint8_t> bias_quantized;
+  qw->bias.clear();
   if (params.has_bias) {
     for (serial_size_t inc = 0; inc < params.out.depth_; inc++) {
       min_bias = std::min(min_bias, bias[inc]);
@@ -63,15 +53,38 @@ inline void tiny_quantized_deconv2d_kernel(const deconv_params &params,
       max_bias = bias[0] + 1e-3f;
       min_bias = bias[0] - 1e-3f;
     }
-    bias_quantized =
-      float_tensor_to_quantized<uint8_t>(bias, min_bias, max_bias);
+    qw->bias = float_tensor_to_quantized<uint8_t>(bias, min_bias, max_bias);
+  }
+  qw->min_bias = min_bias;
+  qw->max_bias = max_bias;
+}
+
+inline void tiny_quantized_deconv2d_kernel(const deconv_params &params,
+                                           const vec_t &in,
+                                           const quantized_weights &qw,
+                                           vec_t &out,
+                                           const bool layer_parallelize) {
+  // image quantization
+  float_t min_input(in[0]);
+  float_t max_input(in[0]);
+  for (serial_size_t inc = 0; inc < params.in.depth_; inc++) {
+    for (serial_size_t ins = 0; ins < params.in.height_ * params.in.height_;
+         ins++) {
+      serial_size_t idx = params.in.get_index(0, 0, inc);
+      min_input         = std::min(min_input, (&in[idx])[ins]);
+      max_input         = std::max(max_input, (&in[idx])[ins]);
+    }
   }
+  std::vector<uint8_t> in_quantized =
+    float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+  const std::vector<uint8_t> &W_quantized    = qw.W;
+  const std::vector<uint8_t> &bias_quantized = qw.bias;
 
   // output range
   float_t min_output_value;
   float_t max_output_value;
   quantization_range_for_multiplication<uint8_t, uint8_t, int32_t>(
-    min_input, max_input, min_filter, max_filter, &min_output_value,
+    min_input, max_input, qw.min_filter, qw.max_filter, &min_output_value,
     &max_output_value);
 
   std::vector<int32_t> out_quantized(out.size(), static_cast<int32_t>(0));
@@ -79,8 +92,7 @@ inline void tiny_quantized_deconv2d_kernel(const deconv_params &params,
   // calculating offset
   const int32_t offset_input = int64_to_int32(
     float_to_quantized_unclamped<uint8_t>(0.0f, min_input, max_input));
-  const int32_t offset_filter = int64_to_int32(
-    float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter));
+  const int32_t offset_filter = qw.offset_filter;
   const int32_t zero_in_total_space = int64_to_int32(
     float_to_quantized<int32_t>(0.0f, min_output_value, max_output_value));
 
@@ -142,6 +154,17 @@ inline void tiny_quantized_deconv2d_kernel(const deconv_params &params,
     out_requantized, min_output_requantized, max_output_requantized);
 }
 
+inline void tiny_quantized_deconv2d_kernel(const deconv_params &params,
+                                           const vec_t &in,
+                                           const vec_t &W,
+                                           const vec_t &bias,
+                                           vec_t &out,
+                                           const bool layer_parallelize) {
+  quantized_weights qw;
+  tiny_quantized_deconv2d_quantize_weights(params, W, bias, &qw);
+  tiny_quantized_deconv2d_kernel(params, in, qw, out, layer_parallelize);
+}
+
 inline void tiny_quantized_deconv2d_back_kernel(const deconv_params &params,
                                                 const vec_t &prev_out,
                                                 const vec_t &W,
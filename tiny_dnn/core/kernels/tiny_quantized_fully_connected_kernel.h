@@ -16,22 +16,11 @@ namespace tiny_dnn {
 namespace core {
 namespace kernels {
 
-inline void tiny_quantized_fully_connected_kernel(
+inline void tiny_quantized_fully_connected_quantize_weights(
   const fully_params &params,
-  const vec_t &in,
   const vec_t &W,
   const vec_t &b,
-  vec_t &out,
-  const bool layer_parallelize) {
-  // input quantization
-  float_t min_input(in[0]);
-  float_t max_input(in[0]);
-  for (serial_size_t c = 0; c < params.in_size_; c++) {
-    min_input = std::min(min_input, in[c]);
-    max_input = std::max(max_input, in[c]);
-  }
-  std::vector<uint8_t> in_quantized =
-    float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+  quantized_weights *qw) {
   // filter quantization
   float_t min_filter(W[0]);
   float_t max_filter(W[0]);
@@ -43,18 +32,16 @@ inline void tiny_quantized_fully_connected_kernel(
     max_filter = W[0] + 1e-3f;
     min_filter = W[0] - 1e-3f;
   }
-  std::vector<uint8_t> W_quantized =
-    float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
-  // output range
-  float_t min_output_value;
-  float_t max_output_value;
-  quantization_range_for_multiplication<uint8_t, uint8_t, int32_t>(
-    min_input, max_input, min_filter, max_filter, &min_output_value,
-    &max_output_value);
+  qw->W = float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
+
+  qw->min_filter = min_filter;
+  qw->max_filter = max_filter;
+  qw->offset_filter =
+    float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter);
   // bias quantization
   float_t min_bias(0);
   float_t max_bias(0);
-  std::vector<uint8_t> bias_quantized;
+  qw->bias.clear();
   if (params.has_bias_) {
     for (serial_size_t inc = 0; inc < b.size(); inc++) {
       min_bias = std::min(min_bias, b[inc]);
@@ -64,18 +51,45 @@ inline void tiny_quantized_fully_connected_kernel(
       max_bias = b[0] + 1e-3f;
       min_bias = b[0] - 1e-3f;
     }
-    bias_quantized = float_tensor_to_quantized<uint8_t>(b, min_bias, max_bias);
+    qw->bias = float_tensor_to_quantized<uint8_t>(b, min_bias, max_bias);
   }
-  min_output_value += min_bias;
-  max_output_value += max_bias;
+  qw->min_bias = min_bias;
+  qw->max_bias = max_bias;
+}
+
+inline void tiny_quantized_fully_connected_kernel(
+  const fully_params &params,
+  const vec_t &in,
+  const quantized_weights &qw,
+  const vec_t &b,
+  vec_t &out,
+  const bool layer_parallelize) {
+  // input quantization
+  float_t min_input(in[0]);
+  float_t max_input(in[0]);
+  for (serial_size_t c = 0; c < params.in_size_; c++) {
+    min_input = std::min(min_input, in[c]);
+    max_input = std::max(max_input, in[c]);
+  }
+  std::vector<uint8_t> in_quantized =
+    float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+  const std::vector<uint8_t> &W_quantized    = qw.W;
+  const std::vector<uint8_t> &bias_quantized = qw.bias;
+  // output range
+  float_t min_output_value;
+  float_t max_output_value;
+  quantization_range_for_multiplication<uint8_t, uint8_t, int32_t>(
+    min_input, max_input, qw.min_filter, qw.max_filter, &min_output_value,
+    &max_output_value);
+  min_output_value += qw.min_bias;
+  max_output_value += qw.max_bias;
 
   std::vector<int32_t> out_quantized(out.size(), static_cast<int32_t>(0));
 
   // calculating offset
   const int32_t offset_input =
     float_to_quantized_unclamped<uint8_t>(0.0f, min_input, max_input);
-  const int32_t offset_filter =
-    float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter);
+  const int32_t offset_filter = qw.offset_filter;
   const int32_t zero_in_total_space =
     float_to_quantized<int32_t>(0.0f, min_output_value, max_output_value);
 
@@ -124,6 +138,19 @@ inline void tiny_quantized_fully_connected_kernel(
     out_requantized, min_output_requantized, max_output_requantized);
 }
 
+inline void tiny_quantized_fully_connected_kernel(
+  const fully_params &params,
+  const vec_t &in,
+  const vec_t &W,
+  const vec_t &b,
+  vec_t &out,
+  const bool layer_parallelize) {
+  quantized_weights qw;
+  tiny_quantized_fully_connected_quantize_weights(params, W, b, &qw);
+  tiny_quantized_fully_connected_kernel(params, in, qw, b, out,
+                                        layer_parallelize);
+}
+
 inline void tiny_quantized_fully_connected_back_kernel(
   const fully_params &params,
   const vec_t &prev_out,
@@ -7,6 +7,8 @@
 */
 #pragma once
 
+#include <functional>
+
 #include "params.h"
 
 namespace tiny_dnn {
@@ -69,6 +71,18 @@ class conv_params : public Params {
   padding pad_type;
   serial_size_t w_stride;
   serial_size_t h_stride;
+  // output channel o only sees the in.depth_ / groups input channels of its
+  // group, starting at o / (out.depth_ / groups) * (in.depth_ / groups).
+  // the weights of (o, i), i-th input channel of the group, are stored at
+  // weight.get_index(0, 0, o * (in.depth_ / groups) + i). tbl must be empty
+  // with groups > 1
+  serial_size_t groups = 1;
+  // channel block of the input and output activations (see blocked_index).
+  // the layer doesn't pad a blocked input, conv2d_op_blocked does
+  serial_size_t channel_block = 1;
+  // applied in place to each output sample as soon as it is computed,
+  // e.g. a fused activation (see convolutional_layer::fuse_epilogue)
+  std::function<void(vec_t &)> epilogue;
 
   friend std::ostream &operator<<(std::ostream &o,
                                   const core::conv_params &param) {
@@ -79,6 +93,8 @@ class conv_params : public Params {
     o << "has_bias:  " << param.has_bias << "\n";
     o << "w_stride:  " << param.w_stride << "\n";
     o << "h_stride:  " << param.h_stride << "\n";
+    o << "groups:    " << param.groups << "\n";
+    o << "block:     " << param.channel_block << "\n";
     return o;
   }
 };
@@ -7,6 +7,8 @@
 */
 #pragma once
 
+#include <functional>
+
 #include "params.h"
 
 namespace tiny_dnn {
@@ -17,6 +19,9 @@ class fully_params : public Params {
   serial_size_t in_size_;
   serial_size_t out_size_;
   bool has_bias_;
+  // applied in place to each output sample as soon as it is computed,
+  // e.g. a fused activation (see fully_connected_layer::fuse_epilogue)
+  std::function<void(vec_t &)> epilogue;
 };
 
 // TODO(nyanp): can we do better here?
@@ -15,6 +15,9 @@ class global_avepool_params : public Params {
  public:
   shape3d in;
   shape3d out;
+  // channel block of the input (see blocked_index). the output has a single
+  // pixel, its layout is the same in every block
+  serial_size_t channel_block = 1;
 };
 
 inline global_avepool_params &Params::global_avepool() {
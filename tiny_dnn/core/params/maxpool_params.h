@@ -20,6 +20,8 @@ class maxpool_params : public Params {
   serial_size_t stride_x;
   serial_size_t stride_y;
   padding pad_type;
+  // channel block of the input and output (see blocked_index)
+  serial_size_t channel_block = 1;
 
   /* mapping out => max_index(in) (1:1) */
   std::vector<std::vector<serial_size_t>> out2inmax;
@@ -0,0 +1,71 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <vector>
+
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+namespace core {
+
+/**
+ * data derived from the weights of a layer (quantized weights, transformed
+ * filters ...), rebuilt only when the weights changed since it was built.
+ *
+ * the cached data belongs to one (layer, kind, parameter) key, where kind
+ * tells apart the derivations a kernel may pick and parameter is e.g. their
+ * tile size; asking for another key rebuilds it.
+ **/
+template <typename T, typename Kind = int>
+class weights_cache {
+ public:
+  /**
+   * returns what build(W, dst) derives from W, the first weight of l.
+   * weights which are not owned by l can't be tracked (see
+   * layer::weights_version()) and are derived again on every call.
+   **/
+  template <typename Layer, typename Build>
+  const T &get(const Layer *l,
+               const vec_t &W,
+               Kind kind,
+               serial_size_t param,
+               Build build) {
+    const std::vector<const vec_t *> owned =
+      l ? l->weights() : std::vector<const vec_t *>();
+    if (owned.empty() || owned[0] != &W) {
+      valid_ = false;
+      build(W, value_);
+    } else if (!valid_ || layer_ != l || kind_ != kind || param_ != param ||
+               version_ != l->weights_version()) {
+      build(W, value_);
+      layer_   = l;
+      kind_    = kind;
+      param_   = param;
+      version_ = l->weights_version();
+      valid_   = true;
+    }
+    return value_;
+  }
+
+  template <typename Layer, typename Build>
+  const T &get(const Layer *l, const vec_t &W, Build build) {
+    return get(l, W, Kind(), 0, build);
+  }
+
+ private:
+  T value_;
+  const void *layer_   = nullptr;
+  Kind kind_           = Kind();
+  serial_size_t param_ = 0;
+  size_t version_      = 0;
+  bool valid_          = false;
+};
+
+}  // namespace core
+}  // namespace tiny_dnn
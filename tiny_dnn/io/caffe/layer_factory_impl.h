@@ -436,7 +436,11 @@ inline void load_weights_conv(const caffe::LayerParameter &src, layer *dst) {
   int src_idx     = 0;
   int window_size = get_kernel_size_2d(conv_param);
 
-  if (conv_param.has_group()) {
+  // convolutional layers are grouped themselves and store the
+  // out x (in / group) filters of the blob as they are
+  if (conv_param.has_group() && dst->layer_type() == "conv") {
+    in_channels /= conv_param.group();
+  } else if (conv_param.has_group()) {
     table = connection_table(conv_param.group(), in_channels, out_channels);
   }
 
@@ -601,7 +605,7 @@ inline std::shared_ptr<layer> create_convlayer(
   layer_size_t w_stride = 1, h_stride = 1;
   bool has_bias    = true;
   padding pad_type = padding::valid;
-  connection_table table;
+  layer_size_t groups = 1;
 
   auto conv_param = layer.convolution_param();
 
@@ -649,12 +653,12 @@ inline std::shared_ptr<layer> create_convlayer(
 
   // group
   if (conv_param.has_group()) {
-    table = connection_table(conv_param.group(), in_channels, out_channels);
+    groups = conv_param.group();
   }
 
   auto conv = std::make_shared<conv_layer>(
-    in_width, in_height, window_size, in_channels, out_channels, table,
-    pad_type, has_bias, w_stride, h_stride);
+    in_width, in_height, window_size, window_size, in_channels, out_channels,
+    groups, pad_type, has_bias, w_stride, h_stride);
   // filler
   if (conv_param.has_weight_filler()) {
     conv->weight_init(create_filler(conv_param.weight_filler().type()));
@@ -28,28 +28,126 @@ inline void tiny_average_pooling_kernel(
   const shape3d &out_dim,
   float_t scale_factor,
   std::vector<typename partial_connected_layer::wi_connections> &out2wi) {
-  for_i(parallelize, in_data[0]->size(), [&](size_t sample) {
+  // with a small batch, the channels of a sample are split instead
+  const bool split =
+    parallelize_within_samples(parallelize, in_data[0]->size());
+
+  for_i(parallelize && !split, in_data[0]->size(), [&](size_t sample) {
     const vec_t &in = (*in_data[0])[sample];
     const vec_t &W  = (*in_data[1])[0];
     const vec_t &b  = (*in_data[2])[0];
     vec_t &out      = (*out_data[0])[sample];
 
     auto oarea = out_dim.area();
-    size_t idx = 0;
-    for (serial_size_t d = 0; d < out_dim.depth_; ++d) {
-      float_t weight = W[d] * scale_factor;
-      float_t bias   = b[d];
-      for (serial_size_t i = 0; i < oarea; ++i, ++idx) {
-        const auto &connections = out2wi[idx];
-        float_t value{0};
-        for (auto connection : connections) value += in[connection.second];
-        value *= weight;
-        value += bias;
-        out[idx] = value;
+    for_i(split, out_dim.depth_,
+          [&](size_t d) {
+            float_t weight = W[d] * scale_factor;
+            float_t bias   = b[d];
+            size_t idx     = d * oarea;
+            for (serial_size_t i = 0; i < oarea; ++i, ++idx) {
+              const auto &connections = out2wi[idx];
+              float_t value{0};
+              for (auto connection : connections)
+                value += in[connection.second];
+              value *= weight;
+              value += bias;
+              out[idx] = value;
+            }
+          },
+          1);
+
+    assert(out.size() == out2wi.size());
+  });
+}
+
+// output row oy of the channels [c, c + T::unroll_size) of a block of width
+// bw, where in, out, W and b point to channel c of the block. outputs whose
+// window isn't entirely inside the input have no connection, like in
+// average_pooling_layer::init_connection.
+template <typename T>
+void tiny_average_pooling_blocked_row(const shape3d &in_dim,
+                                      const shape3d &out_dim,
+                                      const shape3d &pool,
+                                      serial_size_t stride_x,
+                                      serial_size_t stride_y,
+                                      float_t scale_factor,
+                                      const float_t *in,
+                                      const float_t *W,
+                                      const float_t *b,
+                                      serial_size_t bw,
+                                      serial_size_t oy,
+                                      float_t *out) {
+  typedef typename T::register_type reg;
+  const reg weight = T::mul(T::template load<std::false_type>(W),
+                            T::set1(scale_factor));
+  const reg bias   = T::template load<std::false_type>(b);
+  const serial_size_t iy = oy * stride_y;
+  const bool full_rows   = iy + pool.height_ <= in_dim.height_;
+
+  for (serial_size_t ox = 0; ox < out_dim.width_; ox++) {
+    const serial_size_t ix = ox * stride_x;
+    reg sum                = T::zero();
+    if (full_rows && ix + pool.width_ <= in_dim.width_) {
+      for (serial_size_t dy = 0; dy < pool.height_; dy++) {
+        const float_t *p = in + ((iy + dy) * in_dim.width_ + ix) * bw;
+        for (serial_size_t dx = 0; dx < pool.width_; dx++) {
+          sum = T::add(sum, T::template load<std::false_type>(p + dx * bw));
+        }
       }
     }
+    T::template store<std::false_type>(
+      out + (oy * out_dim.width_ + ox) * bw, T::madd(sum, weight, bias));
+  }
+}
 
-    assert(out.size() == out2wi.size());
+// forward_propagation of channel-blocked activations (see blocked_index),
+// vectorized over the channels of each pixel
+inline void tiny_average_pooling_blocked_kernel(
+  bool parallelize,
+  const std::vector<tensor_t *> &in_data,
+  std::vector<tensor_t *> &out_data,
+  const shape3d &in_dim,
+  const shape3d &out_dim,
+  const shape3d &pool,
+  serial_size_t stride_x,
+  serial_size_t stride_y,
+  serial_size_t block,
+  float_t scale_factor) {
+  typedef vectorize::CNN_VECTORIZE_TYPE V;
+  typedef vectorize::detail::scalar_generic<float_t> S;
+  const serial_size_t oh     = out_dim.height_;
+  const serial_size_t blocks = (in_dim.depth_ + block - 1) / block;
+
+  // with a small batch, the rows of the blocks are split instead
+  const bool split =
+    parallelize_within_samples(parallelize, in_data[0]->size());
+
+  for_i(parallelize && !split, in_data[0]->size(), [&](size_t sample) {
+    const vec_t &in = (*in_data[0])[sample];
+    const vec_t &W  = (*in_data[1])[0];
+    const vec_t &b  = (*in_data[2])[0];
+    vec_t &out      = (*out_data[0])[sample];
+
+    for_i(split, blocks * oh,
+          [&](size_t j) {
+            const serial_size_t first = j / oh * block;
+            const serial_size_t oy    = j % oh;
+            const serial_size_t bw    = block_width(in_dim, block, first);
+            const float_t *pin        = &in[first * in_dim.area()];
+            float_t *pout             = &out[first * out_dim.area()];
+            serial_size_t c           = 0;
+            for (; c + V::unroll_size <= bw; c += V::unroll_size) {
+              tiny_average_pooling_blocked_row<V>(
+                in_dim, out_dim, pool, stride_x, stride_y, scale_factor,
+                pin + c, &W[first + c], &b[first + c], bw, oy, pout + c);
+            }
+            for (; c < bw; c++) {
+              tiny_average_pooling_blocked_row<S>(
+                in_dim, out_dim, pool, stride_x, stride_y, scale_factor,
+                pin + c, &W[first + c], &b[first + c], bw, oy, pout + c);
+            }
+          },
+          1);
   });
 }
 
@@ -66,11 +164,13 @@ inline void tiny_average_pooling_back_kernel(
   std::vector<typename partial_connected_layer::wo_connections> &in2wo,
   std::vector<std::vector<serial_size_t>> &bias2out) {
   CNN_UNREFERENCED_PARAMETER(out_data);
-  for_i(parallelize, in_data[0]->size(), [&](size_t sample) {
+  // samples of the same slot share one row of dW and db
+  for_i_slots(parallelize, in_data[0]->size(), in_grad[1]->size(), [&](
+                                                 size_t sample, size_t slot) {
     const vec_t &prev_out = (*in_data[0])[sample];
     const vec_t &W        = (*in_data[1])[0];
-    vec_t &dW             = (*in_grad[1])[sample];
-    vec_t &db             = (*in_grad[2])[sample];
+    vec_t &dW             = (*in_grad[1])[slot];
+    vec_t &db             = (*in_grad[2])[slot];
     vec_t &prev_delta     = (*in_grad[0])[sample];
     vec_t &curr_delta     = (*out_grad[0])[sample];
 
@@ -209,8 +309,30 @@ class average_pooling_layer : public partial_connected_layer {
 
   std::string layer_type() const override { return "ave-pool"; }
 
+  // the backward kernel accumulates into one gradient per worker thread
+  serial_size_t weight_grad_sample_count(
+    serial_size_t sample_count) const override {
+    return per_thread_grad_count(sample_count);
+  }
+
+  serial_size_t channel_block() const override { return channel_block_; }
+
+  // see tiny_average_pooling_blocked_kernel
+  bool set_channel_block(serial_size_t block) override {
+    if (block == 0) return false;
+    channel_block_ = block;
+    return true;
+  }
+
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
+    if (channel_block_ != 1) {
+      tiny_average_pooling_blocked_kernel(
+        parallelize_, in_data, out_data, in_, out_,
+        shape3d(pool_size_x_, pool_size_y_, 1), stride_x_, stride_y_,
+        channel_block_, Base::scale_factor_);
+      return;
+    }
     tiny_average_pooling_kernel(parallelize_, in_data, out_data, out_,
                                 Base::scale_factor_, Base::out2wi_);
   }
@@ -219,6 +341,9 @@ class average_pooling_layer : public partial_connected_layer {
                         const std::vector<tensor_t *> &out_data,
                         std::vector<tensor_t *> &out_grad,
                         std::vector<tensor_t *> &in_grad) override {
+    if (channel_block_ != 1) {
+      throw nn_error("back propagation in a channel-blocked layout");
+    }
     tiny_average_pooling_back_kernel(
       parallelize_, in_data, out_data, out_grad, in_grad, in_,
       Base::scale_factor_, Base::weight2io_, Base::in2wo_, Base::bias2out_);
@@ -239,6 +364,7 @@ class average_pooling_layer : public partial_connected_layer {
   shape3d in_;
   shape3d out_;
   shape3d w_;
+  serial_size_t channel_block_ = 1;
 
   static serial_size_t pool_out_dim(serial_size_t in_size,
                                     serial_size_t pooling_size,
@@ -95,6 +95,10 @@ class batch_normalization_layer : public layer {
 
     CNN_UNREFERENCED_PARAMETER(in_data);
 
+    if (channel_block_ != 1) {
+      throw nn_error("back propagation in a channel-blocked layout");
+    }
+
     tensor_t delta_dot_y = curr_out;
     vec_t mean_delta_dot_y, mean_delta, mean_Y;
 
@@ -135,6 +139,15 @@ class batch_normalization_layer : public layer {
     tensor_t &in  = *in_data[0];
     tensor_t &out = *out_data[0];
 
+    if (channel_block_ != 1) {
+      if (phase_ == net_phase::train) {
+        throw nn_error("batch statistics in a channel-blocked layout");
+      }
+      calc_stddev(variance);
+      forward_blocked(in, out);
+      return;
+    }
+
     if (phase_ == net_phase::train) {
       // calculate mean/variance from this batch in train phase
       moments(*in_data[0], in_spatial_size_, in_channels_, mean, variance);
@@ -164,6 +177,15 @@ class batch_normalization_layer : public layer {
 
   void set_context(net_phase ctx) override { phase_ = ctx; }
 
+  serial_size_t channel_block() const override { return channel_block_; }
+
+  // only the test phase, which uses the moving averages, is blocked
+  bool set_channel_block(serial_size_t block) override {
+    if (block == 0) return false;
+    channel_block_ = block;
+    return true;
+  }
+
   std::string layer_type() const override { return "batch-norm"; }
 
   void post_update() override {
@@ -208,6 +230,10 @@ class batch_normalization_layer : public layer {
     calc_stddev(variance);
   }
 
+  // moving averages, used in the test phase
+  const vec_t &mean() const { return mean_; }
+  const vec_t &variance() const { return variance_; }
+
   float_t epsilon() const { return eps_; }
 
   float_t momentum() const { return momentum_; }
@@ -221,6 +247,54 @@ class batch_normalization_layer : public layer {
     }
   }
 
+  // y = x * (1 / stddev) - mean / stddev, vectorized over the channels of
+  // each pixel of channel-blocked activations
+  template <typename T>
+  static void normalize_blocked(const float_t *in,
+                                const float_t *scale,
+                                const float_t *shift,
+                                serial_size_t bw,
+                                serial_size_t area,
+                                float_t *out) {
+    typedef typename T::register_type reg;
+    const reg a = T::template load<std::false_type>(scale);
+    const reg b = T::template load<std::false_type>(shift);
+    for (serial_size_t k = 0; k < area; k++) {
+      T::template store<std::false_type>(
+        out + k * bw,
+        T::madd(T::template load<std::false_type>(in + k * bw), a, b));
+    }
+  }
+
+  void forward_blocked(const tensor_t &in, tensor_t &out) {
+    typedef vectorize::CNN_VECTORIZE_TYPE V;
+    typedef vectorize::detail::scalar_generic<float_t> S;
+    const shape3d shape = in_shape()[0];
+    const serial_size_t block = channel_block_;
+    vec_t scale(in_channels_), shift(in_channels_);
+    for (serial_size_t j = 0; j < in_channels_; j++) {
+      scale[j] = float_t(1) / stddev_[j];
+      shift[j] = -mean_[j] * scale[j];
+    }
+
+    for_i(in.size(), [&](int i) {
+      for (serial_size_t first = 0; first < in_channels_; first += block) {
+        const serial_size_t bw = block_width(shape, block, first);
+        const float_t *pin     = &in[i][first * in_spatial_size_];
+        float_t *pout          = &out[i][first * in_spatial_size_];
+        serial_size_t c        = 0;
+        for (; c + V::unroll_size <= bw; c += V::unroll_size) {
+          normalize_blocked<V>(pin + c, &scale[first + c], &shift[first + c],
+                               bw, in_spatial_size_, pout + c);
+        }
+        for (; c < bw; c++) {
+          normalize_blocked<S>(pin + c, &scale[first + c], &shift[first + c],
+                               bw, in_spatial_size_, pout + c);
+        }
+      }
+    });
+  }
+
   void init() {
     mean_current_.resize(in_channels_);
     mean_.resize(in_channels_);
@@ -250,6 +324,8 @@ class batch_normalization_layer : public layer {
 
   // for test
   bool update_immidiately_;
+
+  serial_size_t channel_block_ = 1;
 };
 
 }  // namespace tiny_dnn
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -227,6 +228,51 @@ class convolutional_layer : public layer {
     layer::set_backend_type(backend_type);
   }
 
+  /**
+   * constructing grouped convolutional layer
+   *
+   * the channels are split into groups, and output channel o only sees the
+   * in_channels / groups input channels of its group. only their weights are
+   * stored: out_channels x (in_channels / groups) filters. groups ==
+   * in_channels is a depthwise convolution.
+   *
+   * @param in_width      [in] input image width
+   * @param in_height     [in] input image height
+   * @param window_width  [in] window_width(kernel) size of convolution
+   * @param window_height [in] window_height(kernel) size of convolution
+   * @param in_channels   [in] input image channels (grayscale=1, rgb=3)
+   * @param out_channels  [in] output image channels
+   * @param groups        [in] number of channel groups, which divides both
+   *in_channels and out_channels
+   * @param pad_type      [in] rounding strategy (see above)
+   * @param has_bias      [in] whether to add a bias vector to the filter
+   *outputs
+   * @param w_stride      [in] specify the horizontal interval at which to
+   *apply the filters to the input
+   * @param h_stride      [in] specify the vertical interval at which to apply
+   *the filters to the input
+   * @param backend_type  [in] specify backend engine you use
+   **/
+  convolutional_layer(serial_size_t in_width,
+                      serial_size_t in_height,
+                      serial_size_t window_width,
+                      serial_size_t window_height,
+                      serial_size_t in_channels,
+                      serial_size_t out_channels,
+                      serial_size_t groups,
+                      padding pad_type,
+                      bool has_bias          = true,
+                      serial_size_t w_stride = 1,
+                      serial_size_t h_stride = 1,
+                      backend_t backend_type = core::default_engine())
+    : layer(std_input_order(has_bias), {vector_type::data}) {
+    conv_set_params(shape3d(in_width, in_height, in_channels), window_width,
+                    window_height, out_channels, pad_type, has_bias, w_stride,
+                    h_stride, connection_table(), groups);
+    init_backend(backend_type);
+    layer::set_backend_type(backend_type);
+  }
+
   // move constructor
   convolutional_layer(convolutional_layer &&other)  // NOLINT
     : layer(std::move(other)),
@@ -240,13 +286,98 @@ class convolutional_layer : public layer {
 
   ///< number of incoming connections for each output unit
   serial_size_t fan_in_size() const override {
-    return params_.weight.width_ * params_.weight.height_ * params_.in.depth_;
+    return params_.weight.width_ * params_.weight.height_ * params_.in.depth_ /
+           params_.groups;
   }
 
   ///< number of outgoing connections for each input unit
   serial_size_t fan_out_size() const override {
     return (params_.weight.width_ / params_.w_stride) *
-           (params_.weight.height_ / params_.h_stride) * params_.out.depth_;
+           (params_.weight.height_ / params_.h_stride) * params_.out.depth_ /
+           params_.groups;
+  }
+
+  ///< number of channel groups (1 unless constructed with groups)
+  serial_size_t groups() const { return params_.groups; }
+
+  uint64_t forward_flops() const override {
+    const uint64_t outputs = params_.out.size();
+    return 2 * uint64_t(fan_in_size()) * outputs +
+           (params_.has_bias ? outputs : 0);
+  }
+
+  // the backward kernels accumulate into one gradient per worker thread
+  serial_size_t weight_grad_sample_count(
+    serial_size_t sample_count) const override {
+    return per_thread_grad_count(sample_count);
+  }
+
+  /**
+   * apply f in place to every output sample inside the convolution kernel,
+   * right after the sample is computed (e.g. a following activation, see
+   * network::optimize_for_inference). the layer can't be trained anymore.
+   *
+   * @return false if the engine doesn't support it
+   **/
+  bool fuse_epilogue(std::function<void(vec_t &)> f) {
+    const backend_t engine = layer::engine();
+    if (engine != backend_t::internal && engine != backend_t::nnpack &&
+        engine != backend_t::avx && engine != backend_t::gemm) {
+      return false;
+    }
+    params_.epilogue = std::move(f);
+    return true;
+  }
+
+  /**
+   * the function given to fuse_epilogue(), if any
+   **/
+  const std::function<void(vec_t &)> &epilogue() const {
+    return params_.epilogue;
+  }
+
+  /**
+   * change the weights and the bias so that output channel c becomes
+   * scale[c] * out + shift[c] (e.g. a following batch normalization).
+   *
+   * @return false if the layer has no bias
+   **/
+  bool fold_scale_shift(const vec_t &scale, const vec_t &shift) {
+    if (!params_.has_bias) return false;
+
+    auto w = weights();
+    // copy, the weights may be read-only (see load_weights_file)
+    vec_t W(w[0]->begin(), w[0]->end());
+    vec_t b(w[1]->begin(), w[1]->end());
+    const size_t size = W.size() / params_.out.depth_;
+    for (serial_size_t o = 0; o < params_.out.depth_; o++) {
+      float_t *pw = &W[o * size];
+      for (size_t i = 0; i < size; i++) pw[i] *= scale[o];
+      b[o] = b[o] * scale[o] + shift[o];
+    }
+    *w[0] = std::move(W);
+    *w[1] = std::move(b);
+    return true;
+  }
+
+  serial_size_t channel_block() const override {
+    return params_.channel_block;
+  }
+
+  /**
+   * dense and depthwise convolutions without connection table have a
+   * channel-blocked kernel on the cpu engines (see conv2d_op_blocked)
+   **/
+  bool set_channel_block(serial_size_t block) override {
+    const backend_t engine = layer::engine();
+    if (block != 1 &&
+        (block == 0 || !kernels::conv2d_blocked_supported(params_) ||
+         (engine != backend_t::internal && engine != backend_t::nnpack &&
+          engine != backend_t::avx && engine != backend_t::gemm))) {
+      return false;
+    }
+    params_.channel_block = block;
+    return true;
   }
 
   /**
@@ -255,15 +386,18 @@ class convolutional_layer : public layer {
    **/
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
-    // apply padding to the input tensor
-    padding_op_.copy_and_pad_input(*in_data[0], cws_.prev_out_padded_);
-
     fwd_in_data_.resize(in_data.size());
     std::copy(in_data.begin(), in_data.end(), fwd_in_data_.begin());
-    fwd_in_data_[0] = in_data_padded(in_data);
+
+    // apply padding to the input tensor. the blocked kernel pads by itself
+    if (params_.channel_block == 1) {
+      padding_op_.copy_and_pad_input(*in_data[0], cws_.prev_out_padded_);
+      fwd_in_data_[0] = in_data_padded(in_data);
+    }
 
     // forward convolutional op context
     fwd_ctx_.set_in_out(fwd_in_data_, out_data);
+    fwd_ctx_.setLayer(this);
     fwd_ctx_.setParallelize(layer::parallelize());
     fwd_ctx_.setEngine(layer::engine());
 
@@ -287,6 +421,13 @@ class convolutional_layer : public layer {
                         const std::vector<tensor_t *> &out_data,
                         std::vector<tensor_t *> &out_grad,
                         std::vector<tensor_t *> &in_grad) override {
+    if (params_.epilogue) {
+      throw nn_error("back propagation through a fused epilogue");
+    }
+    if (params_.channel_block != 1) {
+      throw nn_error("back propagation in a channel-blocked layout");
+    }
+
     bwd_in_data_.resize(in_data.size());
     std::copy(in_data.begin(), in_data.end(), bwd_in_data_.begin());
     bwd_in_data_[0] = in_data_padded(in_data);
@@ -367,9 +508,12 @@ class convolutional_layer : public layer {
 
     auto minmax = std::minmax_element(W.begin(), W.end());
 
+    const serial_size_t ig = params_.in.depth_ / params_.groups;
+    const serial_size_t og = params_.out.depth_ / params_.groups;
+
     for (serial_size_t r = 0; r < params_.in.depth_; ++r) {
       for (serial_size_t c = 0; c < params_.out.depth_; ++c) {
-        if (!params_.tbl.is_connected(c, r)) continue;
+        if (!params_.tbl.is_connected(c, r) || c / og != r / ig) continue;
 
         const auto top  = r * pitch + border_width;
         const auto left = c * pitch + border_width;
@@ -378,7 +522,7 @@ class convolutional_layer : public layer {
 
         for (serial_size_t y = 0; y < params_.weight.height_; ++y) {
           for (serial_size_t x = 0; x < params_.weight.width_; ++x) {
-            idx             = c * params_.in.depth_ + r;
+            idx             = c * ig + r % ig;
             idx             = params_.weight.get_index(x, y, idx);
             const float_t w = W[idx];
 
@@ -408,7 +552,11 @@ class convolutional_layer : public layer {
                        bool has_bias,
                        serial_size_t w_stride,
                        serial_size_t h_stride,
-                       const connection_table &tbl = connection_table()) {
+                       const connection_table &tbl = connection_table(),
+                       serial_size_t groups        = 1) {
+    if (groups == 0 || in.depth_ % groups || outc % groups) {
+      throw nn_error("groups must divide in_channels and out_channels");
+    }
     params_.in = in;
     params_.in_padded =
       shape3d(in_length(in.width_, w_width, ptype),
@@ -416,12 +564,13 @@ class convolutional_layer : public layer {
     params_.out =
       shape3d(conv_out_length(in.width_, w_width, w_stride, ptype),
               conv_out_length(in.height_, w_height, h_stride, ptype), outc);
-    params_.weight   = shape3d(w_width, w_height, in.depth_ * outc);
+    params_.weight   = shape3d(w_width, w_height, in.depth_ * outc / groups);
     params_.has_bias = has_bias;
     params_.pad_type = ptype;
     params_.w_stride = w_stride;
     params_.h_stride = h_stride;
     params_.tbl      = tbl;
+    params_.groups   = groups;
 
     // init padding buffer
     if (params_.pad_type == padding::same) {
@@ -468,10 +617,14 @@ class convolutional_layer : public layer {
       core::OpKernelConstruction(layer::device(), &params_);
 
     if (backend_type == backend_t::internal ||
-        backend_type == backend_t::nnpack || backend_type == backend_t::avx) {
+        backend_type == backend_t::nnpack || backend_type == backend_t::avx ||
+        backend_type == backend_t::gemm) {
       kernel_fwd_.reset(new Conv2dOp(ctx));
       kernel_back_.reset(new Conv2dGradOp(ctx));
       return;
+    } else if (params_.groups != 1) {
+      throw nn_error("grouped convolution isn't supported by " +
+                     to_string(backend_type));
     } else if (backend_type == backend_t::opencl) {
       throw nn_error("Not implemented engine: " + to_string(backend_type));
       /*kernel_fwd_.reset(new Conv2dOpenCLForwardOp(ctx));
@@ -226,6 +226,12 @@ class deconvolutional_layer : public layer {
            (params_.weight.height_ * params_.h_stride) * params_.out.depth_;
   }
 
+  uint64_t forward_flops() const override {
+    const uint64_t kernel = params_.weight.width_ * params_.weight.height_;
+    return 2 * kernel * params_.out.depth_ * params_.in.size() +
+           (params_.has_bias ? params_.out.size() : 0);
+  }
+
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
     // launch deconvolutional kernel
@@ -6,6 +6,8 @@
     in the LICENSE file.
 */
 #pragma once
+#include <functional>
+
 #include "tiny_dnn/layers/layer.h"
 
 #include "tiny_dnn/core/kernels/fully_connected_grad_op.h"
@@ -46,6 +48,61 @@ class fully_connected_layer : public layer {
 
   serial_size_t fan_out_size() const override { return params_.out_size_; }
 
+  uint64_t forward_flops() const override {
+    const uint64_t outputs = params_.out_size_;
+    return 2 * uint64_t(params_.in_size_) * outputs +
+           (params_.has_bias_ ? outputs : 0);
+  }
+
+  // the backward kernel accumulates the whole batch into one gradient
+  serial_size_t weight_grad_sample_count(serial_size_t) const override {
+    return 1;
+  }
+
+  /**
+   * apply f in place to every output sample inside the kernel, right after
+   * the sample is computed (e.g. a following activation, see
+   * network::optimize_for_inference). the layer can't be trained anymore.
+   *
+   * @return true, all engines support it
+   **/
+  bool fuse_epilogue(std::function<void(vec_t &)> f) {
+    params_.epilogue = std::move(f);
+    return true;
+  }
+
+  /**
+   * the function given to fuse_epilogue(), if any
+   **/
+  const std::function<void(vec_t &)> &epilogue() const {
+    return params_.epilogue;
+  }
+
+  /**
+   * change the weights and the bias so that output o becomes
+   * scale[o] * out + shift[o] (e.g. a following batch normalization).
+   *
+   * @return false if the layer has no bias
+   **/
+  bool fold_scale_shift(const vec_t &scale, const vec_t &shift) {
+    if (!params_.has_bias_) return false;
+
+    auto w = weights();
+    // copy, the weights may be read-only (see load_weights_file)
+    vec_t W(w[0]->begin(), w[0]->end());
+    vec_t b(w[1]->begin(), w[1]->end());
+    for (serial_size_t i = 0; i < params_.in_size_; i++) {
+      float_t *pw = &W[i * params_.out_size_];
+      for (serial_size_t o = 0; o < params_.out_size_; o++) pw[o] *= scale[o];
+    }
+    for (serial_size_t o = 0; o < params_.out_size_; o++) {
+      b[o] = b[o] * scale[o] + shift[o];
+    }
+    *w[0] = std::move(W);
+    *w[1] = std::move(b);
+    return true;
+  }
+
   std::vector<index3d<serial_size_t>> in_shape() const override {
     if (params_.has_bias_) {
       return {index3d<serial_size_t>(params_.in_size_, 1, 1),
@@ -76,6 +133,10 @@ class fully_connected_layer : public layer {
                         const std::vector<tensor_t *> &out_data,
                         std::vector<tensor_t *> &out_grad,
                         std::vector<tensor_t *> &in_grad) override {
+    if (params_.epilogue) {
+      throw nn_error("back propagation through a fused epilogue");
+    }
+
     // backward fully connected op context
     bwd_ctx_.set_in_out(in_data, out_data, out_grad, in_grad);
     bwd_ctx_.setParallelize(layer::parallelize());
@@ -103,7 +164,7 @@ class fully_connected_layer : public layer {
       core::OpKernelConstruction(layer::device(), &params_);
 
     if (backend_type == backend_t::internal || backend_type == backend_t::avx ||
-        backend_type == backend_t::nnpack) {
+        backend_type == backend_t::nnpack || backend_type == backend_t::gemm) {
       kernel_fwd_.reset(new FullyConnectedOp(ctx));
       kernel_back_.reset(new FullyConnectedGradOp(ctx));
     } else {
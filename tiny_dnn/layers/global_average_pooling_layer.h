@@ -57,6 +57,17 @@ class global_average_pooling_layer : public layer {
 
   serial_size_t fan_out_size() const override { return 1; }
 
+  serial_size_t channel_block() const override {
+    return params_.channel_block;
+  }
+
+  // see global_avepool_op_blocked
+  bool set_channel_block(serial_size_t block) override {
+    if (block == 0) return false;
+    params_.channel_block = block;
+    return true;
+  }
+
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
     fwd_ctx_.set_in_out(in_data, out_data);
@@ -70,6 +81,9 @@ class global_average_pooling_layer : public layer {
                         const std::vector<tensor_t *> &out_data,
                         std::vector<tensor_t *> &out_grad,
                         std::vector<tensor_t *> &in_grad) override {
+    if (params_.channel_block != 1) {
+      throw nn_error("back propagation in a channel-blocked layout");
+    }
     bwd_ctx_.set_in_out(in_data, out_data, out_grad, in_grad);
     bwd_ctx_.setParallelize(layer::parallelize());
     bwd_ctx_.setEngine(layer::engine());
@@ -7,6 +7,7 @@
 */
 #pragma once
 #include <algorithm>
+#include <cstdint>
 #include <iomanip>
 #include <memory>
 #include <numeric>
@@ -63,6 +64,7 @@ class layer : public node {
            static_cast<serial_size_t>(out_type.size())),
       initialized_(false),
       parallelize_(true),
+      weights_version_(0),
       in_channels_(in_type.size()),
       out_channels_(out_type.size()),
       in_type_(in_type),
@@ -174,6 +176,20 @@ class layer : public node {
     return v;
   }
 
+  /**
+   * counter which is incremented every time mutable access to the weights
+   * is taken (init_weight, update_weight, load, weights() ...).
+   * backends compare it to decide whether data derived from the weights
+   * (e.g. quantized filters) has to be rebuilt.
+   **/
+  size_t weights_version() const { return weights_version_; }
+
+  /**
+   * notify the layer that its weights were modified through a pointer
+   * which had been taken before the last forward pass.
+   **/
+  void mark_weights_changed() { weights_version_++; }
+
   std::vector<tensor_t *> weights_grads() {
     std::vector<tensor_t *> v;
     for (size_t i = 0; i < in_channels_; i++) {
@@ -216,7 +232,7 @@ class layer : public node {
       assert(n < cnt);
       const auto &src_grad = grad[n++];
       size_t sz            = src_grad.size();
-      dst_grad.resize(sz);
+      resize_batch(dst_grad, sz);
       for (size_t j = 0; j < sz; ++j) {
         dst_grad[j] = *src_grad[j];
       }
@@ -231,7 +247,7 @@ class layer : public node {
       assert(n < cnt);
       const auto &src_data = data[n++];
       size_t sz            = src_data.size();
-      dst_data.resize(sz);
+      resize_batch(dst_data, sz);
       for (size_t j = 0; j < sz; ++j) {
         dst_data[j] = *src_data[j];
       }
@@ -381,6 +397,25 @@ class layer : public node {
     initialized_ = true;
   }
 
+  /**
+   * take over src as the weights, in the order of weights(). the vectors
+   * are moved, so they may keep pointing into memory the layer doesn't own
+   * (see weights_file.h).
+   **/
+  void load_weights(std::vector<vec_t> &&src) {
+    auto all_weights = weights();
+    if (src.size() != all_weights.size()) {
+      throw nn_error("weight count mismatch in layer " + layer_type());
+    }
+    for (size_t i = 0; i < src.size(); i++) {
+      if (src[i].size() != all_weights[i]->size()) {
+        throw nn_error("weight size mismatch in layer " + layer_type());
+      }
+      *all_weights[i] = std::move(src[i]);
+    }
+    initialized_ = true;
+  }
+
 /////////////////////////////////////////////////////////////////////////
 // visualize
 
@@ -436,6 +471,29 @@ class layer : public node {
    **/
   virtual void set_context(net_phase ctx) { CNN_UNREFERENCED_PARAMETER(ctx); }
 
+  /**
+   * channel block of the activations read and written by this layer, see
+   * blocked_index(). 1 is the planar layout every layer supports.
+   **/
+  virtual serial_size_t channel_block() const { return 1; }
+
+  /**
+   * read and write the activations with the given channel block from now
+   * on. layers with channel-blocked kernels override it, the others only
+   * accept 1. only the forward pass supports a blocked layout.
+   *
+   * @return false (and the layout is unchanged) if the layer has no kernel
+   * for it
+   **/
+  virtual bool set_channel_block(serial_size_t block) { return block == 1; }
+
+  /**
+   * whether the output doesn't depend on the layout of the input, because
+   * every element is computed from the same element of the input. such a
+   * layer passes the layout of its input on.
+   **/
+  virtual bool is_layout_agnostic() const { return false; }
+
   /* @brief Performs layer forward operation given an input tensor and
    * returns the computed data in tensor form.
    *
@@ -685,24 +743,59 @@ class layer : public node {
     return true;
   }
 
+  /**
+   * estimated floating point operations of forward() for one sample, see
+   * profiler. one per output element by default.
+   **/
+  virtual uint64_t forward_flops() const {
+    uint64_t flops = 0;
+    for (const auto &s : out_shape()) flops += s.size();
+    return flops;
+  }
+
+  /**
+   * number of copies of each weight gradient kept for a batch of
+   * sample_count samples. by default every sample accumulates into its own
+   * copy and update_weight() sums them up. layers whose backward kernel
+   * reduces over the batch by itself only need one.
+   **/
+  virtual serial_size_t weight_grad_sample_count(
+    serial_size_t sample_count) const {
+    return sample_count;
+  }
+
+  /**
+   * weight gradient count for backward kernels that give each worker thread
+   * its own accumulator (see for_i_slots) instead of each sample.
+   **/
+  serial_size_t per_thread_grad_count(serial_size_t sample_count) const {
+    const size_t threads = parallelize_ ? num_threads() : 1;
+    return static_cast<serial_size_t>(std::max<size_t>(
+      1, std::min<size_t>(sample_count, threads)));
+  }
+
   virtual void set_sample_count(serial_size_t sample_count) {
-    // increase the size if necessary - but do not decrease
-    auto resize = [sample_count](tensor_t *tensor) {
-      tensor->resize(sample_count, (*tensor)[0]);
+    // keep the samples of each edge in one contiguous buffer. gradients
+    // released by the inference memory planner stay empty.
+    auto resize = [](tensor_t *tensor, serial_size_t count) {
+      if (!tensor->empty()) resize_batch(*tensor, count);
     };
 
     for (size_t i = 0; i < in_channels_; i++) {
       if (!is_trainable_weight(in_type_[i])) {
-        resize(ith_in_node(i)->get_data());
+        resize(ith_in_node(i)->get_data(), sample_count);
+        resize(ith_in_node(i)->get_gradient(), sample_count);
+      } else {
+        resize(ith_in_node(i)->get_gradient(),
+               weight_grad_sample_count(sample_count));
       }
-      resize(ith_in_node(i)->get_gradient());
     }
 
     for (serial_size_t i = 0; i < out_channels_; i++) {
       if (!is_trainable_weight(out_type_[i])) {
-        resize(ith_out_node(i)->get_data());
+        resize(ith_out_node(i)->get_data(), sample_count);
       }
-      resize(ith_out_node(i)->get_gradient());
+      resize(ith_out_node(i)->get_gradient(), sample_count);
     }
   }
 
@@ -723,6 +816,8 @@ class layer : public node {
   bool initialized_;
   /** Flag indicating whether the layer/node operations ara paralellized */
   bool parallelize_;
+  /** Incremented on every mutable access to the weights */
+  size_t weights_version_;
   /** The number of input vectors/edges */
   size_t in_channels_;
   /** The number of output vectors/edges */
@@ -831,10 +926,12 @@ class layer : public node {
   /* @brief Retrieves weight vector from incoming edge
    * @param i The position of incoming edge.
    *
-   * Returns the mutable pointer to the edge raw data.
+   * Returns the mutable pointer to the edge raw data. Since the caller
+   * may modify the weights, weights_version() is incremented.
    */
   vec_t *get_weight_data(serial_size_t i) {
     assert(is_trainable_weight(in_type_[i]));
+    weights_version_++;
     return &(*(ith_in_node(i)->get_data()))[0];
   }
 
@@ -877,6 +974,54 @@ inline void connect(layer *head,
   tail->prev_[tail_index]->add_next_node(tail);
 }
 
+/**
+ * take l, which has one input and one output, out of the graph: the
+ * consumers of its output read its input instead.
+ **/
+inline void bypass(layer *l) {
+  if (l->prev_.size() != 1 || l->next_.size() != 1 || !l->prev_[0] ||
+      !l->next_[0]) {
+    throw nn_error("only a layer with one input and one output can be removed");
+  }
+  edgeptr_t in  = l->prev_[0];
+  edgeptr_t out = l->next_[0];
+
+  in->remove_next_node(l);
+  for (auto n : out->next()) {
+    for (auto &e : n->prev_) {
+      if (e == out) e = in;
+    }
+    in->add_next_node(n);
+  }
+  while (!out->next().empty()) out->remove_next_node(out->next().back());
+  l->prev_[0].reset();
+}
+
+/**
+ * put l, which has one input and one output, between the edge e and its
+ * consumer tail (nullptr for none): l reads e, and the ports of tail which
+ * read e read the output of l instead. several consumers of e can be moved
+ * onto the same l one after the other.
+ **/
+inline void splice(layer *l, const edgeptr_t &e, node *tail) {
+  if (l->prev_.size() != 1 || l->next_.size() != 1) {
+    throw nn_error("only a layer with one input and one output can be added");
+  }
+  if (l->prev_[0] != e) {
+    l->prev_[0] = e;
+    e->add_next_node(l);
+    l->setup(false);
+  }
+  if (!tail) return;
+
+  edgeptr_t out = l->next_[0];
+  for (auto &p : tail->prev_) {
+    if (p == e) p = out;
+  }
+  e->remove_next_node(tail);
+  out->add_next_node(tail);
+}
+
 inline layer &operator<<(layer &lhs, layer &rhs) {
   connect(&lhs, &rhs);
   return rhs;
@@ -27,4 +27,5 @@
 #include "tiny_dnn/layers/quantized_deconvolutional_layer.h"
 #include "tiny_dnn/layers/quantized_fully_connected_layer.h"
 #include "tiny_dnn/layers/recurrent_cell_layer.h"
+#include "tiny_dnn/layers/reorder_layer.h"
 #include "tiny_dnn/layers/slice_layer.h"
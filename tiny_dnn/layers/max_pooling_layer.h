@@ -115,6 +115,21 @@ class max_pooling_layer : public layer {
 
   serial_size_t fan_out_size() const override { return 1; }
 
+  uint64_t forward_flops() const override {
+    return uint64_t(fan_in_size()) * out_shape()[0].size();
+  }
+
+  serial_size_t channel_block() const override {
+    return params_.channel_block;
+  }
+
+  // see maxpool_op_blocked
+  bool set_channel_block(serial_size_t block) override {
+    if (block == 0) return false;
+    params_.channel_block = block;
+    return true;
+  }
+
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
     // forward convolutional op context
@@ -130,6 +145,10 @@ class max_pooling_layer : public layer {
                         const std::vector<tensor_t *> &out_data,
                         std::vector<tensor_t *> &out_grad,
                         std::vector<tensor_t *> &in_grad) override {
+    if (params_.channel_block != 1) {
+      throw nn_error("back propagation in a channel-blocked layout");
+    }
+
     // backward convolutional op context
     bwd_ctx_.set_in_out(in_data, out_data, out_grad, in_grad);
     bwd_ctx_.setParallelize(layer::parallelize());
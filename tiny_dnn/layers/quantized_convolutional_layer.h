@@ -229,6 +229,12 @@ class quantized_convolutional_layer : public layer {
            (params_.weight.height_ / params_.h_stride) * params_.out.depth_;
   }
 
+  uint64_t forward_flops() const override {
+    const uint64_t outputs = params_.out.size();
+    return 2 * uint64_t(fan_in_size()) * outputs +
+           (params_.has_bias ? outputs : 0);
+  }
+
   /**
    * @param in_data      input vectors of this layer (data, weight, bias)
    * @param out_data     output vectors
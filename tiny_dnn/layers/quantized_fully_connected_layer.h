@@ -42,6 +42,12 @@ class quantized_fully_connected_layer : public layer {
 
   serial_size_t fan_out_size() const override { return params_.out_size_; }
 
+  uint64_t forward_flops() const override {
+    const uint64_t outputs = params_.out_size_;
+    return 2 * uint64_t(params_.in_size_) * outputs +
+           (params_.has_bias_ ? outputs : 0);
+  }
+
   std::vector<index3d<serial_size_t>> in_shape() const override {
     if (params_.has_bias_) {
       return {index3d<serial_size_t>(params_.in_size_, 1, 1),
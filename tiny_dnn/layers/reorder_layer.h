@@ -0,0 +1,99 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tiny_dnn/layers/layer.h"
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+
+/**
+ * copy the activations src of shape s from the channel block src_block to
+ * dst_block (see blocked_index)
+ **/
+inline void reorder_channel_blocks(const shape3d &s,
+                                   serial_size_t src_block,
+                                   serial_size_t dst_block,
+                                   const float_t *src,
+                                   float_t *dst) {
+  const serial_size_t area = s.area();
+  for (serial_size_t c = 0; c < s.depth_; c++) {
+    const float_t *ps = src + blocked_index(s, src_block, 0, 0, c);
+    float_t *pd       = dst + blocked_index(s, dst_block, 0, 0, c);
+    const serial_size_t ss =
+      block_width(s, src_block, c / src_block * src_block);
+    const serial_size_t ds =
+      block_width(s, dst_block, c / dst_block * dst_block);
+    for (serial_size_t i = 0; i < area; i++) pd[i * ds] = ps[i * ss];
+  }
+}
+
+/**
+ * conversion between two channel-blocked layouts of the same activations.
+ * nodes::set_channel_block inserts it wherever a layer reads its input in
+ * another layout than the one it was written in.
+ **/
+class reorder_layer : public layer {
+ public:
+  /**
+   * @param shape     [in] shape of the activations
+   * @param in_block  [in] channel block of the input
+   * @param out_block [in] channel block of the output
+   **/
+  reorder_layer(const shape3d &shape,
+                serial_size_t in_block,
+                serial_size_t out_block)
+    : layer({vector_type::data}, {vector_type::data}),
+      shape_(shape),
+      in_block_(in_block),
+      out_block_(out_block) {}
+
+  std::string layer_type() const override { return "reorder"; }
+
+  std::vector<shape3d> in_shape() const override { return {shape_}; }
+
+  std::vector<shape3d> out_shape() const override { return {shape_}; }
+
+  void forward_propagation(const std::vector<tensor_t *> &in_data,
+                           std::vector<tensor_t *> &out_data) override {
+    const tensor_t &x = *in_data[0];
+    tensor_t &y       = *out_data[0];
+    for_i(x.size(), [&](size_t i) {
+      reorder_channel_blocks(shape_, in_block_, out_block_, &x[i][0],
+                             &y[i][0]);
+    });
+  }
+
+  void back_propagation(const std::vector<tensor_t *> &in_data,
+                        const std::vector<tensor_t *> &out_data,
+                        std::vector<tensor_t *> &out_grad,
+                        std::vector<tensor_t *> &in_grad) override {
+    CNN_UNREFERENCED_PARAMETER(in_data);
+    CNN_UNREFERENCED_PARAMETER(out_data);
+    tensor_t &dx       = *in_grad[0];
+    const tensor_t &dy = *out_grad[0];
+    for_i(dy.size(), [&](size_t i) {
+      reorder_channel_blocks(shape_, out_block_, in_block_, &dy[i][0],
+                             &dx[i][0]);
+    });
+  }
+
+  serial_size_t in_block() const { return in_block_; }
+
+  serial_size_t out_block() const { return out_block_; }
+
+ private:
+  shape3d shape_;
+  serial_size_t in_block_;
+  serial_size_t out_block_;
+};
+
+}  // namespace tiny_dnn
@@ -0,0 +1,46 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+// #include "tiny_dnn/tiny_dnn.h"
+
+namespace models {
+
+// LeNet-5 for 32x32 grayscale images and 10 classes, as in examples/mnist.
+// Based on: Y. LeCun et al., Gradient-based learning applied to document
+// recognition, 1998
+class lenet : public network<sequential> {
+ public:
+  explicit lenet(const std::string &name = "") : network<sequential>(name) {
+// connection table of C3 [Y.Lecun, 1998 Table.1]
+#define O true
+#define X false
+    // clang-format off
+    static const bool tbl[] = {
+        O, X, X, X, O, O, O, X, X, O, O, O, O, X, O, O,
+        O, O, X, X, X, O, O, O, X, X, O, O, O, O, X, O,
+        O, O, O, X, X, X, O, O, O, X, X, O, X, O, O, O,
+        X, O, O, O, X, X, O, O, O, O, X, X, O, X, O, O,
+        X, X, O, O, O, X, X, O, O, O, O, X, O, O, X, O,
+        X, X, X, O, O, O, X, X, O, O, O, O, X, O, O, O
+    };
+// clang-format on
+#undef O
+#undef X
+
+    *this << conv(32, 32, 5, 1, 6) << tanh_layer();  // C1: 6@28x28
+    *this << ave_pool(28, 28, 6, 2) << tanh_layer();  // S2: 6@14x14
+    *this << conv(14, 14, 5, 6, 16, connection_table(tbl, 6, 16))
+          << tanh_layer();                             // C3: 16@10x10
+    *this << ave_pool(10, 10, 16, 2) << tanh_layer();  // S4: 16@5x5
+    *this << conv(5, 5, 5, 16, 120) << tanh_layer();   // C5: 120@1x1
+    *this << fc(120, 10) << tanh_layer();              // F6
+  }
+};
+
+}  // namespace models
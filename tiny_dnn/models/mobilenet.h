@@ -0,0 +1,58 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+// #include "tiny_dnn/tiny_dnn.h"
+
+namespace models {
+
+// MobileNet-style network for 32x32 RGB images: a 3x3 convolution, then
+// depthwise separable blocks (a 3x3 convolution of each channel on its own
+// followed by a 1x1 convolution), each convolution followed by batch
+// normalization and relu, then global average pooling and a classifier.
+// Based on: A. G. Howard et al., MobileNets: Efficient convolutional neural
+// networks for mobile vision applications, 2017
+class mobilenet : public network<sequential> {
+ public:
+  explicit mobilenet(serial_size_t n_classes = 10,
+                     const std::string &name = "")
+    : network<sequential>(name) {
+    serial_size_t size = 32;
+    *this << conv(size, size, 3, 3, 32, padding::same);
+    bn_relu(size, 32);
+
+    // {out channels, stride}
+    const serial_size_t blocks[][2] = {{64, 1},  {128, 2}, {128, 1},
+                                       {256, 2}, {256, 1}, {512, 2}};
+    serial_size_t channels = 32;
+    for (const auto &b : blocks) {
+      const serial_size_t out_channels = b[0], stride = b[1];
+
+      // depthwise: out channel c only sees in channel c
+      *this << conv(size, size, 3, 3, channels, channels, channels,
+                    padding::same, true, stride, stride);
+      size = (size + stride - 1) / stride;
+      bn_relu(size, channels);
+
+      // pointwise
+      *this << conv(size, size, 1, channels, out_channels);
+      bn_relu(size, out_channels);
+      channels = out_channels;
+    }
+
+    *this << global_average_pooling_layer(size, size, channels);
+    *this << fc(channels, n_classes) << softmax_layer();
+  }
+
+ private:
+  void bn_relu(serial_size_t size, serial_size_t channels) {
+    *this << batch_normalization_layer(size * size, channels) << relu_layer();
+  }
+};
+
+}  // namespace models
@@ -0,0 +1,103 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+// #include "tiny_dnn/tiny_dnn.h"
+
+namespace models {
+
+// ResNet-style network for 32x32 RGB images, the CIFAR-10 variant of the
+// paper: a 3x3 convolution, three stages of blocks_per_stage residual
+// blocks with 16, 32 and 64 channels (the first block of a stage halves
+// the resolution and projects its shortcut with a 1x1 convolution), then
+// global average pooling and a classifier. blocks_per_stage = 3 makes
+// ResNet-20.
+// Based on: K. He et al., Deep residual learning for image recognition,
+// 2016
+class resnet : public network<graph> {
+ public:
+  explicit resnet(serial_size_t blocks_per_stage = 3,
+                  serial_size_t n_classes        = 10,
+                  const std::string &name        = "")
+    : network<graph>(name) {
+    serial_size_t size = 32;
+    layer *in =
+      own(std::make_shared<conv>(size, size, 3, 3, 16, padding::same));
+    layer *x = bn_relu(in, size, 16);
+
+    serial_size_t channels = 16;
+    for (serial_size_t out_channels : {16, 32, 64}) {
+      for (serial_size_t i = 0; i < blocks_per_stage; i++) {
+        const serial_size_t stride = (i == 0 && out_channels != 16) ? 2 : 1;
+        x        = block(x, size, channels, out_channels, stride);
+        size     = (size + stride - 1) / stride;
+        channels = out_channels;
+      }
+    }
+
+    layer *pool = then(
+      x, std::make_shared<global_average_pooling_layer>(size, size, channels));
+    layer *out = then(then(pool, std::make_shared<fc>(channels, n_classes)),
+                      std::make_shared<softmax_layer>());
+    construct_graph(*this, {in}, {out});
+  }
+
+ private:
+  layer *own(std::shared_ptr<layer> l) {
+    layers_.push_back(l);
+    return l.get();
+  }
+
+  // l fed by the output of prev
+  layer *then(layer *prev, std::shared_ptr<layer> l) {
+    connect(prev, own(l));
+    return l.get();
+  }
+
+  layer *bn_relu(layer *prev, serial_size_t size, serial_size_t channels) {
+    layer *bn = then(prev, std::make_shared<batch_normalization_layer>(
+                             size * size, channels));
+    return then(bn, std::make_shared<relu_layer>());
+  }
+
+  // conv-bn-relu-conv-bn, plus the shortcut, then relu
+  layer *block(layer *x,
+               serial_size_t size,
+               serial_size_t in_channels,
+               serial_size_t out_channels,
+               serial_size_t stride) {
+    const serial_size_t out_size = (size + stride - 1) / stride;
+
+    layer *y = then(x, std::make_shared<conv>(size, size, 3, in_channels,
+                                              out_channels, padding::same,
+                                              true, stride, stride));
+    y = bn_relu(y, out_size, out_channels);
+    y = then(y, std::make_shared<conv>(out_size, out_size, 3, out_channels,
+                                       out_channels, padding::same));
+    y = then(y, std::make_shared<batch_normalization_layer>(
+                  out_size * out_size, out_channels));
+
+    layer *shortcut = x;
+    if (stride != 1 || in_channels != out_channels) {
+      shortcut = then(x, std::make_shared<conv>(size, size, 1, in_channels,
+                                                out_channels, padding::same,
+                                                true, stride, stride));
+    }
+
+    layer *sum = own(std::make_shared<elementwise_add_layer>(
+      2, out_size * out_size * out_channels));
+    connect(y, sum, 0, 0);
+    connect(shortcut, sum, 0, 1);
+    return then(sum, std::make_shared<relu_layer>());
+  }
+
+  // the graph doesn't own its layers
+  std::vector<std::shared_ptr<layer>> layers_;
+};
+
+}  // namespace models
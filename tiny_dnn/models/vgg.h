@@ -0,0 +1,38 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+// #include "tiny_dnn/tiny_dnn.h"
+
+namespace models {
+
+// VGG-style network for 32x32 RGB images (e.g. CIFAR-10): three blocks of
+// two 3x3 convolutions and a 2x2 max pooling, then two fully connected
+// layers.
+// Based on: K. Simonyan and A. Zisserman, Very deep convolutional networks
+// for large-scale image recognition, 2014
+class vgg : public network<sequential> {
+ public:
+  explicit vgg(serial_size_t n_classes = 10, const std::string &name = "")
+    : network<sequential>(name) {
+    serial_size_t size = 32, channels = 3;
+    for (serial_size_t out_channels : {32, 64, 128}) {
+      *this << conv(size, size, 3, channels, out_channels, padding::same)
+            << relu_layer();
+      *this << conv(size, size, 3, out_channels, out_channels, padding::same)
+            << relu_layer();
+      *this << max_pool(size, size, out_channels, 2);
+      size /= 2;
+      channels = out_channels;
+    }
+    *this << fc(size * size * channels, 512) << relu_layer();
+    *this << fc(512, n_classes) << softmax_layer();
+  }
+};
+
+}  // namespace models
@@ -16,7 +16,9 @@
 #include <iterator>
 #include <limits>
 #include <map>
+#include <memory>
 #include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -24,6 +26,7 @@
 #include "tiny_dnn/lossfunctions/loss_function.h"
 #include "tiny_dnn/nodes.h"
 #include "tiny_dnn/util/util.h"
+#include "tiny_dnn/util/weights_file.h"
 
 namespace tiny_dnn {
 
@@ -106,6 +109,29 @@ void construct_graph(network<graph> &graph,
 void construct_graph(network<graph> &graph,
                      const std::vector<layer *> &inputs,
                      const std::vector<layer *> &outputs);
+
+/**
+ * the mutable state of the forward pass of a network: the activations and
+ * the scratch space of its layers. made by network::make_context(), see
+ * network::predict(execution_context&, ...).
+ **/
+template <typename NetType>
+class execution_context {
+ public:
+  execution_context(execution_context &&) = default;
+  execution_context &operator=(execution_context &&) = default;
+
+ private:
+  friend class network<NetType>;
+
+  execution_context(const network<NetType> *owner,
+                    std::unique_ptr<network<NetType>> net)
+    : owner_(owner), net_(std::move(net)) {}
+
+  const network<NetType> *owner_;
+  // same layers as owner_, with the weights of owner_
+  std::unique_ptr<network<NetType>> net_;
+};
 /**
  * A model of neural networks in tiny-dnn
  *
@@ -179,6 +205,69 @@ class network {
     return fprop(in);
   }
 
+  /**
+   * create the state needed to run forward passes of this network apart
+   * from it. several threads can call predict() concurrently as long as
+   * each of them uses its own context; they share the weights of the
+   * network without copying them.
+   *
+   * the layers of the network must support serialization, so this throws
+   * nn_error while set_channel_block() has inserted reorder layers, which
+   * can't be serialized. contexts must not outlive the network, and must be
+   * made again after its layers or weights are changed (e.g. training,
+   * load(), optimize_for_inference()).
+   **/
+  execution_context<NetType> make_context() const {
+#ifndef CNN_NO_SERIALIZATION
+    std::stringstream ss;
+    {
+      cereal::BinaryOutputArchive oa(ss);
+      to_archive(oa, content_type::model);
+    }
+    std::unique_ptr<network> clone(new network(name_));
+    {
+      cereal::BinaryInputArchive ia(ss);
+      clone->from_archive(ia, content_type::model);
+    }
+
+    auto dst = clone->net_.begin();
+    for (auto src = net_.begin(); src != net_.end(); ++src, ++dst) {
+      share_layer(**src, **dst);
+    }
+    clone->net_.set_memory_planning(net_.memory_planning());
+    clone->set_netphase(net_phase::test);
+    return execution_context<NetType>(this, std::move(clone));
+#else
+    throw nn_error("TinyDNN was not built with Serialization support");
+#endif  // CNN_NO_SERIALIZATION
+  }
+
+  /**
+   * executes forward-propagation in ctx and returns output. the network
+   * itself isn't modified, see make_context().
+   **/
+  vec_t predict(execution_context<NetType> &ctx, const vec_t &in) const {
+    check_context(ctx);
+    return ctx.net_->predict(in);
+  }
+
+  /**
+   * executes forward-propagation in ctx and returns output
+   **/
+  tensor_t predict(execution_context<NetType> &ctx, const tensor_t &in) const {
+    check_context(ctx);
+    return ctx.net_->predict(in);
+  }
+
+  /**
+   * executes forward-propagation in ctx and returns output
+   **/
+  std::vector<tensor_t> predict(execution_context<NetType> &ctx,
+                                const std::vector<tensor_t> &in) const {
+    check_context(ctx);
+    return ctx.net_->predict(in);
+  }
+
   /**
    * executes forward-propagation and returns maximum output
    **/
@@ -386,11 +475,73 @@ class network {
    * @param phase phase of network, could be train or test
    */
   void set_netphase(net_phase phase) {
+    net_.set_phase(phase);
     for (auto n : net_) {
       n->set_context(phase);
     }
   }
 
+  /**
+   * let the layers share activation buffers, and don't allocate gradients,
+   * when the network is not being trained. peak memory of a forward pass
+   * drops to about the largest activations which are alive at the same
+   * time. the outputs of intermediate layers are overwritten during the
+   * forward pass, and backward is not available while the plan is active.
+   * training (set_netphase(net_phase::train)) releases the plan.
+   **/
+  void set_memory_planning(bool enable) { net_.set_memory_planning(enable); }
+
+  /**
+   * record the time, estimated flops and bytes, and allocations of every
+   * forward, backward and weight update of the layers in p (see
+   * profiler). nullptr stops profiling. p must outlive its use.
+   **/
+  void set_profiler(profiler *p) { net_.set_profiler(p); }
+
+  /**
+   * bytes shared by the activations of the current memory plan
+   **/
+  size_t planned_memory_size() const { return net_.planned_memory_size(); }
+
+  /**
+   * rewrite the network for inference:
+   * - dropout layers are removed, they are the identity in the test phase
+   * - batch normalization after a convolutional or fully connected layer is
+   *   folded into its weights and bias
+   * - an activation after a convolutional or fully connected layer is
+   *   applied by its kernel to each output sample while it is still in
+   *   cache, instead of in a separate pass
+   *
+   * removed layers are no longer part of the network, so depth() and the
+   * indices of the layers change. the network can't be trained afterwards,
+   * and saving its model loses the fused activations.
+   **/
+  void optimize_for_inference() {
+    set_netphase(net_phase::test);
+    net_.optimize_for_inference();
+  }
+
+  /**
+   * run the layers in a channel-blocked layout: the activations are stored
+   * in blocks of `block` channels, pixel by pixel, so that the kernels of
+   * the convolutional, pooling and batch normalization layers and of the
+   * elementwise activations vectorize over the channels of a pixel instead
+   * of along the rows of the image. 8 and 16 match the width of AVX
+   * vectors, a block of at least the number of channels stores the
+   * activations as HWC, and 1 goes back to the planar layout.
+   *
+   * reorder layers are inserted wherever a layer without a blocked kernel
+   * reads blocked activations, and at the inputs and outputs of the
+   * network, which keep the planar layout. they change depth() and the
+   * indices of the layers. the blocked kernels are for inference: the
+   * network must go back to block 1 before it is trained or saved, and
+   * contexts must be made again afterwards.
+   **/
+  void set_channel_block(serial_size_t block) {
+    if (block != 1) set_netphase(net_phase::test);
+    net_.set_channel_block(block);
+  }
+
   /**
    * request to finish an ongoing training
    *
@@ -403,30 +554,53 @@ class network {
 
   /**
    * test and generate confusion-matrix for classification task
+   *
+   * @param in         array of input data
+   * @param t          array of label-id for each input data(0-origin)
+   * @param batch_size number of samples fed to the network at once
    **/
-  result test(const std::vector<vec_t> &in, const std::vector<label_t> &t) {
+  result test(const std::vector<vec_t> &in,
+              const std::vector<label_t> &t,
+              size_t batch_size = CNN_TEST_BATCH_SIZE) {
     result test_result;
+    std::vector<label_t> predicted;
     set_netphase(net_phase::test);
-    for (size_t i = 0; i < in.size(); i++) {
-      const label_t predicted = fprop_max_index(in[i]);
-      const label_t actual    = t[i];
 
-      if (predicted == actual) test_result.num_success++;
-      test_result.num_total++;
-      test_result.confusion_matrix[predicted][actual]++;
-    }
+    fprop_batches(in, batch_size, [&](size_t offset,
+                                      const std::vector<tensor_t> &out) {
+      predicted.resize(out.size());
+      for_i(out.size(), [&](size_t i) {
+        predicted[i] = static_cast<label_t>(max_index(out[i][0]));
+      });
+
+      for (size_t i = 0; i < out.size(); i++) {
+        const label_t actual = t[offset + i];
+
+        if (predicted[i] == actual) test_result.num_success++;
+        test_result.num_total++;
+        test_result.confusion_matrix[predicted[i]][actual]++;
+      }
+    });
     return test_result;
   }
 
   /**
    * generate output for each input
+   *
+   * @param in         array of input data
+   * @param batch_size number of samples fed to the network at once
    **/
-  std::vector<vec_t> test(const std::vector<vec_t> &in) {
+  std::vector<vec_t> test(const std::vector<vec_t> &in,
+                          size_t batch_size = CNN_TEST_BATCH_SIZE) {
     std::vector<vec_t> test_result(in.size());
     set_netphase(net_phase::test);
-    for (size_t i = 0; i < in.size(); i++) {
-      test_result[i] = predict(in[i]);
-    }
+
+    fprop_batches(in, batch_size, [&](size_t offset,
+                                      const std::vector<tensor_t> &out) {
+      for (size_t i = 0; i < out.size(); i++) {
+        test_result[offset + i] = out[i][0];
+      }
+    });
     return test_result;
   }
 
@@ -434,13 +608,17 @@ class network {
    * calculate loss value (the smaller, the better) for regression task
    **/
   template <typename E>
-  float_t get_loss(const std::vector<vec_t> &in, const std::vector<vec_t> &t) {
+  float_t get_loss(const std::vector<vec_t> &in,
+                   const std::vector<vec_t> &t,
+                   size_t batch_size = CNN_TEST_BATCH_SIZE) {
     float_t sum_loss = float_t(0);
 
-    for (size_t i = 0; i < in.size(); i++) {
-      const vec_t predicted = predict(in[i]);
-      sum_loss += E::f(predicted, t[i]);
-    }
+    fprop_batches(in, batch_size, [&](size_t offset,
+                                      const std::vector<tensor_t> &out) {
+      for (size_t i = 0; i < out.size(); i++) {
+        sum_loss += E::f(out[i][0], t[offset + i]);
+      }
+    });
     return sum_loss;
   }
 
@@ -448,17 +626,22 @@ class network {
    * calculate loss value (the smaller, the better) for regression task
    **/
   template <typename E, typename T>
-  float_t get_loss(const std::vector<T> &in, const std::vector<tensor_t> &t) {
+  float_t get_loss(const std::vector<T> &in,
+                   const std::vector<tensor_t> &t,
+                   size_t batch_size = CNN_TEST_BATCH_SIZE) {
     float_t sum_loss = float_t(0);
     std::vector<tensor_t> in_tensor;
     normalize_tensor(in, in_tensor);
 
-    for (size_t i = 0; i < in.size(); i++) {
-      const tensor_t predicted = predict(in_tensor[i]);
-      for (size_t j = 0; j < predicted.size(); j++) {
-        sum_loss += E::f(predicted[j], t[i][j]);
+    fprop_batches(in_tensor, batch_size, [&](size_t offset,
+                                             const std::vector<tensor_t> &out) {
+      for (size_t i = 0; i < out.size(); i++) {
+        const tensor_t &predicted = out[i];
+        for (size_t j = 0; j < predicted.size(); j++) {
+          sum_loss += E::f(predicted[j], t[offset + i][j]);
+        }
       }
-    }
+    });
     return sum_loss;
   }
 
@@ -494,21 +677,21 @@ class network {
       switch (mode) {
         case GRAD_CHECK_ALL:
           for (size_t i = 0; i < w.size(); i++)
-            if (!calc_delta<E>(in, v, w, dw, i, eps)) {
+            if (!calc_delta<E>(in, v, current, w, dw, i, eps)) {
               return false;
             }
           for (size_t i = 0; i < b.size(); i++)
-            if (!calc_delta<E>(in, v, b, db, i, eps)) {
+            if (!calc_delta<E>(in, v, current, b, db, i, eps)) {
               return false;
             }
           break;
         case GRAD_CHECK_RANDOM:
           for (size_t i = 0; i < 10; i++)
-            if (!calc_delta<E>(in, v, w, dw, uniform_idx(w), eps)) {
+            if (!calc_delta<E>(in, v, current, w, dw, uniform_idx(w), eps)) {
               return false;
             }
           for (size_t i = 0; i < 10; i++)
-            if (!calc_delta<E>(in, v, b, db, uniform_idx(b), eps)) {
+            if (!calc_delta<E>(in, v, current, b, db, uniform_idx(b), eps)) {
               return false;
             }
           break;
@@ -648,6 +831,27 @@ class network {
 #endif  // CNN_NO_SERIALIZATION
   }
 
+  /**
+   * save the weights in the memory-mappable format of weights_file.h
+   **/
+  void save_weights_file(const std::string &filename) const {
+    tiny_dnn::save_weights_file(filename, net_.begin(), net_.end());
+  }
+
+  /**
+   * load the weights saved by save_weights_file() without copying them:
+   * the weights of every layer point into the mapped file.
+   * weights_map_mode::read_only saves the private copies of touched pages,
+   * but the network must then be used for inference only: init_weight(),
+   * training or loading other weights would write to read-only memory.
+   **/
+  void load_weights_file(
+    const std::string &filename,
+    weights_map_mode mode = weights_map_mode::copy_on_write) {
+    tiny_dnn::load_weights_file(filename, net_.begin(), net_.end(), mode);
+    net_.setup(false);
+  }
+
   /**
    * save the network architecture as json string
    **/
@@ -868,6 +1072,36 @@ class network {
     return net_.forward(in);
   }
 
+  /**
+   * executes forward-propagation over the whole input, slicing it into
+   * minibatches of at most batch_size samples.
+   * on_batch(offset, out) is called for each minibatch, where out[i] is
+   * the output for in[offset + i].
+   **/
+  template <typename T, typename OnBatch>
+  void fprop_batches(const std::vector<T> &in,
+                     size_t batch_size,
+                     OnBatch on_batch) {
+    if (batch_size == 0) throw nn_error("batch size must be positive");
+
+    std::vector<tensor_t> batch;
+    for (size_t offset = 0; offset < in.size(); offset += batch_size) {
+      const size_t n = std::min(batch_size, in.size() - offset);
+      batch.resize(n);
+      for (size_t i = 0; i < n; i++) {
+        to_input_tensor(in[offset + i], batch[i]);
+      }
+      on_batch(offset, fprop(batch));
+    }
+  }
+
+  void to_input_tensor(const vec_t &in, tensor_t &dst) {
+    if (in.size() != (size_t)in_data_size()) data_mismatch(**net_.begin(), in);
+    dst.assign(1, in);
+  }
+
+  void to_input_tensor(const tensor_t &in, tensor_t &dst) { dst = in; }
+
   //    template <typename E>
   //    float_t get_loss(const vec_t& out, const vec_t& t) {
   //        assert(out.size() == t.size());
@@ -877,6 +1111,7 @@ class network {
   template <typename E>
   bool calc_delta(const std::vector<tensor_t> &in,
                   const std::vector<tensor_t> &v,
+                  layer *l,
                   vec_t &w,
                   tensor_t &dw,
                   int check_index,
@@ -904,31 +1139,70 @@ class network {
 
     float_t f_p    = float_t(0);
     w[check_index] = prev_w + delta;
+    l->mark_weights_changed();
     for (serial_size_t i = 0; i < sample_count; i++) {
       f_p += get_loss<E>(in[i], v[i]);
     }
 
     float_t f_m    = float_t(0);
     w[check_index] = prev_w - delta;
+    l->mark_weights_changed();
     for (serial_size_t i = 0; i < sample_count; i++) {
       f_m += get_loss<E>(in[i], v[i]);
     }
 
     float_t delta_by_numerical = (f_p - f_m) / (float_t(2) * delta);
     w[check_index]             = prev_w;
+    l->mark_weights_changed();
 
     // calculate dw/dE by bprop
     bprop<E>(fprop(in), v, std::vector<tensor_t>());
 
+    // layers may keep fewer gradient copies than samples
     float_t delta_by_bprop = 0;
-    for (serial_size_t sample = 0; sample < sample_count; ++sample) {
-      delta_by_bprop += dw[sample][check_index];
+    for (const vec_t &dw_sample : dw) {
+      delta_by_bprop += dw_sample[check_index];
     }
     net_.clear_grads();
 
     return std::abs(delta_by_bprop - delta_by_numerical) <= eps;
   }
 
+  // let dst run with the weights of src, which are viewed in place
+  static void share_layer(const layer &src, layer &dst) {
+    typedef vec_t::allocator_type allocator;
+
+    std::vector<vec_t> weights;
+    for (const vec_t *w : src.weights()) {
+      // the block doesn't own the memory, src does
+      std::shared_ptr<float_t> block(std::shared_ptr<float_t>(),
+                                     const_cast<float_t *>(w->data()));
+      weights.emplace_back(w->size(), allocator::adopt(block, 0, w->size()));
+    }
+    dst.load_weights(std::move(weights));
+    dst.set_backend_type(src.engine());
+    dst.set_parallelize(src.parallelize());
+
+    // fused epilogues aren't part of the model
+    if (auto conv = dynamic_cast<const convolutional_layer *>(&src)) {
+      if (conv->epilogue()) {
+        dynamic_cast<convolutional_layer &>(dst).fuse_epilogue(
+          conv->epilogue());
+      }
+    } else if (auto fc = dynamic_cast<const fully_connected_layer *>(&src)) {
+      if (fc->epilogue()) {
+        dynamic_cast<fully_connected_layer &>(dst).fuse_epilogue(
+          fc->epilogue());
+      }
+    }
+  }
+
+  void check_context(const execution_context<NetType> &ctx) const {
+    if (ctx.owner_ != this) {
+      throw nn_error("execution context was made by another network");
+    }
+  }
+
   // convenience wrapper for the function below
   template <typename E>
   void bprop(const std::vector<vec_t> &out,
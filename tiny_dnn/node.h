@@ -69,6 +69,8 @@ class node : public std::enable_shared_from_this<node> {
                       layer *tail,
                       serial_size_t head_index,
                       serial_size_t tail_index);
+  friend void bypass(layer *l);
+  friend void splice(layer *l, const edgeptr_t &e, node *tail);
 
   mutable std::vector<edgeptr_t> prev_;
   mutable std::vector<edgeptr_t> next_;
@@ -84,7 +86,8 @@ class edge {
       vtype_(vtype),
       data_({vec_t(shape.size())}),
       grad_({vec_t(shape.size())}),
-      prev_(prev) {}
+      prev_(prev),
+      bound_(false) {}
 
   void merge_grads(vec_t *dst) {
     assert(!grad_.empty());
@@ -110,6 +113,52 @@ class edge {
     }
   }
 
+  /**
+   * store the data of sample_count samples in the shared block, starting
+   * at offset (in elements), and release the gradient. used by the
+   * inference memory planner (nodes::plan_memory).
+   **/
+  void bind_data(const std::shared_ptr<float_t> &block,
+                 size_t offset,
+                 size_t sample_count) {
+    typedef vec_t::allocator_type allocator;
+    const size_t dim    = shape_.size();
+    const size_t stride = batch_stride(dim);
+
+    tensor_t data;
+    data.reserve(sample_count);
+    for (size_t i = 0; i < sample_count; i++) {
+      data.emplace_back(dim, allocator::bind(block, offset + i * stride, dim));
+    }
+    data_.swap(data);
+    tensor_t().swap(grad_);
+    bound_ = true;
+  }
+
+  /**
+   * go back to private data and gradient after bind_data()
+   **/
+  void unbind_data() {
+    if (!bound_) return;
+    data_  = tensor_t{vec_t(shape_.size())};
+    grad_  = tensor_t{vec_t(shape_.size())};
+    bound_ = false;
+  }
+
+  bool is_bound() const { return bound_; }
+
+  /**
+   * release the gradient (of a weight) while it isn't needed
+   **/
+  void release_gradient() { tensor_t().swap(grad_); }
+
+  /**
+   * allocate the gradient again after release_gradient()
+   **/
+  void restore_gradient() {
+    if (grad_.empty()) grad_ = tensor_t{vec_t(shape_.size())};
+  }
+
   tensor_t *get_data() { return &data_; }
 
   const tensor_t *get_data() const { return &data_; }
@@ -125,6 +174,9 @@ class edge {
   const shape3d &shape() const { return shape_; }
   vector_type vtype() const { return vtype_; }
   void add_next_node(node *next) { next_.push_back(next); }
+  void remove_next_node(node *next) {
+    next_.erase(std::remove(next_.begin(), next_.end(), next), next_.end());
+  }
 
  private:
   shape3d shape_;
@@ -133,6 +185,7 @@ class edge {
   tensor_t grad_;
   node *prev_;                // previous node, "producer" of this tensor
   std::vector<node *> next_;  // next nodes, "consumers" of this tensor
+  bool bound_;                // data lives in a block shared with other edges
 };
 
 inline std::vector<node *> node::prev_nodes() const {
@@ -7,17 +7,33 @@
 */
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <numeric>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
 #ifndef CNN_NO_SERIALIZATION
+#include <cereal/archives/json.hpp>
 #include <cereal/types/tuple.hpp>
 #include <cereal/types/utility.hpp>
 #endif
 
+#include "tiny_dnn/activations/activation_layer.h"
+#include "tiny_dnn/layers/batch_normalization_layer.h"
+#include "tiny_dnn/layers/convolutional_layer.h"
+#include "tiny_dnn/layers/dropout_layer.h"
+#include "tiny_dnn/layers/fully_connected_layer.h"
 #include "tiny_dnn/layers/layer.h"
+#include "tiny_dnn/layers/reorder_layer.h"
 #include "tiny_dnn/optimizers/optimizer.h"
+#include "tiny_dnn/util/profiler.h"
+#include "tiny_dnn/util/tracer.h"
 #include "tiny_dnn/util/util.h"
 
 namespace cereal {
@@ -52,6 +68,89 @@ void load(Archive &ar, std::vector<std::shared_ptr<tiny_dnn::layer>> &v) {
 
 namespace tiny_dnn {
 
+#ifndef CNN_NO_SERIALIZATION
+namespace detail {
+
+// version of the models written by nodes::save_model. binary models of
+// version 0 were written before it was recorded, and their convolutional
+// layers have no "groups".
+const std::uint32_t model_format_version = 1;
+
+// precedes the version in binary models. the models of version 0 start
+// with their number of layers instead, which is never that large.
+const std::uint64_t model_format_magic = 0x6c65646f6d6e6e64ULL;
+
+// version of the model the current thread is loading, see load_if_present
+inline std::uint32_t &loading_model_format() {
+  static thread_local std::uint32_t version = model_format_version;
+  return version;
+}
+
+class loading_model_format_scope {
+ public:
+  explicit loading_model_format_scope(std::uint32_t version)
+    : prev_(loading_model_format()) {
+    loading_model_format() = version;
+  }
+  ~loading_model_format_scope() { loading_model_format() = prev_; }
+
+ private:
+  std::uint32_t prev_;
+};
+
+template <class Archive>
+void save_model_format(Archive &oa) {
+  oa(cereal::make_nvp("format", model_format_magic),
+     cereal::make_nvp("format_version", model_format_version));
+}
+
+inline void save_model_format(cereal::JSONOutputArchive &oa) {
+  oa(cereal::make_nvp("format_version", model_format_version));
+}
+
+inline void check_model_format(std::uint32_t version) {
+  if (version > model_format_version) {
+    throw nn_error("model format " + to_string(version) +
+                   " is newer than this library supports");
+  }
+}
+
+// load the layers written by nodes::save_model in any format version
+template <class Archive>
+void load_model_layers(Archive &ia,
+                       std::vector<std::shared_ptr<layer>> &layers) {
+  std::uint64_t head;
+  ia(cereal::make_nvp("format", head));
+  if (head == model_format_magic) {
+    std::uint32_t version;
+    ia(cereal::make_nvp("format_version", version));
+    check_model_format(version);
+    loading_model_format_scope scope(version);
+    ia(cereal::make_nvp("nodes", layers));
+  } else {
+    // version 0: head is the size of "nodes"
+    loading_model_format_scope scope(0);
+    for (std::uint64_t i = 0; i < head; i++) {
+      layers.emplace_back(layer::load_layer(ia));
+    }
+  }
+}
+
+inline void load_model_layers(cereal::JSONInputArchive &ia,
+                              std::vector<std::shared_ptr<layer>> &layers) {
+  std::uint32_t version = 0;
+  const char *next      = ia.getNodeName();
+  if (next != nullptr && std::strcmp(next, "format_version") == 0) {
+    ia(cereal::make_nvp("format_version", version));
+    check_model_format(version);
+  }
+  loading_model_format_scope scope(version);
+  ia(cereal::make_nvp("nodes", layers));
+}
+
+}  // namespace detail
+#endif  // CNN_NO_SERIALIZATION
+
 /** basic class of various network types (sequential, multi-in/multi-out).
  *
  * this class holds list of pointer of Node, and provides entry point of
@@ -100,7 +199,8 @@ class nodes {
    **/
   virtual void update_weights(optimizer *opt, int batch_size) {
     for (auto l : nodes_) {
-      l->update_weight(opt, batch_size);
+      run_layer(l, profile_phase::update,
+                [&] { l->update_weight(opt, batch_size); });
     }
   }
 
@@ -119,6 +219,142 @@ class nodes {
     }
   }
 
+  /**
+   * enable/disable the inference memory planner, see plan_memory()
+   **/
+  void set_memory_planning(bool enable) {
+    memory_planning_ = enable;
+    if (!enable) release_memory_plan();
+  }
+
+  bool memory_planning() const { return memory_planning_; }
+
+  void set_phase(net_phase phase) { phase_ = phase; }
+
+  /**
+   * record the calls of the layers in p, nullptr to stop
+   **/
+  void set_profiler(profiler *p) { profiler_ = p; }
+
+  /**
+   * size in bytes of the buffer shared by the planned activations,
+   * 0 if there is no plan
+   **/
+  size_t planned_memory_size() const {
+    return planned_samples_ > 0 ? planned_elements_ * sizeof(float_t) : 0;
+  }
+
+  /**
+   * inference-time rewrite, see network::optimize_for_inference()
+   **/
+  void optimize_for_inference() {
+    release_memory_plan();
+    setup(false);  // weights must be initialized before anything is folded
+
+    // dropout is the identity in the test phase
+    for (auto l : std::vector<layer *>(nodes_)) {
+      if (dynamic_cast<dropout_layer *>(l) && l->prev()[0] &&
+          l->prev()[0]->prev()) {
+        remove_layer(l);
+      }
+    }
+
+    // conv/fc [-> batch norm]* [-> activation]
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      layer *l = nodes_[i];
+      if (!dynamic_cast<convolutional_layer *>(l) &&
+          !dynamic_cast<fully_connected_layer *>(l)) {
+        continue;
+      }
+      while (layer *next = single_consumer(l)) {
+        if (auto bn = dynamic_cast<batch_normalization_layer *>(next)) {
+          if (!fold_batch_norm(l, *bn)) break;
+          remove_layer(next);
+        } else if (auto act = dynamic_cast<activation_layer *>(next)) {
+          if (fuse_activation(l, act)) remove_layer(next);
+          break;
+        } else {
+          break;
+        }
+      }
+    }
+  }
+
+  /**
+   * run the layers which support it in the channel block `block` (see
+   * blocked_index), see network::set_channel_block(). layers which don't
+   * depend on the layout (elementwise activations) keep the layout of their
+   * input. a reorder_layer is inserted wherever a layer reads an edge in
+   * another layout than it was written in, including the inputs and the
+   * outputs of the network, which stay planar. block 1 removes them.
+   **/
+  void set_channel_block(serial_size_t block) {
+    if (block == 0) throw nn_error("channel block must be positive");
+    release_memory_plan();
+    setup(false);
+
+    remove_reorders();
+    for (auto l : nodes_) l->set_channel_block(1);
+    if (block == 1) return;
+
+    // layout of each edge, edges which aren't in the map are planar
+    std::unordered_map<const edge *, serial_size_t> layout;
+    auto layout_of = [&](const edgeptr_t &e) {
+      auto it = layout.find(e.get());
+      return it == layout.end() ? serial_size_t(1) : it->second;
+    };
+    // reorders already inserted for (edge, block), shared by the consumers
+    std::map<std::pair<const edge *, serial_size_t>, layer *> reorders;
+
+    for (auto l : std::vector<layer *>(nodes_)) {
+      std::vector<serial_size_t> inputs;
+      for (serial_size_t i = 0; i < l->prev().size(); i++) {
+        if (l->prev()[i] && l->prev()[i]->vtype() == vector_type::data) {
+          inputs.push_back(i);
+        }
+      }
+
+      serial_size_t want = 1;
+      if (inputs.size() == 1) {
+        if (l->is_layout_agnostic()) {
+          want = layout_of(l->prev()[inputs[0]]);
+        } else if (l->set_channel_block(block)) {
+          want = block;
+        }
+      }
+
+      for (serial_size_t i : inputs) {
+        const edgeptr_t e       = l->prev()[i];
+        const serial_size_t has = layout_of(e);
+        if (same_blocked_layout(e->shape(), has, want)) continue;
+
+        layer *&r = reorders[std::make_pair(e.get(), want)];
+        if (!r) {
+          r = add_reorder(e->shape(), has, want);
+          nodes_.insert(std::find(nodes_.begin(), nodes_.end(), l), r);
+        }
+        splice(r, e, l);
+        // the input of the network is read by the reorder instead
+        if (!e->prev()) boundary_replaced(l, r, true);
+      }
+      for (auto &e : l->next()) {
+        if (e) layout[e.get()] = want;
+      }
+    }
+
+    for (auto l : std::vector<layer *>(nodes_)) {
+      if (!is_output(l) || !l->next()[0]) continue;
+      const edgeptr_t e = l->next()[0];
+      if (same_blocked_layout(e->shape(), layout_of(e), 1)) continue;
+
+      layer *r = add_reorder(e->shape(), layout_of(e), 1);
+      nodes_.insert(std::find(nodes_.begin(), nodes_.end(), l) + 1, r);
+      splice(r, e, nullptr);
+      boundary_replaced(l, r, false);
+    }
+    graph_changed();
+  }
+
   size_t size() const { return nodes_.size(); }
   iterator begin() { return nodes_.begin(); }
   iterator end() { return nodes_.end(); }
@@ -215,6 +451,267 @@ class nodes {
   }
 
  protected:
+  // call f, which runs phase of l, through the profiler and the tracer
+  template <typename F>
+  void run_layer(layer *l, profile_phase phase, F f) {
+    if (tracer::instance().enabled()) {
+      const std::string name = l->layer_type();
+      trace_scope trace(to_string(phase), name.c_str());
+      run_profiled(l, phase, f);
+    } else {
+      run_profiled(l, phase, f);
+    }
+  }
+
+  template <typename F>
+  void run_profiled(layer *l, profile_phase phase, F f) {
+    if (profiler_) {
+      profiler_->measure(*l, phase, f);
+    } else {
+      f();
+    }
+  }
+
+  void forward_layer(layer *l) {
+    run_layer(l, profile_phase::forward, [l] { l->forward(); });
+  }
+
+  void backward_layer(layer *l) {
+    run_layer(l, profile_phase::backward, [l] { l->backward(); });
+  }
+
+  /**
+   * called at the beginning of forward(). (re)plans the memory for
+   * sample_count samples when the planner is enabled outside of training,
+   * and releases the plan otherwise.
+   **/
+  void prepare_memory(size_t sample_count) {
+    if (memory_planning_ && phase_ != net_phase::train) {
+      if (planned_samples_ != sample_count) plan_memory(sample_count);
+    } else {
+      release_memory_plan();
+    }
+  }
+
+  virtual bool is_output(const layer *l) const { return l == nodes_.back(); }
+
+  // called after remove_layer() took removed out of the network. the
+  // consumers of its output now read the output of producer.
+  virtual void layer_removed(layer *removed, layer *producer) {
+    CNN_UNREFERENCED_PARAMETER(removed);
+    CNN_UNREFERENCED_PARAMETER(producer);
+  }
+
+  // called when the input (output) layer from of the network is replaced by
+  // to
+  virtual void boundary_replaced(layer *from, layer *to, bool input) {
+    CNN_UNREFERENCED_PARAMETER(from);
+    CNN_UNREFERENCED_PARAMETER(to);
+    CNN_UNREFERENCED_PARAMETER(input);
+  }
+
+  // called after layers were added to or removed from nodes_
+  virtual void graph_changed() {}
+
+  layer *add_reorder(const shape3d &shape,
+                     serial_size_t in_block,
+                     serial_size_t out_block) {
+    own_nodes_.push_back(
+      std::make_shared<reorder_layer>(shape, in_block, out_block));
+    reorders_.push_back(own_nodes_.back().get());
+    return reorders_.back();
+  }
+
+  // take out the layers inserted by set_channel_block()
+  void remove_reorders() {
+    for (auto r : reorders_) {
+      const edgeptr_t in = r->prev()[0];
+      if (!in->prev()) {
+        // a reorder reading an input of the network reads it for one layer
+        layer *consumer = dynamic_cast<layer *>(r->next()[0]->next()[0]);
+        remove_layer(r);
+        boundary_replaced(r, consumer, true);
+      } else {
+        remove_layer(r);
+      }
+      own_nodes_.erase(std::find_if(
+        own_nodes_.begin(), own_nodes_.end(),
+        [r](const std::shared_ptr<layer> &p) { return p.get() == r; }));
+    }
+    reorders_.clear();
+    graph_changed();
+  }
+
+  void remove_layer(layer *l) {
+    layer *producer = dynamic_cast<layer *>(l->prev()[0]->prev());
+    bypass(l);
+    nodes_.erase(std::find(nodes_.begin(), nodes_.end(), l));
+    layer_removed(l, producer);
+  }
+
+  // the only layer reading the output of l, if any
+  layer *single_consumer(const layer *l) const {
+    if (l->next().size() != 1 || !l->next()[0] || is_output(l)) {
+      return nullptr;
+    }
+    const auto &consumers = l->next()[0]->next();
+    if (consumers.size() != 1 || consumers[0]->prev().size() != 1) {
+      return nullptr;
+    }
+    return dynamic_cast<layer *>(consumers[0]);
+  }
+
+  // fold the test-phase normalization of bn into the weights and bias of l
+  bool fold_batch_norm(layer *l, const batch_normalization_layer &bn) {
+    auto conv = dynamic_cast<convolutional_layer *>(l);
+    auto fc   = dynamic_cast<fully_connected_layer *>(l);
+
+    // outputs of l scaled by the same factor: a channel of the convolution,
+    // a single neuron of the fully connected layer
+    const shape3d out     = l->out_shape()[0];
+    const size_t channels = conv ? out.depth_ : out.size();
+    const size_t unit     = out.size() / channels;
+    const shape3d in      = bn.in_shape()[0];  // (spatial size, 1, channels)
+    if (in.size() != out.size()) return false;
+
+    vec_t scale(channels), shift(channels);
+    for (size_t o = 0; o < channels; o++) {
+      const size_t c = o * unit / in.width_;
+      if (c != ((o + 1) * unit - 1) / in.width_) return false;
+      scale[o] = float_t(1) / std::sqrt(bn.variance()[c] + bn.epsilon());
+      shift[o] = -bn.mean()[c] * scale[o];
+    }
+    return conv ? conv->fold_scale_shift(scale, shift)
+                : fc->fold_scale_shift(scale, shift);
+  }
+
+  // apply act in the epilogue of the kernel of l
+  bool fuse_activation(layer *l, activation_layer *act) {
+    auto f = [act](vec_t &y) { act->forward_activation(y, y); };
+    if (auto conv = dynamic_cast<convolutional_layer *>(l)) {
+      return conv->fuse_epilogue(f);
+    }
+    return dynamic_cast<fully_connected_layer *>(l)->fuse_epilogue(f);
+  }
+
+  void check_backward() const {
+    if (planned_samples_ > 0) {
+      throw nn_error("backward is not available with the memory planner");
+    }
+    if (!reorders_.empty()) {
+      throw nn_error("backward is not available with a channel-blocked layout");
+    }
+  }
+
+  /**
+   * share the activation buffers between layers.
+   *
+   * nodes_ is in execution order, so the data edge produced by the i-th
+   * layer is alive from step i until the last step which reads it (input
+   * edges of the network from the start, outputs of the network until
+   * the end). edges whose lifetimes don't overlap are assigned to the same
+   * slot of one shared buffer, like registers: every edge reuses the
+   * smallest free slot that fits, or grows the largest one. gradients are
+   * never read during inference, so they are released.
+   **/
+  void plan_memory(size_t sample_count) {
+    release_memory_plan();
+
+    struct live_range {
+      edge *e;
+      size_t begin, end, size;
+    };
+    struct slot {
+      size_t end, size, offset;
+    };
+
+    std::unordered_map<const node *, size_t> step;
+    for (size_t i = 0; i < nodes_.size(); i++) step[nodes_[i]] = i + 1;
+    const size_t last = nodes_.size() + 1;
+
+    std::vector<live_range> ranges;
+    std::vector<edge *> weights;
+    std::unordered_map<const edge *, bool> seen;
+    auto add_edge = [&](const edgeptr_t &e) {
+      if (!e || seen[e.get()]) return;
+      seen[e.get()] = true;
+      if (e->vtype() != vector_type::data) {
+        weights.push_back(e.get());
+        return;
+      }
+      live_range r;
+      r.e     = e.get();
+      r.begin = e->prev() ? step[e->prev()] : 0;
+      r.end   = e->next().empty() ? last : 0;
+      for (auto n : e->next()) r.end = std::max(r.end, step[n]);
+      r.size = sample_count * batch_stride(e->shape().size());
+      ranges.push_back(r);
+    };
+    for (auto l : nodes_) {
+      for (auto &e : l->inputs()) add_edge(e);
+      for (auto &e : l->outputs()) add_edge(e);
+    }
+
+    std::vector<slot> slots;
+    std::vector<size_t> assigned(ranges.size());
+    std::vector<size_t> order(ranges.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return ranges[a].begin < ranges[b].begin;
+    });
+
+    for (size_t i : order) {
+      const live_range &r = ranges[i];
+      size_t best         = slots.size();
+      for (size_t s = 0; s < slots.size(); s++) {
+        if (slots[s].end >= r.begin) continue;  // still in use
+        if (best == slots.size()) {
+          best = s;
+          continue;
+        }
+        // prefer the smallest slot that fits, else the largest one
+        const bool fits      = slots[s].size >= r.size;
+        const bool best_fits = slots[best].size >= r.size;
+        if (fits ? (!best_fits || slots[s].size < slots[best].size)
+                 : (!best_fits && slots[s].size > slots[best].size)) {
+          best = s;
+        }
+      }
+      if (best == slots.size()) slots.push_back({0, 0, 0});
+      slots[best].end  = r.end;
+      slots[best].size = std::max(slots[best].size, r.size);
+      assigned[i]      = best;
+    }
+
+    size_t total = 0;
+    for (auto &s : slots) {
+      s.offset = total;
+      total += s.size;
+    }
+
+    auto block = vec_t::allocator_type::make_block(total);
+    for (size_t i = 0; i < ranges.size(); i++) {
+      ranges[i].e->bind_data(block, slots[assigned[i]].offset, sample_count);
+    }
+    for (auto w : weights) w->release_gradient();
+
+    planned_edges_.clear();
+    for (auto &r : ranges) planned_edges_.push_back(r.e);
+    planned_weights_  = weights;
+    planned_samples_  = sample_count;
+    planned_elements_ = total;
+  }
+
+  void release_memory_plan() {
+    if (planned_samples_ == 0) return;
+    for (auto e : planned_edges_) e->unbind_data();
+    for (auto w : planned_weights_) w->restore_gradient();
+    planned_edges_.clear();
+    planned_weights_.clear();
+    planned_samples_  = 0;
+    planned_elements_ = 0;
+  }
+
   template <typename T>
   void push_back(T &&node) {
     push_back_impl(
@@ -267,6 +764,18 @@ class nodes {
   std::vector<std::shared_ptr<layer>> own_nodes_;
   /* List of all nodes which includes own_nodes */
   std::vector<layer *> nodes_;
+  /* layers inserted by set_channel_block(), owned by own_nodes_ */
+  std::vector<layer *> reorders_;
+
+  /* inference memory planner, see plan_memory() */
+  bool memory_planning_ = false;
+  net_phase phase_      = net_phase::test;
+  std::vector<edge *> planned_edges_;
+  std::vector<edge *> planned_weights_;
+  size_t planned_samples_  = 0;
+  size_t planned_elements_ = 0;
+
+  profiler *profiler_ = nullptr;
 };
 
 /**
@@ -279,10 +788,11 @@ class sequential : public nodes {
     reorder_for_layerwise_processing(first, reordered_grad);
     assert(reordered_grad.size() == 1);
 
+    check_backward();
     nodes_.back()->set_out_grads(&reordered_grad[0], 1);
 
     for (auto l = nodes_.rbegin(); l != nodes_.rend(); l++) {
-      (*l)->backward();
+      backward_layer(*l);
     }
   }
 
@@ -291,10 +801,11 @@ class sequential : public nodes {
     reorder_for_layerwise_processing(first, reordered_data);
     assert(reordered_data.size() == 1);
 
+    prepare_memory(reordered_data[0].size());
     nodes_.front()->set_in_data(&reordered_data[0], 1);
 
     for (auto l : nodes_) {
-      l->forward();
+      forward_layer(l);
     }
 
     std::vector<const tensor_t *> out;
@@ -377,13 +888,13 @@ class graph : public nodes {
     reorder_for_layerwise_processing(out_grad, reordered_grad);
     assert(reordered_grad.size() == output_channel_count);
 
+    check_backward();
     for (size_t i = 0; i < output_channel_count; i++) {
       output_layers_[i]->set_out_grads(&reordered_grad[i], 1);
     }
 
-    for (auto l = nodes_.rbegin(); l != nodes_.rend(); l++) {
-      (*l)->backward();
-    }
+    build_schedule();
+    run_schedule(bwd_schedule_, [this](layer *l) { backward_layer(l); });
   }
 
   std::vector<tensor_t> forward(const std::vector<tensor_t> &in_data) override {
@@ -397,15 +908,15 @@ class graph : public nodes {
     reorder_for_layerwise_processing(in_data, reordered_data);
     assert(reordered_data.size() == input_data_channel_count);
 
+    prepare_memory(reordered_data[0].size());
     for (size_t channel_index = 0; channel_index < input_data_channel_count;
          channel_index++) {
       input_layers_[channel_index]->set_in_data(&reordered_data[channel_index],
                                                 1);
     }
 
-    for (auto l : nodes_) {
-      l->forward();
-    }
+    build_schedule();
+    run_schedule(fwd_schedule_, [this](layer *l) { forward_layer(l); });
     return merge_outs();
   }
 
@@ -571,19 +1082,137 @@ class graph : public nodes {
     return merged;
   }
 
+  bool is_output(const layer *l) const override {
+    return std::find(output_layers_.begin(), output_layers_.end(), l) !=
+           output_layers_.end();
+  }
+
+  void layer_removed(layer *removed, layer *producer) override {
+    std::replace(output_layers_.begin(), output_layers_.end(), removed,
+                 producer);
+    graph_changed();
+  }
+
+  void boundary_replaced(layer *from, layer *to, bool input) override {
+    auto &layers = input ? input_layers_ : output_layers_;
+    std::replace(layers.begin(), layers.end(), from, to);
+  }
+
+  void graph_changed() override {
+    fwd_schedule_.reset(0);
+    bwd_schedule_.reset(0);
+  }
+
   serial_size_t find_index(const std::vector<node *> &nodes, layer *target) {
     for (serial_size_t i = 0; i < nodes.size(); i++) {
       if (nodes[i] == static_cast<node *>(&*target)) return i;
     }
     throw nn_error("invalid connection");
   }
+
+  /**
+   * dependencies between the layers (indices into nodes_): a layer can run
+   * once count[i] of its dependencies are done, and then releases next[i].
+   **/
+  struct schedule {
+    std::vector<std::vector<size_t>> next;
+    std::vector<size_t> count;
+
+    void reset(size_t n) {
+      next.assign(n, std::vector<size_t>());
+      count.assign(n, 0);
+    }
+
+    void add(size_t before, size_t after) {
+      next[before].push_back(after);
+      count[after]++;
+    }
+  };
+
+  void build_schedule() {
+    if (fwd_schedule_.count.size() == nodes_.size()) return;
+
+    std::unordered_map<const node *, size_t> index;
+    for (size_t i = 0; i < nodes_.size(); i++) index[nodes_[i]] = i;
+
+    fwd_schedule_.reset(nodes_.size());
+    bwd_schedule_.reset(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      for (auto &e : nodes_[i]->next()) {
+        if (!e) continue;
+        std::vector<size_t> consumers;
+        for (auto n : e->next()) consumers.push_back(index.at(n));
+        std::sort(consumers.begin(), consumers.end());
+
+        for (size_t c : consumers) {
+          fwd_schedule_.add(i, c);
+          bwd_schedule_.add(c, i);
+        }
+        // all consumers write to the gradient of e. keep the order of
+        // sequential backward between them.
+        for (size_t k = 1; k < consumers.size(); k++) {
+          bwd_schedule_.add(consumers[k], consumers[k - 1]);
+        }
+      }
+    }
+  }
+
+  /**
+   * call f for every layer in an order allowed by s. layers which don't
+   * depend on each other (e.g. parallel branches) run concurrently: the
+   * layer finishing last among the dependencies of another one runs it, and
+   * several layers becoming ready at once are forked onto the thread pool.
+   * the memory planner assumes sequential execution, so layers run one
+   * after the other in nodes_ order while a plan is active.
+   **/
+  template <typename Func>
+  void run_schedule(const schedule &s, Func f) {
+    const size_t n = nodes_.size();
+    if (num_threads() <= 1 || planned_samples_ > 0) {
+      if (&s == &bwd_schedule_) {
+        for (size_t i = n; i-- > 0;) f(nodes_[i]);
+      } else {
+        for (size_t i = 0; i < n; i++) f(nodes_[i]);
+      }
+      return;
+    }
+
+    std::unique_ptr<std::atomic<size_t>[]> remaining(
+      new std::atomic<size_t>[n]);
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < n; i++) {
+      remaining[i] = s.count[i];
+      if (s.count[i] == 0) ready.push_back(i);
+    }
+
+    std::function<void(std::vector<size_t>)> run = [&](
+      std::vector<size_t> layers) {
+      // follow chains in this task, fork when a layer releases several
+      while (layers.size() == 1) {
+        const size_t i = layers[0];
+        f(nodes_[i]);
+        layers.clear();
+        for (size_t j : s.next[i]) {
+          if (--remaining[j] == 0) layers.push_back(j);
+        }
+      }
+      if (layers.empty()) return;
+      for_i(true, layers.size(),
+            [&](size_t k) { run(std::vector<size_t>{layers[k]}); }, 1);
+    };
+    run(ready);
+  }
+
   std::vector<layer *> input_layers_;
   std::vector<layer *> output_layers_;
+  schedule fwd_schedule_;
+  schedule bwd_schedule_;
 };
 
 template <typename OutputArchive>
 void nodes::save_model(OutputArchive &oa) const {
 #ifndef CNN_NO_SERIALIZATION
+  detail::save_model_format(oa);
   oa(cereal::make_nvp("nodes", nodes_));
 
   if (typeid(*this) == typeid(sequential)) {
@@ -602,7 +1231,7 @@ void nodes::load_model(InputArchive &ia) {
   own_nodes_.clear();
   nodes_.clear();
 
-  ia(cereal::make_nvp("nodes", own_nodes_));
+  detail::load_model_layers(ia, own_nodes_);
 
   for (auto &n : own_nodes_) {
     nodes_.push_back(&*n);
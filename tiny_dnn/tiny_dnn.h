@@ -8,6 +8,7 @@
 #pragma once
 
 #include "tiny_dnn/config.h"
+#include "tiny_dnn/batch_executor.h"
 #include "tiny_dnn/network.h"
 #include "tiny_dnn/nodes.h"
 
@@ -35,6 +36,7 @@
 #include "tiny_dnn/layers/quantized_convolutional_layer.h"
 #include "tiny_dnn/layers/quantized_deconvolutional_layer.h"
 #include "tiny_dnn/layers/recurrent_cell_layer.h"
+#include "tiny_dnn/layers/reorder_layer.h"
 #include "tiny_dnn/layers/slice_layer.h"
 
 #include "tiny_dnn/activations/elu_layer.h"
@@ -58,6 +60,8 @@
 #include "tiny_dnn/util/deform.h"
 #include "tiny_dnn/util/graph_visualizer.h"
 #include "tiny_dnn/util/product.h"
+#include "tiny_dnn/util/profiler.h"
+#include "tiny_dnn/util/tracer.h"
 #include "tiny_dnn/util/weight_init.h"
 
 #include "tiny_dnn/io/cifar10_parser.h"
@@ -153,6 +157,10 @@ using softsign = tiny_dnn::softsign_layer;
 }  // namespace activation
 
 #include "tiny_dnn/models/alexnet.h"
+#include "tiny_dnn/models/lenet.h"
+#include "tiny_dnn/models/mobilenet.h"
+#include "tiny_dnn/models/resnet.h"
+#include "tiny_dnn/models/vgg.h"
 
 using batch_norm = tiny_dnn::batch_normalization_layer;
 
@@ -13,10 +13,72 @@
 #ifdef __MINGW32__
 #include <mm_malloc.h>
 #endif
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include "nn_error.h"
 
 namespace tiny_dnn {
 
+/**
+ * number of heap allocations made by aligned_allocator so far (slices of
+ * shared blocks are not counted), see profiler
+ **/
+inline std::atomic<uint64_t> &aligned_heap_allocations() {
+  static std::atomic<uint64_t> count(0);
+  return count;
+}
+
+/**
+ * bytes of heap memory held by aligned_allocator (including the blocks of
+ * make_block()), now and at most since the last reset_peak()
+ **/
+class aligned_heap_usage {
+ public:
+  static aligned_heap_usage &instance() {
+    static aligned_heap_usage usage;
+    return usage;
+  }
+
+  uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+  uint64_t peak_bytes() const { return peak_.load(std::memory_order_relaxed); }
+
+  /** start a new peak from the current usage */
+  void reset_peak() { peak_.store(bytes(), std::memory_order_relaxed); }
+
+  void allocated(uint64_t n) {
+    const uint64_t now = bytes_.fetch_add(n, std::memory_order_relaxed) + n;
+    uint64_t peak      = peak_.load(std::memory_order_relaxed);
+    while (now > peak &&
+           !peak_.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+  }
+
+  void released(uint64_t n) { bytes_.fetch_sub(n, std::memory_order_relaxed); }
+
+ private:
+  aligned_heap_usage() : bytes_(0), peak_(0) {}
+
+  std::atomic<uint64_t> bytes_;
+  std::atomic<uint64_t> peak_;
+};
+
+/**
+ * allocator returning memory aligned to the given boundary.
+ *
+ * a default-constructed allocator goes to the heap for every request.
+ * an allocator bound to a slice of a shared block (see bind()) hands out
+ * that slice instead, as long as the request fits in it and the slice is not
+ * already in use; this lets several containers live side by side in one
+ * contiguous buffer. containers that outgrow their slice, or reallocate while
+ * their elements still occupy it, transparently move to the heap. copies of
+ * a container always go to the heap, so only one container ever owns a
+ * given slice.
+ * an allocator made by adopt() serves a slice which already holds valid
+ * elements (e.g. a memory-mapped file), and leaves them untouched when the
+ * container default-constructs its elements.
+ **/
 template <typename T, std::size_t alignment>
 class aligned_allocator {
  public:
@@ -33,10 +95,99 @@ class aligned_allocator {
     typedef aligned_allocator<U, alignment> other;
   };
 
-  aligned_allocator() {}
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  aligned_allocator()
+    : slice_(nullptr), slice_size_(0), slice_used_(false), adopted_(false) {}
 
   template <typename U>
-  aligned_allocator(const aligned_allocator<U, alignment> &) {}
+  aligned_allocator(const aligned_allocator<U, alignment> &)
+    : slice_(nullptr), slice_size_(0), slice_used_(false), adopted_(false) {}
+
+  aligned_allocator(const aligned_allocator &) = default;
+  aligned_allocator &operator=(const aligned_allocator &) = default;
+
+  // the moved-from allocator goes back to the heap, so that the slice is
+  // never handed out twice
+  aligned_allocator(aligned_allocator &&other) noexcept
+    : block_(std::move(other.block_)),
+      slice_(other.slice_),
+      slice_size_(other.slice_size_),
+      slice_used_(other.slice_used_),
+      adopted_(other.adopted_) {
+    other.slice_      = nullptr;
+    other.slice_size_ = 0;
+    other.slice_used_ = false;
+    other.adopted_    = false;
+  }
+
+  aligned_allocator &operator=(aligned_allocator &&other) noexcept {
+    block_            = std::move(other.block_);
+    slice_            = other.slice_;
+    slice_size_       = other.slice_size_;
+    slice_used_       = other.slice_used_;
+    adopted_          = other.adopted_;
+    other.slice_      = nullptr;
+    other.slice_size_ = 0;
+    other.slice_used_ = false;
+    other.adopted_    = false;
+    return *this;
+  }
+
+  /**
+   * allocate an aligned block of size elements, released when the last
+   * allocator bound to it is gone.
+   **/
+  static std::shared_ptr<T> make_block(size_type size) {
+    const size_type bytes = sizeof(T) * size;
+    pointer p = static_cast<pointer>(aligned_alloc(alignment, bytes));
+    if (!p && size > 0) throw nn_error("failed to allocate");
+    aligned_heap_usage::instance().allocated(bytes);
+    return std::shared_ptr<T>(p, [bytes](pointer ptr) {
+      aligned_heap_usage::instance().released(bytes);
+      aligned_free(ptr);
+    });
+  }
+
+  /**
+   * allocator serving [offset, offset + size) of block
+   **/
+  static aligned_allocator bind(const std::shared_ptr<T> &block,
+                                size_type offset,
+                                size_type size) {
+    aligned_allocator a;
+    a.block_      = block;
+    a.slice_      = block.get() + offset;
+    a.slice_size_ = size;
+    return a;
+  }
+
+  /**
+   * same as bind(), but the slice already holds size valid elements.
+   * vec_t(size, adopt(block, offset, size)) views them without writing
+   * to the block.
+   **/
+  static aligned_allocator adopt(const std::shared_ptr<T> &block,
+                                 size_type offset,
+                                 size_type size) {
+    aligned_allocator a = bind(block, offset, size);
+    a.adopted_          = true;
+    return a;
+  }
+
+  aligned_allocator select_on_container_copy_construction() const {
+    return aligned_allocator();
+  }
+
+  bool operator==(const aligned_allocator &rhs) const {
+    return slice_ == rhs.slice_;
+  }
+
+  bool operator!=(const aligned_allocator &rhs) const {
+    return !(*this == rhs);
+  }
 
   const_pointer address(const_reference value) const {
     return std::addressof(value);
@@ -45,8 +196,16 @@ class aligned_allocator {
   pointer address(reference value) const { return std::addressof(value); }
 
   pointer allocate(size_type size, const void * = nullptr) {
+    // a reallocating insert allocates the new storage before it releases
+    // the old one, so the slice may still be occupied here
+    if (slice_ && !slice_used_ && size <= slice_size_) {
+      slice_used_ = true;
+      return slice_;
+    }
+    aligned_heap_allocations().fetch_add(1, std::memory_order_relaxed);
     void *p = aligned_alloc(alignment, sizeof(T) * size);
     if (!p && size > 0) throw nn_error("failed to allocate");
+    aligned_heap_usage::instance().allocated(sizeof(T) * size);
     return static_cast<pointer>(p);
   }
 
@@ -54,7 +213,14 @@ class aligned_allocator {
     return ~static_cast<std::size_t>(0) / sizeof(T);
   }
 
-  void deallocate(pointer ptr, size_type) { aligned_free(ptr); }
+  void deallocate(pointer ptr, size_type size) {
+    if (ptr == slice_) {
+      slice_used_ = false;
+      return;
+    }
+    aligned_heap_usage::instance().released(sizeof(T) * size);
+    aligned_free(ptr);
+  }
 
   template <class U, class V>
   void construct(U *ptr, const V &value) {
@@ -71,7 +237,12 @@ class aligned_allocator {
   template <class U>
   void construct(U *ptr) {
     void *p = ptr;
-    ::new (p) U();
+    if (adopted_ && p >= static_cast<void *>(slice_) &&
+        p < static_cast<void *>(slice_ + slice_size_)) {
+      ::new (p) U;  // keep the adopted value
+    } else {
+      ::new (p) U();
+    }
   }
 
   template <class U>
@@ -80,7 +251,7 @@ class aligned_allocator {
   }
 
  private:
-  void *aligned_alloc(size_type align, size_type size) const {
+  static void *aligned_alloc(size_type align, size_type size) {
 #if defined(_MSC_VER)
     return ::_aligned_malloc(size, align);
 #elif defined(__ANDROID__)
@@ -96,7 +267,7 @@ class aligned_allocator {
 #endif
   }
 
-  void aligned_free(pointer ptr) {
+  static void aligned_free(pointer ptr) {
 #if defined(_MSC_VER)
     ::_aligned_free(ptr);
 #elif defined(__MINGW32__)
@@ -105,18 +276,12 @@ class aligned_allocator {
     ::free(ptr);
 #endif
   }
-};
-
-template <typename T1, typename T2, std::size_t alignment>
-inline bool operator==(const aligned_allocator<T1, alignment> &,
-                       const aligned_allocator<T2, alignment> &) {
-  return true;
-}
 
-template <typename T1, typename T2, std::size_t alignment>
-inline bool operator!=(const aligned_allocator<T1, alignment> &,
-                       const aligned_allocator<T2, alignment> &) {
-  return false;
-}
+  std::shared_ptr<T> block_;
+  pointer slice_;
+  size_type slice_size_;
+  bool slice_used_;
+  bool adopted_;
+};
 
 }  // namespace tiny_dnn
@@ -7,10 +7,12 @@
 */
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <limits>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -27,8 +29,8 @@
 #endif
 
 #if !defined(CNN_USE_OMP) && !defined(CNN_SINGLE_THREAD)
-#include <future>
-#include <thread>
+#include "thread_pool.h"
+#include "tracer.h"
 #endif
 
 #if defined(CNN_USE_GCD) && !defined(CNN_SINGLE_THREAD)
@@ -130,40 +132,44 @@ void parallel_for(size_t begin,
 #else
 
 template <typename Func>
-void parallel_for(size_t begin,
-                  size_t end,
-                  const Func &f,
-                  size_t /*grainsize*/) {
+void parallel_for(size_t begin, size_t end, const Func &f, size_t grainsize) {
   assert(end >= begin);
-  size_t nthreads  = std::thread::hardware_concurrency();
-  size_t blockSize = (end - begin) / nthreads;
-  if (blockSize * nthreads < end - begin) blockSize++;
-
-  std::vector<std::future<void> > futures;
-
-  size_t blockBegin            = begin;
-  size_t blockEnd              = blockBegin + blockSize;
-  if (blockEnd > end) blockEnd = end;
-
-  for (size_t i = 0; i < nthreads; i++) {
-    futures.push_back(
-      std::move(std::async(std::launch::async, [blockBegin, blockEnd, &f] {
-        f(blocked_range(blockBegin, blockEnd));
-      })));
-
-    blockBegin += blockSize;
-    blockEnd = blockBegin + blockSize;
-    if (blockBegin >= end) break;
-    if (blockEnd > end) blockEnd = end;
-  }
+  thread_pool::instance().run(
+    begin, end, end - begin > grainsize ? grainsize : 1,
+    [](const void *ctx, size_t b, size_t e) {
+      trace_scope trace("parallel_for", "chunk", int64_t(b), int64_t(e));
+      (*static_cast<const Func *>(ctx))(blocked_range(b, e));
+    },
+    &f);
+}
 
-  for (auto &future : futures) future.wait();
+/**
+ * set the number of threads used by parallel_for, including the calling
+ * thread. 0 means std::thread::hardware_concurrency().
+ * must not be called while another thread is inside parallel_for.
+ **/
+inline void set_num_threads(size_t num_threads) {
+  thread_pool::instance().resize(num_threads);
 }
 
+inline size_t num_threads() { return thread_pool::instance().num_threads(); }
+
 #endif
 
 #endif  // CNN_USE_TBB
 
+#if defined(CNN_USE_TBB) || defined(CNN_USE_OMP) || defined(CNN_USE_GCD) || \
+  defined(CNN_SINGLE_THREAD)
+// upper bound of the number of tasks parallel_for runs at the same time
+inline size_t num_threads() {
+#ifdef CNN_SINGLE_THREAD
+  return 1;
+#else
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+#endif
+}
+#endif
+
 template <typename T, typename U>
 bool value_representation(U const &value) {
   return static_cast<U>(static_cast<T>(value)) == value;
@@ -203,8 +209,8 @@ inline void for_(
 template <typename T, typename Func>
 inline void for_i(bool parallelize, T size, Func f, size_t grainsize = 100) {
 #ifdef CNN_SINGLE_THREAD
-  for (size_t i = 0; i < size; ++i) {
-    f(i);
+  for (T i = 0; i < size; ++i) {
+    f(static_cast<size_t>(i));
   }
 #else  // #ifdef CNN_SINGLE_THREAD
   for_(parallelize, 0, size,
@@ -225,4 +231,46 @@ inline void for_i(T size, Func f, size_t grainsize = 100) {
   for_i(true, size, f, grainsize);
 }
 
+/**
+ * whether a kernel should also split the work inside each sample (output
+ * channels, rows, neurons...) between the threads. distributing samples
+ * alone leaves threads idle when there are fewer samples than threads,
+ * e.g. for a single prediction. the samples are then processed one after
+ * the other.
+ **/
+inline bool parallelize_within_samples(bool parallelize, size_t sample_count) {
+  return parallelize && sample_count < num_threads();
+}
+
+/**
+ * grain size cutting size units into one range per thread, but into no
+ * ranges smaller than min_grain
+ **/
+inline size_t split_grain(size_t size, size_t min_grain) {
+  const size_t threads = num_threads();
+  return std::max(min_grain, (size + threads - 1) / threads);
+}
+
+/**
+ * call f(i, slot) for every i in [0, size). the range is cut into
+ * slot_count contiguous chunks which are processed serially, one task per
+ * chunk, so that f can accumulate into a buffer owned by its slot without
+ * any synchronization.
+ **/
+template <typename Func>
+inline void for_i_slots(bool parallelize,
+                        size_t size,
+                        size_t slot_count,
+                        Func f) {
+  for_i(parallelize, slot_count,
+        [&](size_t slot) {
+          const size_t begin = size * slot / slot_count;
+          const size_t end   = size * (slot + 1) / slot_count;
+          for (size_t i = begin; i < end; i++) {
+            f(i, slot);
+          }
+        },
+        1);
+}
+
 }  // namespace tiny_dnn
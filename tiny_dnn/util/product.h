@@ -38,6 +38,10 @@ struct scalar_generic {
                                            const register_type &v2) {
     return v1 + v2;
   }
+  static CNN_MUST_INLINE register_type max(const register_type &v1,
+                                           const register_type &v2) {
+    return v2 < v1 ? v1 : v2;
+  }
   static CNN_MUST_INLINE register_type madd(const register_type &v1,
                                             const register_type &v2,
                                             const register_type &v3) {
@@ -78,6 +82,10 @@ struct float_sse {
                                            const register_type &v2) {
     return _mm_add_ps(v1, v2);
   }
+  static CNN_MUST_INLINE register_type max(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm_max_ps(v1, v2);
+  }
   static CNN_MUST_INLINE register_type madd(const register_type &v1,
                                             const register_type &v2,
                                             const register_type &v3) {
@@ -136,6 +144,10 @@ struct double_sse {
                                            const register_type &v2) {
     return _mm_add_pd(v1, v2);
   }
+  static CNN_MUST_INLINE register_type max(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm_max_pd(v1, v2);
+  }
   static CNN_MUST_INLINE register_type madd(const register_type &v1,
                                             const register_type &v2,
                                             const register_type &v3) {
@@ -199,6 +211,10 @@ struct float_avx {
                                            const register_type &v2) {
     return _mm256_add_ps(v1, v2);
   }
+  static CNN_MUST_INLINE register_type max(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm256_max_ps(v1, v2);
+  }
 #ifdef CNN_USE_AVX2
   static CNN_MUST_INLINE register_type madd(const register_type &v1,
                                             const register_type &v2,
@@ -263,6 +279,10 @@ struct double_avx {
                                            const register_type &v2) {
     return _mm256_add_pd(v1, v2);
   }
+  static CNN_MUST_INLINE register_type max(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm256_max_pd(v1, v2);
+  }
 #ifdef CNN_USE_AVX2
   static CNN_MUST_INLINE register_type madd(const register_type &v1,
                                             const register_type &v2,
@@ -567,49 +587,42 @@ CNN_MUST_INLINE CNN_VECTORIZE_TYPE::register_type accumulate(
 CNN_MUST_INLINE CNN_VECTORIZE_TYPE::register_type accumulate(
   const float *start, const size_t &nblocks) {
 #endif
-  const size_t n4                      = nblocks / 4;
-  const size_t n2                      = (nblocks % 4) / 2;
-  const size_t n1                      = nblocks % 2;
-  CNN_VECTORIZE_TYPE::register_type v0 = CNN_VECTORIZE_TYPE::load<aligned>(
-    start + CNN_VECTORIZE_TYPE::unroll_size * 0);
-  CNN_VECTORIZE_TYPE::register_type v1 = CNN_VECTORIZE_TYPE::load<aligned>(
-    start + CNN_VECTORIZE_TYPE::unroll_size * 1);
-  CNN_VECTORIZE_TYPE::register_type v2 = CNN_VECTORIZE_TYPE::load<aligned>(
-    start + CNN_VECTORIZE_TYPE::unroll_size * 2);
-  CNN_VECTORIZE_TYPE::register_type v3 = CNN_VECTORIZE_TYPE::load<aligned>(
-    start + CNN_VECTORIZE_TYPE::unroll_size * 3);
+  const size_t n4                        = nblocks / 4;
+  const size_t n2                        = (nblocks % 4) / 2;
+  const size_t n1                        = nblocks % 2;
   CNN_VECTORIZE_TYPE::register_type sum0 = CNN_VECTORIZE_TYPE::zero();
   CNN_VECTORIZE_TYPE::register_type sum1 = CNN_VECTORIZE_TYPE::zero();
   CNN_VECTORIZE_TYPE::register_type sum2 = CNN_VECTORIZE_TYPE::zero();
   CNN_VECTORIZE_TYPE::register_type sum3 = CNN_VECTORIZE_TYPE::zero();
+  // no loads ahead of the current blocks, start + nblocks may be the end of
+  // the buffer
   for (size_t j = 0; j < n4; ++j) {
-    CNN_VECTORIZE_TYPE::register_type n0 = CNN_VECTORIZE_TYPE::load<aligned>(
-      start + CNN_VECTORIZE_TYPE::unroll_size * 4);
-    CNN_VECTORIZE_TYPE::register_type n1 = CNN_VECTORIZE_TYPE::load<aligned>(
-      start + CNN_VECTORIZE_TYPE::unroll_size * 5);
-    CNN_VECTORIZE_TYPE::register_type n2 = CNN_VECTORIZE_TYPE::load<aligned>(
-      start + CNN_VECTORIZE_TYPE::unroll_size * 6);
-    CNN_VECTORIZE_TYPE::register_type n3 = CNN_VECTORIZE_TYPE::load<aligned>(
-      start + CNN_VECTORIZE_TYPE::unroll_size * 7);
-    sum0 = CNN_VECTORIZE_TYPE::add(sum0, v0);
-    sum1 = CNN_VECTORIZE_TYPE::add(sum1, v1);
-    sum2 = CNN_VECTORIZE_TYPE::add(sum2, v2);
-    sum3 = CNN_VECTORIZE_TYPE::add(sum3, v3);
-    v0   = n0;
-    v1   = n1;
-    v2   = n2;
-    v3   = n3;
+    sum0 = CNN_VECTORIZE_TYPE::add(
+      sum0, CNN_VECTORIZE_TYPE::load<aligned>(
+              start + CNN_VECTORIZE_TYPE::unroll_size * 0));
+    sum1 = CNN_VECTORIZE_TYPE::add(
+      sum1, CNN_VECTORIZE_TYPE::load<aligned>(
+              start + CNN_VECTORIZE_TYPE::unroll_size * 1));
+    sum2 = CNN_VECTORIZE_TYPE::add(
+      sum2, CNN_VECTORIZE_TYPE::load<aligned>(
+              start + CNN_VECTORIZE_TYPE::unroll_size * 2));
+    sum3 = CNN_VECTORIZE_TYPE::add(
+      sum3, CNN_VECTORIZE_TYPE::load<aligned>(
+              start + CNN_VECTORIZE_TYPE::unroll_size * 3));
     start += CNN_VECTORIZE_TYPE::unroll_size * 4;
   }
   if (n2) {
-    sum0 = CNN_VECTORIZE_TYPE::add(sum0, v0);
-    sum1 = CNN_VECTORIZE_TYPE::add(sum1, v1);
+    sum0 = CNN_VECTORIZE_TYPE::add(
+      sum0, CNN_VECTORIZE_TYPE::load<aligned>(
+              start + CNN_VECTORIZE_TYPE::unroll_size * 0));
+    sum1 = CNN_VECTORIZE_TYPE::add(
+      sum1, CNN_VECTORIZE_TYPE::load<aligned>(
+              start + CNN_VECTORIZE_TYPE::unroll_size * 1));
     start += CNN_VECTORIZE_TYPE::unroll_size * 2;
   }
   if (n1) {
     sum2 = CNN_VECTORIZE_TYPE::add(
       sum2, CNN_VECTORIZE_TYPE::load<aligned>(start + 0));
-    start += CNN_VECTORIZE_TYPE::unroll_size * 1;
   }
   sum0 = CNN_VECTORIZE_TYPE::add(sum0, sum1);
   sum2 = CNN_VECTORIZE_TYPE::add(sum2, sum3);
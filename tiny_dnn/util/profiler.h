@@ -0,0 +1,242 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tiny_dnn/layers/layer.h"
+#include "tiny_dnn/util/aligned_allocator.h"
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+
+enum class profile_phase { forward = 0, backward = 1, update = 2 };
+
+inline const char *to_string(profile_phase phase) {
+  switch (phase) {
+    case profile_phase::forward: return "forward";
+    case profile_phase::backward: return "backward";
+    case profile_phase::update: return "update";
+    default: return "unknown";
+  }
+}
+
+/**
+ * records where the time of a network goes, layer by layer.
+ *
+ *     profiler prof;
+ *     net.set_profiler(&prof);
+ *     net.train<mse>(opt, x, y, 16, 1);
+ *     net.set_profiler(nullptr);
+ *     prof.print(std::cout);                // hottest layers first
+ *     std::ofstream("profile.json") << prof.to_json();
+ *
+ * every call of layer::forward(), layer::backward() and
+ * layer::update_weight() made by the network is timed. flops and bytes are
+ * estimates: forward() does layer::forward_flops() per sample and reads its
+ * inputs and weights and writes its outputs once. backward() is counted as
+ * twice forward() for layers with weights, once otherwise. allocations
+ * counts the heap allocations of aligned_allocator (i.e. of vec_t) during
+ * the calls; when branches of a graph run concurrently, they may be
+ * counted against each other.
+ **/
+class profiler {
+ public:
+  struct phase_stats {
+    phase_stats() : calls(0), seconds(0), flops(0), bytes(0), allocations(0) {}
+
+    size_t calls;
+    double seconds;
+    uint64_t flops;
+    uint64_t bytes;
+    uint64_t allocations;
+  };
+
+  struct layer_stats {
+    /** position of the layer in the order of the first calls */
+    size_t index;
+    std::string layer_type;
+    std::string engine;
+    phase_stats phases[3];
+
+    const phase_stats &operator[](profile_phase phase) const {
+      return phases[static_cast<int>(phase)];
+    }
+
+    double seconds() const {
+      return phases[0].seconds + phases[1].seconds + phases[2].seconds;
+    }
+  };
+
+  /**
+   * run f, which calls phase of l, and record it
+   **/
+  template <typename F>
+  void measure(layer &l, profile_phase phase, F f) {
+    const uint64_t allocations = aligned_heap_allocations().load();
+    const auto start           = clock::now();
+
+    f();
+
+    const double seconds =
+      std::chrono::duration<double>(clock::now() - start).count();
+    record(l, phase, seconds, aligned_heap_allocations().load() - allocations);
+  }
+
+  struct cost {
+    uint64_t flops;
+    uint64_t bytes;
+  };
+
+  /**
+   * estimated work of one call of phase of l on a batch of samples samples
+   **/
+  static cost estimate(const layer &l, profile_phase phase, uint64_t samples) {
+    uint64_t weights = 0;
+    for (const vec_t *w : l.weights()) weights += w->size();
+    const uint64_t io = uint64_t(l.in_data_size()) + l.out_data_size();
+
+    cost c = {0, 0};
+    switch (phase) {
+      case profile_phase::forward:
+        c.flops = samples * l.forward_flops();
+        c.bytes = samples * io + weights;
+        break;
+      case profile_phase::backward:
+        c.flops = samples * l.forward_flops() * (weights > 0 ? 2 : 1);
+        c.bytes = 2 * (samples * io + weights);
+        break;
+      case profile_phase::update:
+        c.flops = 2 * weights;
+        c.bytes = 3 * weights;  // weights read and written, gradients read
+        break;
+    }
+    c.bytes *= sizeof(float_t);
+    return c;
+  }
+
+  /**
+   * statistics of every layer, in the order of the first calls
+   **/
+  std::vector<layer_stats> layers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return layers_;
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    layers_.clear();
+    index_.clear();
+  }
+
+  /**
+   * print a table of the layers, the slowest first
+   **/
+  void print(std::ostream &os) const {
+    std::vector<layer_stats> rows = layers();
+    std::stable_sort(rows.begin(), rows.end(),
+                     [](const layer_stats &a, const layer_stats &b) {
+                       return a.seconds() > b.seconds();
+                     });
+    double total = 0;
+    for (const auto &r : rows) total += r.seconds();
+
+    os << std::left << std::setw(5) << "#" << std::setw(18) << "layer"
+       << std::setw(10) << "engine" << std::right << std::setw(8) << "calls"
+       << std::setw(12) << "fwd ms" << std::setw(12) << "bwd ms"
+       << std::setw(12) << "upd ms" << std::setw(8) << "%" << std::setw(10)
+       << "GFLOP/s" << std::setw(10) << "GB/s" << std::setw(8) << "allocs"
+       << "\n";
+    for (const auto &r : rows) {
+      uint64_t flops = 0, bytes = 0, allocations = 0;
+      for (const auto &p : r.phases) {
+        flops += p.flops;
+        bytes += p.bytes;
+        allocations += p.allocations;
+      }
+      const double s = r.seconds();
+      os << std::left << std::setw(5) << r.index << std::setw(18)
+         << r.layer_type << std::setw(10) << r.engine << std::right
+         << std::setw(8) << r.phases[0].calls << std::fixed
+         << std::setprecision(3) << std::setw(12)
+         << r.phases[0].seconds * 1e3 << std::setw(12)
+         << r.phases[1].seconds * 1e3 << std::setw(12)
+         << r.phases[2].seconds * 1e3 << std::setprecision(1) << std::setw(8)
+         << (total > 0 ? 100 * s / total : 0.0) << std::setprecision(2)
+         << std::setw(10) << (s > 0 ? flops / s * 1e-9 : 0.0)
+         << std::setw(10) << (s > 0 ? bytes / s * 1e-9 : 0.0) << std::setw(8)
+         << allocations << "\n";
+    }
+    os.unsetf(std::ios::floatfield);
+  }
+
+  std::string to_json() const {
+    std::vector<layer_stats> rows = layers();
+    std::ostringstream os;
+    os << "{\"layers\":[";
+    for (size_t i = 0; i < rows.size(); i++) {
+      const layer_stats &r = rows[i];
+      os << (i ? "," : "") << "{\"index\":" << r.index << ",\"type\":\""
+         << r.layer_type << "\",\"engine\":\"" << r.engine << "\"";
+      for (int p = 0; p < 3; p++) {
+        const phase_stats &s = r.phases[p];
+        os << ",\"" << to_string(static_cast<profile_phase>(p)) << "\":{"
+           << "\"calls\":" << s.calls << ",\"seconds\":" << std::scientific
+           << std::setprecision(6) << s.seconds << std::defaultfloat
+           << ",\"flops\":" << s.flops << ",\"bytes\":" << s.bytes
+           << ",\"allocations\":" << s.allocations << "}";
+      }
+      os << "}";
+    }
+    os << "]}";
+    return os.str();
+  }
+
+ private:
+  typedef std::chrono::steady_clock clock;
+
+  void record(layer &l,
+              profile_phase phase,
+              double seconds,
+              uint64_t allocations) {
+    const uint64_t samples =
+      l.in_channels() > 0 ? l.inputs()[0]->get_data()->size() : 0;
+    const cost c = estimate(l, phase, samples);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(&l);
+    if (it == index_.end()) {
+      it = index_.emplace(&l, layers_.size()).first;
+      layers_.emplace_back();
+      layers_.back().index      = it->second;
+      layers_.back().layer_type = l.layer_type();
+      layers_.back().engine     = to_string(l.engine());
+    }
+    phase_stats &s = layers_[it->second].phases[static_cast<int>(phase)];
+    s.calls++;
+    s.seconds += seconds;
+    s.flops += c.flops;
+    s.bytes += c.bytes;
+    s.allocations += allocations;
+  }
+
+  mutable std::mutex mutex_;
+  std::unordered_map<const layer *, size_t> index_;
+  std::vector<layer_stats> layers_;
+};
+
+}  // namespace tiny_dnn
@@ -7,9 +7,41 @@
 */
 #pragma once
 
+#include <cstring>
+
 #include <cereal/access.hpp>  // For LoadAndConstruct
 #include "tiny_dnn/tiny_dnn.h"
 
+namespace tiny_dnn {
+namespace detail {
+
+// loads a field added to the archive of its layer in model format version
+// since (see nodes::save_model). older archives don't have it, which leaves
+// value as it is: binary ones are told by their version, JSON ones by the
+// name of the next node.
+template <class Archive, class T>
+void load_if_present(Archive &ar,
+                     std::uint32_t since,
+                     const char *name,
+                     T &value) {
+  if (loading_model_format() >= since) ar(cereal::make_nvp(name, value));
+}
+
+template <class T>
+void load_if_present(cereal::JSONInputArchive &ar,
+                     std::uint32_t since,
+                     const char *name,
+                     T &value) {
+  CNN_UNREFERENCED_PARAMETER(since);
+  const char *next = ar.getNodeName();
+  if (next != nullptr && std::strcmp(next, name) == 0) {
+    ar(cereal::make_nvp(name, value));
+  }
+}
+
+}  // namespace detail
+}  // namespace tiny_dnn
+
 namespace cereal {
 
 template <>
@@ -104,6 +136,7 @@ struct LoadAndConstruct<tiny_dnn::convolutional_layer> {
       Archive &ar,
       cereal::construct<tiny_dnn::convolutional_layer> &construct) {
     tiny_dnn::serial_size_t w_width, w_height, out_ch, w_stride, h_stride;
+    tiny_dnn::serial_size_t groups = 1;
     bool has_bias;
     tiny_dnn::shape3d in;
     tiny_dnn::padding pad_type;
@@ -118,9 +151,15 @@ struct LoadAndConstruct<tiny_dnn::convolutional_layer> {
        cereal::make_nvp("has_bias", has_bias),
        cereal::make_nvp("w_stride", w_stride),
        cereal::make_nvp("h_stride", h_stride));
-
-    construct(in.width_, in.height_, w_width, w_height, in.depth_, out_ch, tbl,
-              pad_type, has_bias, w_stride, h_stride);
+    tiny_dnn::detail::load_if_present(ar, 1, "groups", groups);
+
+    if (groups == 1) {
+      construct(in.width_, in.height_, w_width, w_height, in.depth_, out_ch,
+                tbl, pad_type, has_bias, w_stride, h_stride);
+    } else {
+      construct(in.width_, in.height_, w_width, w_height, in.depth_, out_ch,
+                groups, pad_type, has_bias, w_stride, h_stride);
+    }
   }
 };
 
@@ -602,7 +641,8 @@ struct serialization_buddy {
        cereal::make_nvp("pad_type", params_.pad_type),
        cereal::make_nvp("has_bias", params_.has_bias),
        cereal::make_nvp("w_stride", params_.w_stride),
-       cereal::make_nvp("h_stride", params_.h_stride));
+       cereal::make_nvp("h_stride", params_.h_stride),
+       cereal::make_nvp("groups", params_.groups));
   }
 
   template <class Archive>
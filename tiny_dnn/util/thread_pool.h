@@ -0,0 +1,282 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tiny_dnn {
+
+/**
+ * pool of persistent worker threads with work stealing.
+ *
+ * This is the default backend of parallel_for when neither TBB, OMP nor GCD
+ * is enabled. Threads are created once and reused, instead of spawning
+ * new threads on every call.
+ *
+ * Each worker owns a task deque. The owner pops from the back, idle workers
+ * steal from the front of the other deques. The thread calling run() takes
+ * part in the computation until all chunks of its range are done, so nested
+ * calls (e.g. for_i inside for_i) never block on each other. A caller from
+ * outside the pool only helps with the chunks of its own run(), so it is not
+ * held up by the chunks of unrelated callers.
+ **/
+class thread_pool {
+ public:
+  typedef void (*range_func)(const void *ctx, size_t begin, size_t end);
+
+  /**
+   * @param num_threads total number of threads including the caller of run().
+   *                    0 means std::thread::hardware_concurrency().
+   **/
+  explicit thread_pool(size_t num_threads = 0) : stop_(false), pending_(0) {
+    start(num_threads);
+  }
+
+  ~thread_pool() { stop(); }
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  /**
+   * process-wide pool used by parallel_for
+   **/
+  static thread_pool &instance() {
+    static thread_pool pool;
+    return pool;
+  }
+
+  /**
+   * number of threads taking part in run(), including the caller
+   **/
+  size_t num_threads() const { return workers_.size() + 1; }
+
+  /**
+   * re-create workers with the given number of threads.
+   * must not be called while another thread is inside run().
+   **/
+  void resize(size_t num_threads) {
+    stop();
+    start(num_threads);
+  }
+
+  /**
+   * split [begin, end) into chunks of at least grainsize elements and
+   * call f(ctx, chunk_begin, chunk_end) for each of them in parallel.
+   * returns after all chunks are done. the first exception thrown by f
+   * is rethrown to the caller.
+   **/
+  void run(size_t begin,
+           size_t end,
+           size_t grainsize,
+           range_func f,
+           const void *ctx) {
+    if (end <= begin) return;
+
+    const size_t count = end - begin;
+    // keep a few chunks per thread so that stealing can balance the load
+    const size_t max_chunks = num_threads() * chunks_per_thread;
+    const size_t block      = std::max(std::max(grainsize, size_t(1)),
+                                  (count + max_chunks - 1) / max_chunks);
+    const size_t chunks = (count + block - 1) / block;
+
+    if (chunks <= 1 || workers_.empty()) {
+      f(ctx, begin, end);
+      return;
+    }
+
+    job_state job(chunks);
+
+    // the calling thread runs the first chunk itself
+    push_range(begin + block, end, block, f, ctx, &job);
+    execute(task{f, ctx, begin, begin + block, &job});
+
+    wait(job);
+
+    if (job.error) std::rethrow_exception(job.error);
+  }
+
+ private:
+  static const size_t chunks_per_thread = 4;
+
+  struct job_state {
+    explicit job_state(size_t n) : remaining(n) {}
+    std::atomic<size_t> remaining;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+  };
+
+  struct task {
+    range_func f;
+    const void *ctx;
+    size_t begin;
+    size_t end;
+    job_state *job;
+  };
+
+  struct task_queue {
+    std::mutex mutex;
+    std::deque<task> tasks;
+  };
+
+  struct worker_id {
+    const thread_pool *pool;
+    size_t index;
+  };
+
+  static worker_id &current_worker() {
+    static thread_local worker_id id = {nullptr, 0};
+    return id;
+  }
+
+  void start(size_t num_threads) {
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 1;
+
+    const size_t num_workers = num_threads - 1;
+    queues_.clear();
+    for (size_t i = 0; i < num_workers; i++) {
+      queues_.emplace_back(new task_queue());
+    }
+    for (size_t i = 0; i < num_workers; i++) {
+      workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &w : workers_) w.join();
+    workers_.clear();
+    stop_ = false;
+  }
+
+  void push_range(size_t begin,
+                  size_t end,
+                  size_t block,
+                  range_func f,
+                  const void *ctx,
+                  job_state *job) {
+    const worker_id &self = current_worker();
+    const bool is_worker  = self.pool == this;
+
+    // workers keep nested work in their own deque; external callers spread
+    // the chunks over all deques to reduce contention on a single lock.
+    size_t q = is_worker ? self.index : 0;
+    for (size_t b = begin; b < end; b += block) {
+      task t{f, ctx, b, std::min(b + block, end), job};
+      {
+        std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+        queues_[q]->tasks.push_back(t);
+        pending_++;
+      }
+      if (!is_worker) q = (q + 1) % queues_.size();
+    }
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    cv_.notify_all();
+  }
+
+  /**
+   * pops a task to run on the calling thread. if only is given, only
+   * tasks of that job are taken.
+   **/
+  bool try_pop(task &t, const job_state *only = nullptr) {
+    const worker_id &self = current_worker();
+    const size_t nqueues  = queues_.size();
+    size_t first          = 0;
+
+    if (self.pool == this) {
+      task_queue &own = *queues_[self.index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.tasks.empty()) {
+        t = own.tasks.back();
+        own.tasks.pop_back();
+        pending_--;
+        return true;
+      }
+      first = self.index + 1;
+    }
+
+    for (size_t i = 0; i < nqueues; i++) {
+      task_queue &victim = *queues_[(first + i) % nqueues];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      auto it = victim.tasks.begin();
+      if (only) {
+        while (it != victim.tasks.end() && it->job != only) ++it;
+      }
+      if (it != victim.tasks.end()) {
+        t = *it;
+        victim.tasks.erase(it);
+        pending_--;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void execute(const task &t) {
+    try {
+      t.f(t.ctx, t.begin, t.end);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(t.job->error_mutex);
+      if (!t.job->error) t.job->error = std::current_exception();
+    }
+    // the job may be destroyed by its owner right after this point
+    t.job->remaining.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  void wait(const job_state &job) {
+    // workers keep helping with any task as in worker_loop, external
+    // callers stick to their own job.
+    const job_state *only = current_worker().pool == this ? nullptr : &job;
+    task t;
+    while (job.remaining.load(std::memory_order_acquire) != 0) {
+      if (try_pop(t, only)) {
+        execute(t);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void worker_loop(size_t index) {
+    current_worker() = worker_id{this, index};
+
+    task t;
+    for (;;) {
+      if (try_pop(t)) {
+        execute(t);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      cv_.wait(lock, [this] { return stop_ || pending_.load() > 0; });
+      if (stop_) return;
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::vector<std::unique_ptr<task_queue>> queues_;
+  std::mutex sleep_mutex_;
+  std::condition_variable cv_;
+  bool stop_;
+  std::atomic<size_t> pending_;
+};
+
+}  // namespace tiny_dnn
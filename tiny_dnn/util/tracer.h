@@ -0,0 +1,249 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tiny_dnn {
+
+/**
+ * timeline of what each thread is doing, written in the Chrome trace event
+ * format (chrome://tracing, https://ui.perfetto.dev).
+ *
+ *     tracer::instance().start();
+ *     net.predict(x);
+ *     tracer::instance().stop();
+ *     std::ofstream("trace.json") << tracer::instance().to_json();
+ *
+ * while it runs, the network records the forward, backward and weight
+ * update of each layer, and the thread pool of parallel_for each chunk it
+ * runs with its range (with TBB, OpenMP or GCD chunks aren't recorded).
+ * other code can add events with trace_scope.
+ *
+ * every thread writes into a ring buffer of its own without locking; when
+ * a buffer is full the oldest events of the thread are overwritten.
+ * start() and to_json() must not be called while traced work is running.
+ **/
+class tracer {
+ public:
+  typedef std::chrono::steady_clock clock;
+  typedef clock::time_point clock_time;
+
+  struct event {
+    char name[48];
+    char category[16];
+    uint64_t begin_ns;  // since start()
+    uint64_t end_ns;
+    int64_t arg0;  // -1 if unused
+    int64_t arg1;
+  };
+
+  static tracer &instance() {
+    static tracer t;
+    return t;
+  }
+
+  /**
+   * drop the recorded events and start recording
+   *
+   * @param events_per_thread capacity of the ring buffer of each thread
+   **/
+  void start(size_t events_per_thread = 65536) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.clear();
+    capacity_ = std::max<size_t>(1, events_per_thread);
+    epoch_    = clock::now();
+    generation_++;
+    enabled_.store(true, std::memory_order_release);
+  }
+
+  void stop() { enabled_.store(false, std::memory_order_release); }
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * add an event of the calling thread which ran from begin to end
+   **/
+  void record(const char *category,
+              const char *name,
+              clock_time begin,
+              clock_time end,
+              int64_t arg0 = -1,
+              int64_t arg1 = -1) {
+    thread_buffer *buf = buffer();
+    if (!buf) return;
+
+    const uint64_t n = buf->written.load(std::memory_order_relaxed);
+    event &e         = buf->events[n % buf->events.size()];
+    copy_name(e.name, name, sizeof(e.name));
+    copy_name(e.category, category, sizeof(e.category));
+    e.begin_ns = since_epoch(begin);
+    e.end_ns   = since_epoch(end);
+    e.arg0     = arg0;
+    e.arg1     = arg1;
+    buf->written.store(n + 1, std::memory_order_release);
+  }
+
+  /**
+   * events of every thread: thread id and event, oldest first per thread
+   **/
+  std::vector<std::pair<size_t, event>> events() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<size_t, event>> all;
+    for (const auto &buf : buffers_) {
+      const uint64_t written  = buf->written.load(std::memory_order_acquire);
+      const uint64_t capacity = buf->events.size();
+      const uint64_t first    = written > capacity ? written - capacity : 0;
+      for (uint64_t i = first; i < written; i++) {
+        all.emplace_back(buf->tid, buf->events[i % capacity]);
+      }
+    }
+    return all;
+  }
+
+  /**
+   * events lost because a ring buffer was full
+   **/
+  uint64_t dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t n = 0;
+    for (const auto &buf : buffers_) {
+      const uint64_t written = buf->written.load(std::memory_order_acquire);
+      if (written > buf->events.size()) n += written - buf->events.size();
+    }
+    return n;
+  }
+
+  /**
+   * the events as a Chrome trace (complete events, times in microseconds)
+   **/
+  std::string to_json() const {
+    std::ostringstream os;
+    os.precision(3);
+    os << std::fixed << "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto &te : events()) {
+      const event &e = te.second;
+      os << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"cat\":\""
+         << e.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << te.first
+         << ",\"ts\":" << e.begin_ns * 1e-3
+         << ",\"dur\":" << (e.end_ns - e.begin_ns) * 1e-3;
+      if (e.arg0 >= 0) {
+        os << ",\"args\":{\"begin\":" << e.arg0 << ",\"end\":" << e.arg1
+           << "}";
+      }
+      os << "}";
+      first = false;
+    }
+    os << "],\"displayTimeUnit\":\"ns\"}";
+    return os.str();
+  }
+
+ private:
+  struct thread_buffer {
+    thread_buffer(size_t tid, size_t capacity)
+      : tid(tid), events(capacity), written(0) {}
+
+    size_t tid;
+    std::vector<event> events;
+    std::atomic<uint64_t> written;
+  };
+
+  struct thread_state {
+    uint64_t generation = 0;
+    std::shared_ptr<thread_buffer> buffer;
+  };
+
+  tracer() : enabled_(false), capacity_(1), generation_(0) {}
+
+  // ring buffer of the calling thread for the current start(), if recording
+  thread_buffer *buffer() {
+    static thread_local thread_state state;
+    if (state.generation != generation_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!enabled()) return nullptr;
+      state.buffer =
+        std::make_shared<thread_buffer>(buffers_.size(), capacity_);
+      state.generation = generation_;
+      buffers_.push_back(state.buffer);
+    }
+    return state.buffer.get();
+  }
+
+  uint64_t since_epoch(clock_time t) const {
+    if (t < epoch_) return 0;
+    return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(t - epoch_)
+        .count());
+  }
+
+  // copy and escape for json, truncated to size - 1 characters
+  static void copy_name(char *dst, const char *src, size_t size) {
+    size_t n = 0;
+    for (; *src && n + 1 < size; src++) {
+      dst[n++] = (*src == '"' || *src == '\\') ? '_' : *src;
+    }
+    dst[n] = '\0';
+  }
+
+  std::atomic<bool> enabled_;
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<thread_buffer>> buffers_;
+  size_t capacity_;
+  clock_time epoch_;
+  std::atomic<uint64_t> generation_;
+};
+
+/**
+ * records the lifetime of the scope as an event of the calling thread,
+ * if the tracer is running
+ **/
+class trace_scope {
+ public:
+  trace_scope(const char *category,
+              const char *name,
+              int64_t arg0 = -1,
+              int64_t arg1 = -1)
+    : active_(tracer::instance().enabled()),
+      category_(category),
+      name_(name),
+      arg0_(arg0),
+      arg1_(arg1) {
+    if (active_) begin_ = tracer::clock::now();
+  }
+
+  ~trace_scope() {
+    if (active_) {
+      tracer::instance().record(category_, name_, begin_,
+                                tracer::clock::now(), arg0_, arg1_);
+    }
+  }
+
+  trace_scope(const trace_scope &) = delete;
+  trace_scope &operator=(const trace_scope &) = delete;
+
+ private:
+  bool active_;
+  const char *category_;
+  const char *name_;
+  int64_t arg0_;
+  int64_t arg1_;
+  tracer::clock_time begin_;
+};
+
+}  // namespace tiny_dnn
@@ -7,6 +7,7 @@
 */
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <cstdio>
@@ -179,6 +180,45 @@ struct index3d {
 
 typedef index3d<serial_size_t> shape3d;
 
+/**
+ * channel-blocked layout of the activations of one sample: the channels are
+ * split into blocks of `block` channels (the last one may be narrower), and
+ * each block is stored pixel by pixel with its channels next to each other.
+ * block 1 is the planar layout of index3d::get_index, 8 and 16 are nChw8c
+ * and nChw16c, and a block of at least depth_ channels is HWC.
+ **/
+inline serial_size_t blocked_index(const shape3d &s,
+                                   serial_size_t block,
+                                   serial_size_t x,
+                                   serial_size_t y,
+                                   serial_size_t channel) {
+  assert(x < s.width_ && y < s.height_ && channel < s.depth_);
+  const serial_size_t first = channel / block * block;
+  const serial_size_t width = std::min(block, s.depth_ - first);
+  return first * s.area() + (y * s.width_ + x) * width + channel - first;
+}
+
+/**
+ * number of channels of the block starting at channel first, which is a
+ * multiple of block
+ **/
+inline serial_size_t block_width(const shape3d &s,
+                                 serial_size_t block,
+                                 serial_size_t first) {
+  return std::min(block, s.depth_ - first);
+}
+
+/**
+ * whether blocks a and b store the activations of shape s in the same order:
+ * a single channel or a single pixel is laid out the same way by every block
+ **/
+inline bool same_blocked_layout(const shape3d &s,
+                                serial_size_t a,
+                                serial_size_t b) {
+  return a == b || s.depth_ <= 1 || s.area() <= 1 ||
+         (a >= s.depth_ && b >= s.depth_);
+}
+
 template <typename T>
 bool operator==(const index3d<T> &lhs, const index3d<T> &rhs) {
   return (lhs.width_ == rhs.width_) && (lhs.height_ == rhs.height_) &&
@@ -322,6 +362,61 @@ inline void fill_tensor(tensor_t &tensor, float_t value, serial_size_t size) {
   }
 }
 
+/**
+ * distance in elements between two consecutive samples of a batch stored
+ * contiguously. each sample starts on a 64-byte boundary.
+ **/
+inline size_t batch_stride(size_t dim) {
+  const size_t align = 64 / sizeof(float_t);
+  return (dim + align - 1) / align * align;
+}
+
+/**
+ * true if every sample of tensor has the same length and sample i starts at
+ * &tensor[0][0] + i * batch_stride(tensor[0].size()), i.e. the whole batch
+ * can be handed to a kernel as a single strided matrix.
+ **/
+inline bool is_contiguous_batch(const tensor_t &tensor) {
+  if (tensor.empty()) return false;
+  const size_t dim    = tensor[0].size();
+  const size_t stride = batch_stride(dim);
+  for (size_t i = 0; i < tensor.size(); i++) {
+    if (tensor[i].size() != dim ||
+        tensor[i].data() != tensor[0].data() + i * stride) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * resize tensor to sample_count samples, all stored in one aligned buffer
+ * (see is_contiguous_batch). existing samples are kept and new ones are
+ * copies of the first sample. shrinking a contiguous batch only drops the
+ * trailing samples and doesn't reallocate.
+ **/
+inline void resize_batch(tensor_t &tensor, size_t sample_count) {
+  typedef vec_t::allocator_type allocator;
+
+  assert(!tensor.empty());
+  if (sample_count <= tensor.size() && is_contiguous_batch(tensor)) {
+    tensor.resize(sample_count);
+    return;
+  }
+
+  const size_t stride = batch_stride(tensor[0].size());
+  auto block          = allocator::make_block(stride * sample_count);
+
+  tensor_t batch;
+  batch.reserve(sample_count);
+  for (size_t i = 0; i < sample_count; i++) {
+    const vec_t &src = tensor[i < tensor.size() ? i : 0];
+    batch.emplace_back(src.begin(), src.end(),
+                       allocator::bind(block, i * stride, stride));
+  }
+  tensor.swap(batch);
+}
+
 inline serial_size_t conv_out_length(serial_size_t in_length,
                                      serial_size_t window_size,
                                      serial_size_t stride,
@@ -0,0 +1,302 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "tiny_dnn/layers/layer.h"
+#include "tiny_dnn/util/nn_error.h"
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+
+/**
+ * how load_weights_file() maps the weights
+ **/
+enum class weights_map_mode {
+  copy_on_write,  ///< weights can be modified; touched pages become private
+  read_only       ///< weights are read-only views of the file (inference)
+};
+
+/*
+ * memory-mappable weights file.
+ *
+ * all fields are little-endian. the file starts with a 64 byte header,
+ * followed by one table entry per weight vector, followed by the weights
+ * themselves. every weight vector starts at an offset which is a multiple
+ * of 64, so it can be used in place with the alignment of vec_t.
+ *
+ *   header: magic "TDNNWTS\0", version, sizeof(float_t), entry count,
+ *           file size
+ *   entry:  layer index, weight index in layer::weights(), element count,
+ *           byte offset of the data
+ */
+namespace weights_file_detail {
+
+static const char weights_file_magic[8] = {'T', 'D', 'N', 'N',
+                                           'W', 'T', 'S', '\0'};
+static const uint32_t weights_file_version = 1;
+static const uint64_t weights_file_align   = 64;
+
+struct header {
+  char magic[8];
+  uint32_t version;
+  uint32_t float_size;
+  uint64_t entry_count;
+  uint64_t file_size;
+  uint8_t reserved[32];
+};
+
+struct entry {
+  uint32_t layer;
+  uint32_t index;
+  uint64_t size;
+  uint64_t offset;
+};
+
+static_assert(sizeof(header) == 64, "unexpected padding in weights header");
+static_assert(sizeof(entry) == 24, "unexpected padding in weights entry");
+
+inline uint64_t align_up(uint64_t offset) {
+  return (offset + weights_file_align - 1) / weights_file_align *
+         weights_file_align;
+}
+
+// read-only or private view of a whole file, unmapped when the last owner
+// of the returned block goes away
+inline std::shared_ptr<float_t> map_file(const std::string &filename,
+                                         weights_map_mode mode,
+                                         uint64_t *size) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw nn_error("failed to open:" + filename);
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+    CloseHandle(file);
+    throw nn_error("failed to map:" + filename);
+  }
+  const bool writable = mode == weights_map_mode::copy_on_write;
+  HANDLE mapping      = CreateFileMappingA(
+    file, nullptr, writable ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!mapping) throw nn_error("failed to map:" + filename);
+  void *p = MapViewOfFile(mapping, writable ? FILE_MAP_COPY : FILE_MAP_READ,
+                          0, 0, 0);
+  CloseHandle(mapping);
+  if (!p) throw nn_error("failed to map:" + filename);
+
+  *size = static_cast<uint64_t>(file_size.QuadPart);
+  return std::shared_ptr<float_t>(static_cast<float_t *>(p),
+                                  [](float_t *ptr) { UnmapViewOfFile(ptr); });
+#else
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) throw nn_error("failed to open:" + filename);
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    throw nn_error("failed to map:" + filename);
+  }
+  const size_t length = static_cast<size_t>(st.st_size);
+  const int prot      = mode == weights_map_mode::copy_on_write
+                     ? PROT_READ | PROT_WRITE
+                     : PROT_READ;
+  void *p = ::mmap(nullptr, length, prot, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) throw nn_error("failed to map:" + filename);
+
+  *size = static_cast<uint64_t>(length);
+  return std::shared_ptr<float_t>(
+    static_cast<float_t *>(p),
+    [length](float_t *ptr) { ::munmap(static_cast<void *>(ptr), length); });
+#endif
+}
+
+}  // namespace weights_file_detail
+
+/**
+ * write the weights of layers to filename in the memory-mappable format
+ * described above.
+ **/
+template <typename LayerIterator>
+void save_weights_file(const std::string &filename,
+                       LayerIterator first,
+                       LayerIterator last) {
+  using namespace weights_file_detail;
+
+  if (!is_little_endian()) {
+    throw nn_error("weights file is only supported on little-endian hosts");
+  }
+
+  std::vector<entry> entries;
+  std::vector<const vec_t *> data;
+  uint32_t layer_index = 0;
+  for (auto it = first; it != last; ++it, ++layer_index) {
+    const layer &l     = **it;
+    const auto weights = l.weights();
+    for (size_t i = 0; i < weights.size(); i++) {
+      entry e;
+      e.layer  = layer_index;
+      e.index  = static_cast<uint32_t>(i);
+      e.size   = weights[i]->size();
+      e.offset = 0;
+      entries.push_back(e);
+      data.push_back(weights[i]);
+    }
+  }
+
+  uint64_t offset = align_up(sizeof(header) + sizeof(entry) * entries.size());
+  for (auto &e : entries) {
+    e.offset = offset;
+    offset   = align_up(offset + e.size * sizeof(float_t));
+  }
+
+  header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, weights_file_magic, sizeof(h.magic));
+  h.version     = weights_file_version;
+  h.float_size  = sizeof(float_t);
+  h.entry_count = entries.size();
+  h.file_size   = offset;
+
+  std::ofstream ofs(filename.c_str(), std::ios::binary | std::ios::out);
+  if (ofs.fail() || ofs.bad()) throw nn_error("failed to open:" + filename);
+
+  const char zeros[weights_file_align] = {};
+  uint64_t pos                         = 0;
+  auto write = [&](const void *p, uint64_t bytes) {
+    ofs.write(static_cast<const char *>(p),
+              static_cast<std::streamsize>(bytes));
+    pos += bytes;
+  };
+  auto pad = [&](uint64_t to) { write(zeros, to - pos); };
+
+  write(&h, sizeof(h));
+  if (!entries.empty()) write(&entries[0], sizeof(entry) * entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    pad(entries[i].offset);
+    if (!data[i]->empty()) {
+      write(&(*data[i])[0], entries[i].size * sizeof(float_t));
+    }
+  }
+  pad(h.file_size);
+
+  if (ofs.fail() || ofs.bad()) throw nn_error("failed to write:" + filename);
+}
+
+/**
+ * map filename, written by save_weights_file(), and make the weights of
+ * layers point into the mapping instead of copying them. the file stays
+ * mapped as long as any layer still uses one of its weights.
+ *
+ * with weights_map_mode::copy_on_write (the default) the mapping is
+ * private: training may update the weights, and only the pages it touches
+ * are copied. the file itself is never modified.
+ * weights_map_mode::read_only shares the pages with the file and is meant
+ * for inference only: anything that writes to the weights afterwards
+ * (init_weight(), training, loading other weights into the layers) faults.
+ **/
+template <typename LayerIterator>
+void load_weights_file(
+  const std::string &filename,
+  LayerIterator first,
+  LayerIterator last,
+  weights_map_mode mode = weights_map_mode::copy_on_write) {
+  using namespace weights_file_detail;
+  typedef vec_t::allocator_type allocator;
+
+  if (!is_little_endian()) {
+    throw nn_error("weights file is only supported on little-endian hosts");
+  }
+
+  uint64_t file_size;
+  std::shared_ptr<float_t> block = map_file(filename, mode, &file_size);
+  const char *base               = reinterpret_cast<const char *>(block.get());
+
+  header h;
+  if (file_size < sizeof(h)) {
+    throw nn_error("invalid weights file:" + filename);
+  }
+  std::memcpy(&h, base, sizeof(h));
+  if (std::memcmp(h.magic, weights_file_magic, sizeof(h.magic)) != 0) {
+    throw nn_error("invalid weights file:" + filename);
+  }
+  if (h.version != weights_file_version) {
+    throw nn_error("unsupported weights file version " +
+                   std::to_string(h.version) + ":" + filename);
+  }
+  if (h.float_size != sizeof(float_t)) {
+    throw nn_error("float_t of weights file doesn't match:" + filename);
+  }
+  if (h.file_size != file_size ||
+      h.entry_count > (file_size - sizeof(h)) / sizeof(entry)) {
+    throw nn_error("truncated weights file:" + filename);
+  }
+
+  // expected size of every weight, checked before any layer is touched
+  std::vector<std::vector<size_t>> sizes;
+  std::vector<std::vector<vec_t>> weights;
+  for (auto it = first; it != last; ++it) {
+    const layer &l = **it;
+    sizes.emplace_back();
+    for (auto w : l.weights()) sizes.back().push_back(w->size());
+    weights.emplace_back(sizes.back().size());
+  }
+
+  for (uint64_t i = 0; i < h.entry_count; i++) {
+    entry e;
+    std::memcpy(&e, base + sizeof(h) + i * sizeof(entry), sizeof(e));
+    if (e.layer >= sizes.size() || e.index >= sizes[e.layer].size() ||
+        e.size != sizes[e.layer][e.index]) {
+      throw nn_error("weights file doesn't match the network:" + filename);
+    }
+    if (e.offset % weights_file_align != 0 || e.offset > file_size ||
+        e.size > (file_size - e.offset) / sizeof(float_t)) {
+      throw nn_error("invalid weights file:" + filename);
+    }
+    const size_t size = static_cast<size_t>(e.size);
+    weights[e.layer][e.index] =
+      vec_t(size, allocator::adopt(block, e.offset / sizeof(float_t), size));
+  }
+
+  for (size_t l = 0; l < sizes.size(); l++) {
+    for (size_t i = 0; i < sizes[l].size(); i++) {
+      if (weights[l][i].size() != sizes[l][i]) {
+        throw nn_error("weights file doesn't match the network:" + filename);
+      }
+    }
+  }
+
+  size_t layer_index = 0;
+  for (auto it = first; it != last; ++it, ++layer_index) {
+    (*it)->load_weights(std::move(weights[layer_index]));
+  }
+}
+
+}  // namespace tiny_dnn